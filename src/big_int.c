@@ -0,0 +1,236 @@
+/** @file
+  Implementacja biblioteki udostępniającej liczby całkowite dowolnej
+  wielkości.
+
+  @author Szymon Łukasik <sl428760@mimuw.students.edu.pl>
+  @date 2021
+*/
+
+#include <assert.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "big_int.h"
+#include "safe_alloc.h"
+
+/** Największa potęga dziesiątki mieszcząca się w słowie. */
+#define DECIMAL_BASE UINT64_C(10000000000000000000)
+
+/** Liczba cyfr dziesiętnych potęgi DECIMAL_BASE. */
+#define DECIMAL_DIGITS 19
+
+/**
+ * Zwraca rozmiar bloku pamięci liczby.
+ * @param[in] capacity : liczba słów
+ * @return rozmiar bloku w bajtach
+ */
+static inline size_t BigIntBlockSize(size_t capacity) {
+    return sizeof(BigInt) + capacity * sizeof(uint64_t);
+}
+
+/**
+ * Alokuje liczbę z jednym właścicielem i wyzerowanymi słowami.
+ * @param[in] capacity : liczba słów, dodatnia
+ * @return liczba równa zeru
+ */
+static BigInt *BigIntAlloc(size_t capacity) {
+    assert(capacity > 0);
+    BigInt *a = SafeAlloc(BigIntBlockSize(capacity));
+    atomic_init(&a->refs, 1);
+    a->size = 0;
+    a->capacity = capacity;
+    a->negative = false;
+    memset(a->words, 0, capacity * sizeof(uint64_t));
+    return a;
+}
+
+/**
+ * Pomija najstarsze zerowe słowa liczby. Zero nie ma znaku.
+ * @param[in, out] a : liczba, której rozmiar równy jest pojemności
+ * @return @p a
+ */
+static BigInt *BigIntNormalize(BigInt *a) {
+    while (a->size > 0 && a->words[a->size - 1] == 0)
+        a->size--;
+    if (a->size == 0)
+        a->negative = false;
+    return a;
+}
+
+BigInt *BigIntFromInt(int64_t value) {
+    BigInt *a = BigIntAlloc(1);
+    a->negative = value < 0;
+    a->words[0] = value < 0 ? 0 - (uint64_t) value : (uint64_t) value;
+    a->size = 1;
+    return BigIntNormalize(a);
+}
+
+BigInt *BigIntShare(BigInt *a) {
+    atomic_fetch_add_explicit(&a->refs, 1, memory_order_relaxed);
+    return a;
+}
+
+void BigIntDestroy(BigInt *a) {
+    if (atomic_fetch_sub_explicit(&a->refs, 1, memory_order_acq_rel) == 1)
+        SafeFree(a, BigIntBlockSize(a->capacity));
+}
+
+/**
+ * Porównuje moduły liczb.
+ * @param[in] a : liczba @f$a@f$
+ * @param[in] b : liczba @f$b@f$
+ * @return -1, 0 lub 1, gdy @f$|a|@f$ jest odpowiednio mniejszy, równy
+ *         lub większy od @f$|b|@f$
+ */
+static int MagnitudeCompare(const BigInt *a, const BigInt *b) {
+    if (a->size != b->size)
+        return a->size < b->size ? -1 : 1;
+    for (size_t i = a->size; i-- > 0;)
+        if (a->words[i] != b->words[i])
+            return a->words[i] < b->words[i] ? -1 : 1;
+    return 0;
+}
+
+BigInt *BigIntAdd(const BigInt *a, const BigInt *b) {
+    if (a->negative != b->negative) {
+        // Odejmujemy mniejszy moduł od większego, wynik ma znak większego.
+        if (MagnitudeCompare(a, b) < 0) {
+            const BigInt *temp = a;
+            a = b;
+            b = temp;
+        }
+
+        BigInt *res = BigIntAlloc(a->size);
+        uint64_t borrow = 0;
+        for (size_t i = 0; i < a->size; i++) {
+            uint64_t word = i < b->size ? b->words[i] : 0;
+            uint64_t diff = a->words[i] - word - borrow;
+            borrow = a->words[i] < word || (a->words[i] == word && borrow);
+            res->words[i] = diff;
+        }
+        res->size = a->size;
+        res->negative = a->negative;
+        return BigIntNormalize(res);
+    }
+
+    if (a->size < b->size) {
+        const BigInt *temp = a;
+        a = b;
+        b = temp;
+    }
+
+    BigInt *res = BigIntAlloc(a->size + 1);
+    uint64_t carry = 0;
+    for (size_t i = 0; i < a->size; i++) {
+        unsigned __int128 sum = (unsigned __int128) a->words[i] + carry
+                                + (i < b->size ? b->words[i] : 0);
+        res->words[i] = (uint64_t) sum;
+        carry = (uint64_t) (sum >> 64);
+    }
+    res->words[a->size] = carry;
+    res->size = a->size + 1;
+    res->negative = a->negative;
+    return BigIntNormalize(res);
+}
+
+BigInt *BigIntMul(const BigInt *a, const BigInt *b) {
+    if (a->size == 0 || b->size == 0)
+        return BigIntFromInt(0);
+
+    BigInt *res = BigIntAlloc(a->size + b->size);
+    for (size_t i = 0; i < a->size; i++) {
+        uint64_t carry = 0;
+        for (size_t j = 0; j < b->size; j++) {
+            unsigned __int128 product =
+                    (unsigned __int128) a->words[i] * b->words[j]
+                    + res->words[i + j] + carry;
+            res->words[i + j] = (uint64_t) product;
+            carry = (uint64_t) (product >> 64);
+        }
+        res->words[i + b->size] = carry;
+    }
+    res->size = a->size + b->size;
+    res->negative = a->negative != b->negative;
+    return BigIntNormalize(res);
+}
+
+bool BigIntToInt(const BigInt *a, int64_t *value) {
+    if (a->size == 0) {
+        *value = 0;
+        return true;
+    }
+    if (a->size > 1)
+        return false;
+
+    uint64_t word = a->words[0];
+    if (!a->negative && word <= (uint64_t) INT64_MAX) {
+        *value = (int64_t) word;
+        return true;
+    }
+    if (a->negative && word <= (uint64_t) INT64_MAX + 1) {
+        *value = (int64_t) (0 - word);
+        return true;
+    }
+    return false;
+}
+
+bool BigIntIsEq(const BigInt *a, const BigInt *b) {
+    return a->negative == b->negative && MagnitudeCompare(a, b) == 0;
+}
+
+uint64_t BigIntLowWord(const BigInt *a) {
+    uint64_t word = a->size == 0 ? 0 : a->words[0];
+    return a->negative ? 0 - word : word;
+}
+
+size_t BigIntBits(const BigInt *a) {
+    if (a->size == 0)
+        return 0;
+    return 64 * a->size - (size_t) __builtin_clzll(a->words[a->size - 1]);
+}
+
+uint64_t BigIntModWord(const BigInt *a, uint64_t mod) {
+    assert(mod > 0);
+    uint64_t rem = 0;
+    for (size_t i = a->size; i-- > 0;)
+        rem = (uint64_t) ((((unsigned __int128) rem << 64) | a->words[i])
+                          % mod);
+    return a->negative && rem != 0 ? mod - rem : rem;
+}
+
+void BigIntPrint(const BigInt *a) {
+    if (a->size == 0) {
+        printf("0");
+        return;
+    }
+
+    /* Dzielimy kopię modułu przez DECIMAL_BASE, zapisując kolejne reszty -
+     * grupy cyfr od najmłodszej. */
+    uint64_t *words = SafeCalloc(a->size, sizeof(uint64_t));
+    memcpy(words, a->words, a->size * sizeof(uint64_t));
+    // Każda grupa ma co najmniej 63 bity, a słowo 64 bity.
+    uint64_t *groups = SafeCalloc(a->size * 2, sizeof(uint64_t));
+    size_t size = a->size, count = 0;
+
+    while (size > 0) {
+        uint64_t rem = 0;
+        for (size_t i = size; i-- > 0;) {
+            unsigned __int128 value = ((unsigned __int128) rem << 64)
+                                      | words[i];
+            words[i] = (uint64_t) (value / DECIMAL_BASE);
+            rem = (uint64_t) (value % DECIMAL_BASE);
+        }
+        groups[count++] = rem;
+        while (size > 0 && words[size - 1] == 0)
+            size--;
+    }
+
+    printf("%s%" PRIu64, a->negative ? "-" : "", groups[count - 1]);
+    for (size_t i = count - 1; i-- > 0;)
+        printf("%0*" PRIu64, DECIMAL_DIGITS, groups[i]);
+
+    free(words);
+    free(groups);
+}
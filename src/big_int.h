@@ -0,0 +1,114 @@
+/** @file
+  Biblioteka udostępniająca liczby całkowite dowolnej wielkości, do których
+  dokładny tryb współczynników wielomianów (patrz PolySetExact) promuje
+  współczynniki niemieszczące się w typie poly_coeff_t.
+
+  Liczba zapisywana jest jako znak i moduł - tablica słów 64-bitowych od
+  najmłodszego. Liczby są niezmienne i współdzielone przez licznik
+  właścicieli, dlatego kopiowanie współczynnika nie kopiuje jego słów.
+
+  @author Szymon Łukasik <sl428760@mimuw.students.edu.pl>
+  @date 2021
+*/
+
+#ifndef __BIG_INT_H__
+#define __BIG_INT_H__
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * To jest struktura przechowująca liczbę całkowitą dowolnej wielkości.
+ * Słowa modułu znajdują się w tym samym bloku pamięci co struktura.
+ */
+typedef struct BigInt {
+    atomic_size_t refs; ///< liczba właścicieli liczby
+    size_t size; ///< liczba słów modułu, najstarsze słowo jest niezerowe
+    size_t capacity; ///< liczba słów, na które zaalokowano blok
+    bool negative; ///< czy liczba jest ujemna
+    uint64_t words[]; ///< słowa modułu od najmłodszego
+} BigInt;
+
+/**
+ * Tworzy liczbę równą liczbie 64-bitowej.
+ * @param[in] value : liczba
+ * @return liczba z jednym właścicielem
+ */
+BigInt *BigIntFromInt(int64_t value);
+
+/**
+ * Dodaje właściciela liczby.
+ * @param[in] a : liczba
+ * @return @p a
+ */
+BigInt *BigIntShare(BigInt *a);
+
+/**
+ * Usuwa właściciela liczby, a gdy był ostatni, zwalnia jej pamięć.
+ * @param[in] a : liczba
+ */
+void BigIntDestroy(BigInt *a);
+
+/**
+ * Dodaje dwie liczby.
+ * @param[in] a : liczba @f$a@f$
+ * @param[in] b : liczba @f$b@f$
+ * @return @f$a + b@f$ z jednym właścicielem
+ */
+BigInt *BigIntAdd(const BigInt *a, const BigInt *b);
+
+/**
+ * Mnoży dwie liczby.
+ * @param[in] a : liczba @f$a@f$
+ * @param[in] b : liczba @f$b@f$
+ * @return @f$a b@f$ z jednym właścicielem
+ */
+BigInt *BigIntMul(const BigInt *a, const BigInt *b);
+
+/**
+ * Sprawdza, czy liczba mieści się w 64 bitach ze znakiem.
+ * @param[in] a : liczba
+ * @param[out] value : wartość liczby, ustawiana, gdy się mieści
+ * @return Czy liczba mieści się w typie int64_t?
+ */
+bool BigIntToInt(const BigInt *a, int64_t *value);
+
+/**
+ * Sprawdza równość dwóch liczb.
+ * @param[in] a : liczba @f$a@f$
+ * @param[in] b : liczba @f$b@f$
+ * @return @f$a = b@f$
+ */
+bool BigIntIsEq(const BigInt *a, const BigInt *b);
+
+/**
+ * Zwraca liczbę modulo @f$2^{64}@f$.
+ * @param[in] a : liczba
+ * @return @f$a \bmod 2^{64}@f$
+ */
+uint64_t BigIntLowWord(const BigInt *a);
+
+/**
+ * Zwraca liczbę bitów modułu liczby.
+ * @param[in] a : liczba
+ * @return @f$\lceil \log_2 (|a| + 1) \rceil@f$
+ */
+size_t BigIntBits(const BigInt *a);
+
+/**
+ * Zwraca resztę z dzielenia liczby przez moduł.
+ * @param[in] a : liczba
+ * @param[in] mod : moduł, dodatni
+ * @return reszta z przedziału @f$[0, mod)@f$
+ */
+uint64_t BigIntModWord(const BigInt *a, uint64_t mod);
+
+/**
+ * Wypisuje liczbę dziesiętnie na standardowe wyjście.
+ * @param[in] a : liczba
+ */
+void BigIntPrint(const BigInt *a);
+
+#endif // __BIG_INT_H__
@@ -10,8 +10,12 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <errno.h>
+#include <string.h>
 #include "calc.h"
+#include "safe_alloc.h"
 #include "poly_stack.h"
+#include "poly_program.h"
+#include "poly_eq.h"
 #include "parsing.h"
 #include "limits.h"
 
@@ -28,14 +32,27 @@ static const CommandName PUSH_COMMANDS[8] =
         {ZERO, CLONE, ADD, MUL, NEG, SUB, AT, COMPOSE};
 
 /** Liczba obsługiwanych błędów wejścia. */
-static const size_t INPUT_ERR_NUM = 5;
+static const size_t INPUT_ERR_NUM = 12;
 
 /** Tablica stringów zawierająca nazwy błędów wyjścia.
  *  Kolejność nazw tych błędów w tablicy odpowiada kolejności ich
  *  występowania w definicji typu InputError. */
-static const string INPUT_ERR_NAMES[5] =
+static const string INPUT_ERR_NAMES[12] =
         {"WRONG COMMAND", "DEG BY WRONG VARIABLE",
-         "AT WRONG VALUE", "COMPOSE WRONG PARAMETER", "WRONG POLY"};
+         "AT WRONG VALUE", "COMPOSE WRONG PARAMETER",
+         "THREADS WRONG COUNT", "WRONG POLY", "MOD WRONG VALUE",
+         "EXACT WRONG VALUE", "AT POINTS WRONG VALUE", "EVAL WRONG VALUE",
+         "PROG EVAL WRONG VALUE", "EQ ERROR WRONG VALUE"};
+
+/** Program skompilowany ostatnim poleceniem COMPILE. Przed pierwszym
+ *  takim poleceniem jest to program wielomianu zerowego. */
+static PolyProgram program;
+
+/** Parametr ostatniego polecenia EQ_ERROR. Zero oznacza, że polecenie IS_EQ
+ *  porównuje wielomiany dokładnie, a liczba dodatnia @f$k@f$, że porównuje
+ *  je probabilistycznie z prawdopodobieństwem błędu co najwyżej
+ *  @f$2^{-k}@f$ (patrz PolyIsEqRandom). */
+static size_t eq_error = 0;
 
 
 /**
@@ -130,8 +147,11 @@ PolyStackBinaryOperation(Command command, PolyStack *stack, size_t line_nr,
             *res = PolyAdd(&a, &b);
         else if (command.name == MUL)
             *res = PolyMul(&a, &b);
-        else if (command.name == SUB)
-            *res = PolySub(&a, &b);
+        else if (command.name == SUB) {
+            // Wielomian b jest już nasz, więc negujemy go w miejscu.
+            PolyMulByCoeffInPlace(&b, -1);
+            *res = PolyAdd(&a, &b);
+        }
 
         PolyDestroy(&a);
         PolyDestroy(&b);
@@ -162,22 +182,47 @@ PolyStackUnaryOperation(Command command, PolyStack *stack, size_t line_nr,
                         Poly *res) {
     if (StackContains(1, *stack, line_nr)) {
         if (command.name == CLONE)
-            *res = PolyClone(PolyStackTop(*stack));
+            *res = PolyShare(PolyStackTop(*stack));
         else {
             Poly a = PolyStackPop(stack);
 
-            if (command.name == NEG)
-                *res = PolyNeg(&a);
-            else if (command.name == AT)
+            if (command.name == NEG) {
+                PolyMulByCoeffInPlace(&a, -1);
+                *res = a;
+            } else if (command.name == AT) {
                 *res = PolyAt(&a, command.param.x);
-
-            PolyDestroy(&a);
+                PolyDestroy(&a);
+            }
         }
         return true;
     }
     return false;
 }
 
+/**
+ * Wykonuje polecenie AT_POINTS lub zleca obsłużenie błędu STACK UNDERFLOW
+ * w przypadku gdy stos nie zawiera co najmniej jednego wielomianu.
+ * Zdejmuje wielomian z wierzchołka stosu i dodaje na stos jego wartości
+ * w kolejnych punktach, tak że na wierzchołku znajduje się wartość
+ * w ostatnim punkcie.
+ * @param[in] command : polecenie
+ * @param[in, out] stack : wskaźnik na stos
+ * @param[in] line_nr : numer lini
+ */
+static void
+ExecuteAtPointsCommand(Command command, PolyStack *stack, size_t line_nr) {
+    if (StackContains(1, *stack, line_nr)) {
+        Points points = command.param.points;
+        Poly a = PolyStackPop(stack);
+        Poly *values = SafeCalloc(points.count, sizeof(Poly));
+        PolyAtPoints(&a, points.count, points.xs, values);
+        for (size_t i = 0; i < points.count; i++)
+            PolyStackPush(stack, values[i]);
+        PolyDestroy(&a);
+        free(values);
+    }
+}
+
 /**
  * Wykonuje odpowiednie polecenie rodzaju PushCommand.
  * Jeśli polecenie to ZERO, wykonuje je, a w przeciwnym przypadku
@@ -243,6 +288,67 @@ ExecuteDegCommand(Command command, PolyStack stack, size_t line_nr) {
     }
 }
 
+/**
+ * Wykonuje polecenie EVAL lub zleca obsłużenie błędu STACK UNDERFLOW
+ * w przypadku gdy stos nie zawiera co najmniej jednego wielomianu.
+ * Wypisuje wartość wielomianu z wierzchołka stosu, pod którego kolejne
+ * zmienne podstawiamy liczby z parametru polecenia, a pod pozostałe zera.
+ * W trybie dokładnym wartość może nie mieścić się w typie poly_coeff_t,
+ * dlatego podstawiamy liczby funkcją PolyAt.
+ * @param[in] command : polecenie
+ * @param[in] stack : stos
+ * @param[in] line_nr : numer lini
+ */
+static void
+ExecuteEvalCommand(Command command, PolyStack stack, size_t line_nr) {
+    if (StackContains(1, stack, line_nr)) {
+        Points points = command.param.points;
+        if (!PolyGetExact()) {
+            printf("%ld\n", PolyEval(PolyStackTop(stack), points.count,
+                                     points.xs));
+            return;
+        }
+
+        Poly value = PolyShare(PolyStackTop(stack));
+        for (size_t i = 0; i < points.count || !PolyIsCoeff(&value); i++) {
+            Poly at = PolyAt(&value, i < points.count ? points.xs[i] : 0);
+            PolyDestroy(&value);
+            value = at;
+        }
+        Print(value);
+        printf("\n");
+        PolyDestroy(&value);
+    }
+}
+
+/**
+ * Wykonuje polecenie COMPILE lub zleca obsłużenie błędu STACK UNDERFLOW
+ * w przypadku gdy stos nie zawiera co najmniej jednego wielomianu.
+ * Kompiluje wielomian z wierzchołka stosu w bieżącym trybie
+ * współczynników, zastępując poprzedni program.
+ * @param[in] stack : stos
+ * @param[in] line_nr : numer lini
+ */
+static void ExecuteCompileCommand(PolyStack stack, size_t line_nr) {
+    if (StackContains(1, stack, line_nr)) {
+        ProgramDestroy(&program);
+        program = ProgramCompile(PolyStackTop(stack));
+    }
+}
+
+/**
+ * Wykonuje polecenie PROG_EVAL. Wypisuje wartość wyliczoną przez program
+ * skompilowany poleceniem COMPILE, który pod kolejne zmienne podstawia
+ * liczby z parametru polecenia, a pod pozostałe zera.
+ * @param[in] command : polecenie
+ */
+static void ExecuteProgEvalCommand(Command command) {
+    Points points = command.param.points;
+    poly_coeff_t value;
+    ProgramEval(&program, 1, points.count, points.xs, &value);
+    printf("%ld\n", value);
+}
+
 /**
  * Wypisuje na standardowe wyjście 1 jeśli wartość argumentu statement
  * to prawda i 0 w przeciwnym przypadku.
@@ -256,15 +362,23 @@ static void PrintZeroOrOne(bool statement) {
 }
 
 /**
- * Wykonuje polecenie IS_EQ na dwóch wielomanach z wierzchu stosu.
+ * Wykonuje polecenie IS_EQ lub IS_EQ_EXACT na dwóch wielomanach z wierzchu
+ * stosu. Polecenie IS_EQ po poleceniu EQ_ERROR z dodatnim parametrem
+ * porównuje je probabilistycznie, a polecenie IS_EQ_EXACT zawsze
+ * dokładnie.
  * Zakłada, że stos zawiera co najmniej dwa wielomiany.
+ * @param[in] command : polecenie IS_EQ lub IS_EQ_EXACT
  * @param[in] stack : stos zawierający co najmniej dwa wielomiany
  * @return Czy dwa wielomiany z wierzchu stosu są równe?
  */
-static bool CompareTopPolynomials(PolyStack stack) {
+static bool CompareTopPolynomials(Command command, PolyStack stack) {
     assert(stack.size >= 2);
     Poly *polys = PolysStackTop(stack, 2);
-    bool res = PolyIsEq(polys + 0, polys + 1);
+    bool res;
+    if (command.name == IS_EQ && eq_error > 0)
+        res = PolyIsEqRandom(polys + 0, polys + 1, (unsigned) eq_error);
+    else
+        res = PolyIsEq(polys + 0, polys + 1);
     free(polys);
     return res;
 }
@@ -273,7 +387,7 @@ static bool CompareTopPolynomials(PolyStack stack) {
  * Wykonuje odpowiednie polecenie rodzaju BooleanCommand lub zleca
  * obsłużenie błędu STACK UNDERFLOW w przypadku gdy stos nie
  * zawiera co najmniej dwóch wielomianów jeśli polecenie to IS_EQ
- * lub co najmniej jednego wielomianu jeśli polecenie to IS_COEFF
+ * lub IS_EQ_EXACT, lub co najmniej jednego wielomianu jeśli polecenie to IS_COEFF
  * bądź IS_ZERO.
  * @param[in] command : polecenie
  * @param[in] stack : stos wielomianów
@@ -281,9 +395,9 @@ static bool CompareTopPolynomials(PolyStack stack) {
  */
 static void
 ExecuteBooleanCommand(Command command, PolyStack stack, size_t line_nr) {
-    if (command.name == IS_EQ) {
+    if (command.name == IS_EQ || command.name == IS_EQ_EXACT) {
         if (StackContains(2, stack, line_nr))
-            PrintZeroOrOne(CompareTopPolynomials(stack));
+            PrintZeroOrOne(CompareTopPolynomials(command, stack));
     } else if (StackContains(1, stack, line_nr)) {
         if (command.name == IS_COEFF)
             PrintZeroOrOne(PolyIsCoeff(PolyStackTop(stack)));
@@ -295,8 +409,8 @@ ExecuteBooleanCommand(Command command, PolyStack stack, size_t line_nr) {
 /**
  * Wykonuje polecenie rodzaju PrintCommand. Jeśli polecenie to PRINT
  * wykonuje je, a w przeciwnym przypadku zleca wykonanie odpowiedniego
- * polecenia rodzaju DegCommand lub odpowiedniego polecenia rodzaju
- * BooleanCommand.
+ * polecenia rodzaju DegCommand, polecenia EVAL lub odpowiedniego
+ * polecenia rodzaju BooleanCommand.
  * @param[in] command : polecenie
  * @param[in] stack : stos wielomianów
  * @param[in] line_nr : numer lini
@@ -307,6 +421,8 @@ ExecutePrintCommand(Command command, PolyStack stack, size_t line_nr) {
         PrintTopPoly(stack, line_nr);
     else if (command.name == DEG || command.name == DEG_BY)
         ExecuteDegCommand(command, stack, line_nr);
+    else if (command.name == EVAL)
+        ExecuteEvalCommand(command, stack, line_nr);
     else
         ExecuteBooleanCommand(command, stack, line_nr);
 }
@@ -325,7 +441,32 @@ static void ExecutePopCommand(PolyStack *stack, size_t line_nr) {
 }
 
 /**
- * Wykonuje polecenie. Jeśli polecenie to POP, wykonuje je, a
+ * Ustawia moduł współczynników (patrz PolySetModulus) i sprowadza do niego
+ * współczynniki wszystkich wielomianów na stosie.
+ * @param[in] modulus : moduł lub 0
+ * @param[in, out] stack : stos wielomianów
+ */
+static void SetModulus(size_t modulus, PolyStack *stack) {
+    PolySetModulus((poly_coeff_t) modulus);
+    PolyStackMap(stack, PolyReduceCoeffs);
+}
+
+/**
+ * Włącza lub wyłącza dokładny tryb współczynników (patrz PolySetExact).
+ * Po wyłączeniu trybu zamienia duże współczynniki wielomianów na stosie
+ * na ich reszty z dzielenia przez @f$2^{64}@f$.
+ * @param[in] exact : 1, gdy tryb należy włączyć, 0 w przeciwnym przypadku
+ * @param[in, out] stack : stos wielomianów
+ */
+static void SetExact(size_t exact, PolyStack *stack) {
+    PolySetExact(exact == 1);
+    if (exact == 0)
+        PolyStackMap(stack, PolyReduceCoeffs);
+}
+
+/**
+ * Wykonuje polecenie. Jeśli polecenie to POP, THREADS, MOD, EXACT,
+ * AT_POINTS, COMPILE, PROG_EVAL lub EQ_ERROR, wykonuje je, a
  * w przeciwnym przypadku zleca wykonanie odpowiedniego
  * polecenia rodzaju PushCommand lub odpowiedniego polecenia
  * rodzaju PrintCommand.
@@ -339,6 +480,20 @@ static void CommandExecute(Command command, PolyStack *stack, size_t line_nr) {
 
     if (command.name == POP)
         ExecutePopCommand(stack, line_nr);
+    else if (command.name == THREADS)
+        PolySetThreads(command.param.threads);
+    else if (command.name == MOD)
+        SetModulus(command.param.modulus, stack);
+    else if (command.name == EXACT)
+        SetExact(command.param.exact, stack);
+    else if (command.name == AT_POINTS)
+        ExecuteAtPointsCommand(command, stack, line_nr);
+    else if (command.name == COMPILE)
+        ExecuteCompileCommand(*stack, line_nr);
+    else if (command.name == PROG_EVAL)
+        ExecuteProgEvalCommand(command);
+    else if (command.name == EQ_ERROR)
+        eq_error = command.param.eq_error;
     else if (IsPushCommand(command))
         ExecutePushCommand(command, stack, line_nr);
     else // Wiemy, że polecenie jest rodzaju PrintCommand
@@ -375,16 +530,76 @@ static void ProcessLine(string line, ssize_t line_length, size_t line_nr,
 
     if (action.type == PUSH_POLY)
         PolyStackPush(stack, action.spec.poly);
-    else if (action.type == COMMAND)
+    else if (action.type == COMMAND) {
         CommandExecute(action.spec.command, stack, line_nr);
+        if (action.spec.command.name == AT_POINTS
+            || action.spec.command.name == EVAL
+            || action.spec.command.name == PROG_EVAL)
+            free(action.spec.command.param.points.xs);
+    }
     else if (action.type == INPUT_ERROR)
         HandleInputError(action.spec.error, line_nr);
 }
 
+/**
+ * Konfiguruje alokator pamięci na podstawie zmiennych środowiskowych.
+ * Zmienna POLY_ALLOC równa "system" wyłącza pulę bloków, a ustawienie
+ * zmiennej POLY_ALLOC_STATS włącza wypisywanie liczników alokatora.
+ * @return Czy po każdym wierszu należy wypisywać liczniki alokatora?
+ */
+static bool ConfigureAllocator() {
+    string mode = getenv("POLY_ALLOC");
+    if (mode != NULL && strcmp(mode, "system") == 0)
+        SafeAllocSetMode(ALLOC_SYSTEM);
+    else
+        SafeAllocSetMode(ALLOC_POOL);
+
+    return getenv("POLY_ALLOC_STATS") != NULL;
+}
+
+/**
+ * Wykonuje polecenie @p name z parametrem równym wartości zmiennej
+ * środowiskowej @p variable, o ile jest ona poprawnym parametrem tego
+ * polecenia. W przeciwnym przypadku nic nie robi.
+ * @param[in] variable : nazwa zmiennej środowiskowej
+ * @param[in] name : nazwa polecenia
+ * @param[in] command : polecenie o nazwie @p name
+ * @param[in, out] stack : stos wielomianów
+ */
+static void ConfigureCommand(string variable, string name, CommandName command,
+                             PolyStack *stack) {
+    string value = getenv(variable);
+    if (value == NULL)
+        return;
+
+    size_t line_length = strlen(name) + 1 + strlen(value) + 1;
+    string line = SafeCalloc(line_length + 1, sizeof(char));
+    sprintf(line, "%s %s\n", name, value);
+    Action action = ParseLine(line, (ssize_t) line_length);
+    if (action.type == COMMAND && action.spec.command.name == command)
+        CommandExecute(action.spec.command, stack, 0);
+    free(line);
+}
+
+/**
+ * Wypisuje na standardowe wyjście diagnostyczne liczniki alokatora
+ * zebrane podczas przetwarzania lini: liczbę żądań alokacji, liczbę
+ * wywołań malloc oraz liczbę alokacji, których dzięki puli i arenie
+ * nie trzeba było przekazywać do malloc.
+ * @param[in] line_nr : numer lini
+ */
+static void PrintAllocStats(size_t line_nr) {
+    AllocStats stats = SafeAllocGetStats();
+    fprintf(stderr, "ALLOC %zu REQUESTS %zu SYSTEM %zu SAVED %zu\n",
+            line_nr, stats.allocs, stats.system_allocs,
+            stats.pool_hits + stats.arena_allocs);
+}
+
 /**
  * Rozpoczyna działanie kalkulatora.
  * Czyta dane wierszami ze standardowego wejścia, dodaje na stos wielomian,
  * wykonuje odpowiednią instrukcję lub wypisuje stosowny komunikat o błędzie.
+ * Po każdym wierszu może wypisać liczniki alokatora (patrz ConfigureAllocator).
  */
 static void RunCalc() {
     PolyStack stack = NewPolyStack();
@@ -392,6 +607,14 @@ static void RunCalc() {
     size_t line_size = 0;
     size_t line_nr = 1;
     ssize_t line_length;
+    bool print_stats = ConfigureAllocator();
+    /* Zmienne POLY_MOD, POLY_EXACT i POLY_EQ_ERROR działają jak pierwsze
+     * wiersze wejścia. */
+    ConfigureCommand("POLY_MOD", "MOD", MOD, &stack);
+    ConfigureCommand("POLY_EXACT", "EXACT", EXACT, &stack);
+    ConfigureCommand("POLY_EQ_ERROR", "EQ_ERROR", EQ_ERROR, &stack);
+    Poly zero = PolyZero();
+    program = ProgramCompile(&zero);
     errno = 0;
 
     do {
@@ -400,12 +623,19 @@ static void RunCalc() {
             exit(1);
         if (line_length != -1) {
             string line = pntr;
-            ProcessLine(line, line_length, line_nr++, &stack);
+            SafeAllocResetStats();
+            ProcessLine(line, line_length, line_nr, &stack);
+            if (print_stats)
+                PrintAllocStats(line_nr);
+            line_nr++;
         }
     } while (line_length != -1);
 
     free(pntr);
     PolyStackDestroy(stack);
+    ProgramDestroy(&program);
+    PolySetThreads(1);
+    PolySetModulus(0);
 }
 
 /**
@@ -13,20 +13,33 @@
 
 /** Enum określający dostepne polecenia. */
 typedef enum CommandName {
-    /* Polecenia AT, DEG_BY oraz COMPOSE- jedyne, które wymagają parametrów
+    /* Polecenia AT, DEG_BY, COMPOSE, THREADS, MOD, EXACT, AT_POINTS, EVAL,
+     * PROG_EVAL oraz EQ_ERROR - jedyne, które wymagają parametrów
      * zostały wymienione jako ostatnie - dzięki temu możemy skorzystać
      * z wartości stałych opisujących polecenia bezparametrowe podczas
      * parsowania w pliku parsing.c w funkcji IsNoParamCommand. */
     ZERO, IS_COEFF, IS_ZERO, CLONE, ADD, MUL,
-    NEG, SUB, IS_EQ, DEG, PRINT, POP,
-    AT, DEG_BY, COMPOSE
+    NEG, SUB, IS_EQ, DEG, PRINT, POP, COMPILE, IS_EQ_EXACT,
+    AT, DEG_BY, COMPOSE, THREADS, MOD, EXACT, AT_POINTS, EVAL, PROG_EVAL,
+    EQ_ERROR
 } CommandName;
 
-/** Unia określająca parametr poleceń AT lub DEG_BY. */
+/** Struktura określająca parametr poleceń AT_POINTS, EVAL i PROG_EVAL. */
+typedef struct Points {
+    size_t count; ///< Liczba punktów
+    poly_coeff_t *xs; ///< Tablica punktów zaalokowana na stercie
+} Points;
+
+/** Unia określająca parametr poleceń wymagających parametru. */
 typedef union CommandParam {
     poly_coeff_t x; ///< Parametr polecenia AT
     size_t var_idx; ///< Parametr polecenia DEG_BY
     size_t k; ///< Parametr polecenia COMPOSE
+    size_t threads; ///< Parametr polecenia THREADS
+    size_t modulus; ///< Parametr polecenia MOD
+    size_t exact; ///< Parametr polecenia EXACT
+    size_t eq_error; ///< Parametr polecenia EQ_ERROR
+    Points points; ///< Parametr poleceń AT_POINTS, EVAL i PROG_EVAL
 } CommandParam;
 
 /** Struktura określająca nazwę polecenia wraz z parametrem
@@ -39,7 +52,9 @@ typedef struct Command {
 /** Enum określający obsługiwane błędy wejścia. */
 typedef enum InputError {
     WRONG_COMMAND, DEG_BY_WRONG_VARIABLE,
-    AT_WRONG_VALUE, COMPOSE_WRONG_PARAMATER, WRONG_POLY
+    AT_WRONG_VALUE, COMPOSE_WRONG_PARAMATER, THREADS_WRONG_COUNT, WRONG_POLY,
+    MOD_WRONG_VALUE, EXACT_WRONG_VALUE, AT_POINTS_WRONG_VALUE,
+    EVAL_WRONG_VALUE, PROG_EVAL_WRONG_VALUE, EQ_ERROR_WRONG_VALUE
 } InputError;
 
 /** Enum określający rodzaj czynności,
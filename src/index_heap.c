@@ -0,0 +1,57 @@
+/** @file
+  Implementacja biblioteki udostępniającej kopiec par indeksów jednomianów.
+
+  @author Szymon Łukasik <sl428760@mimuw.students.edu.pl>
+  @date 2021
+*/
+
+#include <stdlib.h>
+
+#include "safe_alloc.h"
+#include "index_heap.h"
+
+IndexHeap NewIndexHeap(size_t capacity) {
+    IndexHeap heap;
+    heap.data = SafeCalloc(capacity, sizeof(IndexPair));
+    heap.size = 0;
+    heap.capacity = capacity;
+    return heap;
+}
+
+void IndexHeapPush(IndexHeap *heap, IndexPair pair) {
+    assert(heap->size < heap->capacity);
+    size_t k = heap->size++;
+
+    // Przesuwamy parę w górę kopca.
+    while (k > 0 && heap->data[(k - 1) / 2].exp > pair.exp) {
+        heap->data[k] = heap->data[(k - 1) / 2];
+        k = (k - 1) / 2;
+    }
+    heap->data[k] = pair;
+}
+
+IndexPair IndexHeapPop(IndexHeap *heap) {
+    assert(heap->size > 0);
+    IndexPair res = heap->data[0];
+    IndexPair last = heap->data[--heap->size];
+    size_t k = 0;
+
+    // Przesuwamy ostatni element kopca w dół, zaczynając od korzenia.
+    while (2 * k + 1 < heap->size) {
+        size_t child = 2 * k + 1;
+        if (child + 1 < heap->size
+            && heap->data[child + 1].exp < heap->data[child].exp)
+            child++;
+        if (heap->data[child].exp >= last.exp)
+            break;
+        heap->data[k] = heap->data[child];
+        k = child;
+    }
+    heap->data[k] = last;
+
+    return res;
+}
+
+void IndexHeapDestroy(IndexHeap heap) {
+    free(heap.data);
+}
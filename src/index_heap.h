@@ -0,0 +1,82 @@
+/** @file
+  Biblioteka udostępniająca kopiec par indeksów jednomianów,
+  uporządkowany rosnąco względem wykładnika.
+
+  @author Szymon Łukasik <sl428760@mimuw.students.edu.pl>
+  @date 2021
+*/
+
+#ifndef __INDEX_HEAP_H__
+#define __INDEX_HEAP_H__
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include "poly.h"
+
+/**
+ * To jest struktura opisująca iloczyn dwóch jednomianów - jednomianu
+ * o indeksie @p i z pierwszej tablicy i jednomianu o indeksie @p j
+ * z drugiej tablicy.
+ */
+typedef struct IndexPair {
+    poly_exp_t exp; ///< Wykładnik iloczynu jednomianów
+    size_t i; ///< Indeks jednomianu w pierwszej tablicy
+    size_t j; ///< Indeks jednomianu w drugiej tablicy
+} IndexPair;
+
+/** To jest struktura reprezentująca kopiec typu min par indeksów. */
+typedef struct IndexHeap {
+    IndexPair *data; ///< Tablica elementów kopca
+    size_t size; ///< Liczba elementów znajdujących się w kopcu
+    size_t capacity; ///< Liczba elementów, dla których została zalokowana pamięć
+} IndexHeap;
+
+/**
+ * Tworzy pusty kopiec mogący pomieścić @p capacity elementów.
+ * @param[in] capacity : maksymalna liczba elementów kopca
+ * @return pusty kopiec
+ */
+IndexHeap NewIndexHeap(size_t capacity);
+
+/**
+ * Wstawia parę indeksów do kopca. Zakłada, że kopiec nie jest pełny.
+ * @param[in, out] heap : wskaźnik na kopiec
+ * @param[in] pair : para indeksów
+ */
+void IndexHeapPush(IndexHeap *heap, IndexPair pair);
+
+/**
+ * Usuwa z kopca parę o najmniejszym wykładniku i zwraca ją.
+ * Zakłada, że kopiec nie jest pusty.
+ * @param[in, out] heap : wskaźnik na kopiec
+ * @return para indeksów o najmniejszym wykładniku
+ */
+IndexPair IndexHeapPop(IndexHeap *heap);
+
+/**
+ * Sprawdza, czy kopiec jest pusty.
+ * @param[in] heap : kopiec
+ * @return Czy kopiec jest pusty?
+ */
+static inline bool IndexHeapEmpty(IndexHeap heap) {
+    return heap.size == 0;
+}
+
+/**
+ * Zwraca najmniejszy wykładnik spośród par w kopcu.
+ * Zakłada, że kopiec nie jest pusty.
+ * @param[in] heap : kopiec
+ * @return najmniejszy wykładnik
+ */
+static inline poly_exp_t IndexHeapMinExp(IndexHeap heap) {
+    assert(heap.size > 0);
+    return heap.data[0].exp;
+}
+
+/**
+ * Zwalnia pamięć zaalokowaną przez kopiec.
+ * @param[in] heap : kopiec
+ */
+void IndexHeapDestroy(IndexHeap heap);
+
+#endif // __INDEX_HEAP_H__
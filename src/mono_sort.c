@@ -0,0 +1,230 @@
+/** @file
+  Implementacja biblioteki udostępniającej sortowanie tablic jednomianów.
+
+  @author Szymon Łukasik <sl428760@mimuw.students.edu.pl>
+  @date 2021
+*/
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "safe_alloc.h"
+#include "mono_sort.h"
+
+/** Maksymalny rozmiar tablicy sortowanej przez wstawianie. */
+#define INSERTION_SORT_MAX 32
+
+/** Maksymalna liczba posortowanych fragmentów tablicy, przy której
+ * fragmenty są scalane zamiast sortowania pozycyjnego. */
+#define MERGE_MAX_RUNS 8
+
+/** Liczba bitów cyfry sortowania pozycyjnego. */
+#define RADIX_BITS 8
+
+/** Liczba możliwych wartości cyfry sortowania pozycyjnego. */
+#define RADIX_BUCKETS (1 << RADIX_BITS)
+
+/** Liczba cyfr klucza sortowania pozycyjnego. */
+#define RADIX_DIGITS (32 / RADIX_BITS)
+
+/**
+ * Zwraca klucz sortowania pozycyjnego jednomianu - wykładnik z odwróconym
+ * bitem znaku, dzięki czemu porządek kluczy bez znaku odpowiada
+ * porządkowi wykładników.
+ * @param[in] m : jednomian
+ * @return klucz jednomianu
+ */
+static inline uint32_t MonoKey(const Mono *m) {
+    return (uint32_t) m->exp ^ UINT32_C(0x80000000);
+}
+
+/**
+ * Sortuje tablicę jednomianów przez wstawianie.
+ * @param[in] count : rozmiar tablicy @p monos
+ * @param[in, out] monos : tablica jednomianów
+ */
+static void InsertionSort(size_t count, Mono monos[]) {
+    for (size_t i = 1; i < count; i++) {
+        Mono m = monos[i];
+        size_t j = i;
+        while (j > 0 && monos[j - 1].exp > m.exp) {
+            monos[j] = monos[j - 1];
+            j--;
+        }
+        monos[j] = m;
+    }
+}
+
+/**
+ * Wyznacza posortowane fragmenty tablicy jednomianów. Fragment @p i
+ * zajmuje indeksy od @p bounds[i] do @p bounds[i + 1] - 1. Przerywa,
+ * gdy fragmentów jest więcej niż @p limit.
+ * @param[in] count : rozmiar tablicy @p monos
+ * @param[in] monos : tablica jednomianów
+ * @param[in] limit : maksymalna liczba wyznaczanych fragmentów
+ * @param[out] bounds : tablica o rozmiarze co najmniej @p limit + 1
+ *                      na granice fragmentów
+ * @return liczba fragmentów lub @p limit + 1, gdy jest ich więcej
+ */
+static size_t FindRuns(size_t count, const Mono monos[], size_t limit,
+                       size_t bounds[]) {
+    size_t runs = 1;
+    bounds[0] = 0;
+
+    for (size_t i = 1; i < count; i++) {
+        if (monos[i].exp < monos[i - 1].exp) {
+            if (runs == limit)
+                return limit + 1;
+            bounds[runs++] = i;
+        }
+    }
+    bounds[runs] = count;
+
+    return runs;
+}
+
+/**
+ * Scala dwie posortowane tablice jednomianów do tablicy @p dst.
+ * Przy równych wykładnikach jednomian z pierwszej tablicy trafia
+ * do wyniku jako pierwszy.
+ * @param[in] a_count : rozmiar tablicy @p a
+ * @param[in] a : pierwsza tablica
+ * @param[in] b_count : rozmiar tablicy @p b
+ * @param[in] b : druga tablica
+ * @param[out] dst : tablica o rozmiarze @p a_count + @p b_count
+ */
+static void MergeTwo(size_t a_count, const Mono a[],
+                     size_t b_count, const Mono b[], Mono dst[]) {
+    size_t i = 0, j = 0, k = 0;
+
+    while (i < a_count && j < b_count)
+        dst[k++] = b[j].exp < a[i].exp ? b[j++] : a[i++];
+    memcpy(dst + k, a + i, (a_count - i) * sizeof(Mono));
+    memcpy(dst + k + a_count - i, b + j, (b_count - j) * sizeof(Mono));
+}
+
+/**
+ * Sortuje tablicę jednomianów, scalając parami jej posortowane fragmenty.
+ * @param[in] count : rozmiar tablicy @p monos
+ * @param[in, out] monos : tablica jednomianów
+ * @param[in] runs : liczba fragmentów
+ * @param[in, out] bounds : granice fragmentów (patrz FindRuns)
+ * @param[in] buffer : tablica pomocnicza o rozmiarze @p count
+ */
+static void MergeRuns(size_t count, Mono monos[], size_t runs,
+                      size_t bounds[], Mono buffer[]) {
+    Mono *src = monos, *dst = buffer;
+
+    while (runs > 1) {
+        size_t merged = 0;
+        for (size_t i = 0; i < runs; i += 2) {
+            size_t begin = bounds[i], mid = bounds[i + 1];
+            size_t end = i + 1 < runs ? bounds[i + 2] : mid;
+            MergeTwo(mid - begin, src + begin, end - mid, src + mid,
+                     dst + begin);
+            bounds[merged++] = begin;
+        }
+        bounds[merged] = count;
+        runs = merged;
+
+        Mono *tmp = src;
+        src = dst;
+        dst = tmp;
+    }
+
+    if (src != monos)
+        memcpy(monos, src, count * sizeof(Mono));
+}
+
+/**
+ * Sortuje tablicę jednomianów pozycyjnie (LSD radix sort), zaczynając od
+ * najmniej znaczącej cyfry klucza. Liczności cyfr wszystkich pozycji
+ * wyznaczane są w jednym przebiegu, a pozycje, na których wszystkie
+ * klucze mają tę samą cyfrę, są pomijane.
+ * @param[in] count : rozmiar tablicy @p monos
+ * @param[in, out] monos : tablica jednomianów
+ * @param[in] buffer : tablica pomocnicza o rozmiarze @p count
+ */
+static void RadixSort(size_t count, Mono monos[], Mono buffer[]) {
+    size_t histogram[RADIX_DIGITS][RADIX_BUCKETS] = {{0}};
+
+    for (size_t i = 0; i < count; i++) {
+        uint32_t key = MonoKey(&monos[i]);
+        for (size_t d = 0; d < RADIX_DIGITS; d++)
+            histogram[d][(key >> (d * RADIX_BITS)) & (RADIX_BUCKETS - 1)]++;
+    }
+
+    Mono *src = monos, *dst = buffer;
+    for (size_t d = 0; d < RADIX_DIGITS; d++) {
+        size_t *offsets = histogram[d];
+        uint32_t first = (MonoKey(&src[0]) >> (d * RADIX_BITS))
+                         & (RADIX_BUCKETS - 1);
+        if (offsets[first] == count)
+            continue;
+
+        size_t sum = 0;
+        for (size_t b = 0; b < RADIX_BUCKETS; b++) {
+            size_t bucket = offsets[b];
+            offsets[b] = sum;
+            sum += bucket;
+        }
+
+        for (size_t i = 0; i < count; i++) {
+            uint32_t digit = (MonoKey(&src[i]) >> (d * RADIX_BITS))
+                             & (RADIX_BUCKETS - 1);
+            dst[offsets[digit]++] = src[i];
+        }
+
+        Mono *tmp = src;
+        src = dst;
+        dst = tmp;
+    }
+
+    if (src != monos)
+        memcpy(monos, src, count * sizeof(Mono));
+}
+
+void MonoSort(size_t count, Mono monos[]) {
+    if (count < 2)
+        return;
+
+    if (count <= INSERTION_SORT_MAX) {
+        InsertionSort(count, monos);
+        return;
+    }
+
+    size_t bounds[MERGE_MAX_RUNS + 1];
+    size_t runs = FindRuns(count, monos, MERGE_MAX_RUNS, bounds);
+    if (runs == 1)
+        return;
+
+    Mono *buffer = SafeCalloc(count, sizeof(Mono));
+    if (runs <= MERGE_MAX_RUNS)
+        MergeRuns(count, monos, runs, bounds, buffer);
+    else
+        RadixSort(count, monos, buffer);
+    free(buffer);
+}
+
+/**
+ * Porównuje jednomiany ze względu na wykładnik.
+ * @param[in] a : jednomian @f$a@f$
+ * @param[in] b : jednomian @f$b@f$
+ * @return -1 gdy @p a.exp < @p b.exp, 1 gdy @p a.exp > @p b.exp, 0
+ * w przeciwnym przypadku
+ */
+static int CompareMono(const void *a, const void *b) {
+    Mono m1 = *(Mono *) a;
+    Mono m2 = *(Mono *) b;
+
+    if (m1.exp < m2.exp)
+        return -1;
+    else if (m1.exp > m2.exp)
+        return 1;
+    return 0;
+}
+
+void MonoSortQsort(size_t count, Mono monos[]) {
+    qsort(monos, count, sizeof(Mono), CompareMono);
+}
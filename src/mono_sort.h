@@ -0,0 +1,34 @@
+/** @file
+  Biblioteka udostępniająca sortowanie tablic jednomianów
+  rosnąco względem wykładnika.
+
+  @author Szymon Łukasik <sl428760@mimuw.students.edu.pl>
+  @date 2021
+*/
+
+#ifndef __MONO_SORT_H__
+#define __MONO_SORT_H__
+
+#include <stdlib.h>
+#include "poly.h"
+
+/**
+ * Sortuje stabilnie tablicę jednomianów rosnąco względem wykładnika.
+ * Tablica już posortowana jest rozpoznawana w jednym przebiegu, tablica
+ * złożona z kilku posortowanych fragmentów jest scalana, małe tablice
+ * sortowane są przez wstawianie, a pozostałe pozycyjnie (LSD radix sort)
+ * według kolejnych bajtów wykładnika.
+ * @param[in] count : rozmiar tablicy @p monos
+ * @param[in, out] monos : tablica jednomianów
+ */
+void MonoSort(size_t count, Mono monos[]);
+
+/**
+ * Sortuje tablicę jednomianów rosnąco względem wykładnika przy użyciu
+ * funkcji qsort. Służy do porównań w testach wydajnościowych.
+ * @param[in] count : rozmiar tablicy @p monos
+ * @param[in, out] monos : tablica jednomianów
+ */
+void MonoSortQsort(size_t count, Mono monos[]);
+
+#endif // __MONO_SORT_H__
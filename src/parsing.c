@@ -14,6 +14,8 @@
 #include "parsing.h"
 #include "calc.h"
 #include "mono_stack.h"
+#include "safe_alloc.h"
+#include "poly_mod.h"
 
 /** Enum określający parsowane liczby. */
 typedef enum NumberType {
@@ -26,18 +28,24 @@ typedef enum NumberType {
 /** Maksymalna wartość wykładnika jednomianu. */
 #define MAX_EXP 2147483647
 
+/** Maksymalna liczba wątków, którą można ustawić poleceniem THREADS. */
+#define MAX_THREADS 256
+
+/** Maksymalny parametr polecenia EQ_ERROR. */
+#define MAX_EQ_ERROR 1024
+
 /** Liczba poleceń bezparametrowych. */
-static const size_t NO_PARAM_COMM_NUM = 12;
+static const size_t NO_PARAM_COMM_NUM = 14;
 
 /** Tablica stringów zawierająca nazwy poleceń bezparametrowych
  *  z dodanym na końcu znakiem nowej lini.
  *  Kolejność nazw tych poleceń w tablicy odpowiada kolejności ich
  *  występowania w definicji typu CommandName.
  *  */
-static const string NO_PARAM_COMM_NAMES[12] =
+static const string NO_PARAM_COMM_NAMES[14] =
         {"ZERO\n", "IS_COEFF\n", "IS_ZERO\n", "CLONE\n",
          "ADD\n", "MUL\n", "NEG\n", "SUB\n", "IS_EQ\n",
-         "DEG\n", "PRINT\n", "POP\n"};
+         "DEG\n", "PRINT\n", "POP\n", "COMPILE\n", "IS_EQ_EXACT\n"};
 
 /**
  * Sprawdza czy pierwszy znak fragmentu lini jest poprawny w przypadku
@@ -183,7 +191,7 @@ static bool PolyTryToParse(string *line, Poly *poly, char end_char) {
     } else { // Parsujemy stały wielomian
         poly_coeff_t coeff;
         if (NumberTryToParse(*line, COEFF, &coeff, line, end_char)) {
-            *poly = PolyFromCoeff(coeff);
+            *poly = PolyFromCoeff(PolyCoeffReduce(coeff));
             return true;
         }
     }
@@ -424,6 +432,251 @@ static bool IsCompose(string line, Action *action) {
     return false;
 }
 
+/**
+ * Sprawdza czy linia powinna być interpretowana jako polecenie THREADS.
+ * Jeśli powinna, próbuje dokonać parsowania
+ * parametru polecenia oraz ustawia odpowiedni rodzaj i specyfikację
+ * czynności argumentowi action (jeśli parsowanie się nie powiedzie
+ * lub liczba wątków nie należy do przedziału [1, MAX_THREADS], jest to
+ * opis błędu wejścia - niepoprawny parametr bądź jego brak),
+ * a następnie zwraca prawdę. Jeśli nie powinna, zwraca fałsz.
+ * @param[in] line : rozważana linia
+ * @param[out] action : wskaźnik na zmienną typu \a Action
+ * @return Czy linię należy interpretować jako polecenie THREADS?
+ */
+static bool IsThreads(string line, Action *action) {
+    if (strncmp(line, "THREADS", 7) == 0
+        && (line[7] == '\n' || line[7] == ' ' || line[7] == '\t')) {
+        ShiftToParameter(&line);
+        // Dokonujemy próby parsowania parametru
+        size_t *threads = &action->spec.command.param.threads;
+        if (NumberTryToParse(line, ULL, threads, NULL, '\n')
+            && *threads >= 1 && *threads <= MAX_THREADS) {
+            action->type = COMMAND;
+            action->spec.command.name = THREADS;
+        } else {
+            action->type = INPUT_ERROR;
+            action->spec.error = THREADS_WRONG_COUNT;
+        }
+        return true;
+    }
+    return false;
+}
+
+/**
+ * Sprawdza czy linia powinna być interpretowana jako polecenie MOD.
+ * Jeśli powinna, próbuje dokonać parsowania
+ * parametru polecenia oraz ustawia odpowiedni rodzaj i specyfikację
+ * czynności argumentowi action (jeśli parsowanie się nie powiedzie
+ * lub moduł nie jest zerem ani nie należy do przedziału [2, MOD_MAX),
+ * jest to opis błędu wejścia - niepoprawny parametr bądź jego brak),
+ * a następnie zwraca prawdę. Jeśli nie powinna, zwraca fałsz.
+ * @param[in] line : rozważana linia
+ * @param[out] action : wskaźnik na zmienną typu \a Action
+ * @return Czy linię należy interpretować jako polecenie MOD?
+ */
+static bool IsMod(string line, Action *action) {
+    if (strncmp(line, "MOD", 3) == 0
+        && (line[3] == '\n' || line[3] == ' ' || line[3] == '\t')) {
+        ShiftToParameter(&line);
+        // Dokonujemy próby parsowania parametru
+        size_t *modulus = &action->spec.command.param.modulus;
+        if (NumberTryToParse(line, ULL, modulus, NULL, '\n')
+            && (*modulus == 0 || (*modulus >= 2 && *modulus < MOD_MAX))) {
+            action->type = COMMAND;
+            action->spec.command.name = MOD;
+        } else {
+            action->type = INPUT_ERROR;
+            action->spec.error = MOD_WRONG_VALUE;
+        }
+        return true;
+    }
+    return false;
+}
+
+/**
+ * Sprawdza czy linia powinna być interpretowana jako polecenie EXACT.
+ * Jeśli powinna, próbuje dokonać parsowania
+ * parametru polecenia oraz ustawia odpowiedni rodzaj i specyfikację
+ * czynności argumentowi action (jeśli parsowanie się nie powiedzie
+ * lub parametr nie jest równy 0 ani 1, jest to opis błędu wejścia -
+ * niepoprawny parametr bądź jego brak), a następnie zwraca prawdę.
+ * Jeśli nie powinna, zwraca fałsz.
+ * @param[in] line : rozważana linia
+ * @param[out] action : wskaźnik na zmienną typu \a Action
+ * @return Czy linię należy interpretować jako polecenie EXACT?
+ */
+static bool IsExact(string line, Action *action) {
+    if (strncmp(line, "EXACT", 5) == 0
+        && (line[5] == '\n' || line[5] == ' ' || line[5] == '\t')) {
+        ShiftToParameter(&line);
+        // Dokonujemy próby parsowania parametru
+        size_t *exact = &action->spec.command.param.exact;
+        if (NumberTryToParse(line, ULL, exact, NULL, '\n') && *exact <= 1) {
+            action->type = COMMAND;
+            action->spec.command.name = EXACT;
+        } else {
+            action->type = INPUT_ERROR;
+            action->spec.error = EXACT_WRONG_VALUE;
+        }
+        return true;
+    }
+    return false;
+}
+
+/**
+ * Sprawdza czy linia powinna być interpretowana jako polecenie EQ_ERROR.
+ * Jeśli powinna, próbuje dokonać parsowania
+ * parametru polecenia oraz ustawia odpowiedni rodzaj i specyfikację
+ * czynności argumentowi action (jeśli parsowanie się nie powiedzie
+ * lub parametr jest większy niż MAX_EQ_ERROR, jest to opis błędu wejścia -
+ * niepoprawny parametr bądź jego brak), a następnie zwraca prawdę.
+ * Jeśli nie powinna, zwraca fałsz.
+ * @param[in] line : rozważana linia
+ * @param[out] action : wskaźnik na zmienną typu \a Action
+ * @return Czy linię należy interpretować jako polecenie EQ_ERROR?
+ */
+static bool IsEqError(string line, Action *action) {
+    if (strncmp(line, "EQ_ERROR", 8) == 0
+        && (line[8] == '\n' || line[8] == ' ' || line[8] == '\t')) {
+        ShiftToParameter(&line);
+        // Dokonujemy próby parsowania parametru
+        size_t *bits = &action->spec.command.param.eq_error;
+        if (NumberTryToParse(line, ULL, bits, NULL, '\n')
+            && *bits <= MAX_EQ_ERROR) {
+            action->type = COMMAND;
+            action->spec.command.name = EQ_ERROR;
+        } else {
+            action->type = INPUT_ERROR;
+            action->spec.error = EQ_ERROR_WRONG_VALUE;
+        }
+        return true;
+    }
+    return false;
+}
+
+/**
+ * Dokonuje próby parsowania fragmentu lini jako niepustego ciągu liczb
+ * typu COEFF oddzielonych pojedynczymi spacjami i zakończonego znakiem
+ * '\n'. Jeśli się ona udała, zwraca prawdę oraz przypisuje zmiennej
+ * points tablicę sparsowanych liczb zaalokowaną na stercie.
+ * W przeciwnym przypadku zwraca fałsz.
+ * @param[in] line : fragment lini lub NULL
+ * @param[out] points : wskaźnik na zmienną typu \a Points
+ * @return Czy fragment lini jest możliwy do zinterpretowania jako ciąg
+ *         liczb?
+ */
+static bool PointsTryToParse(string line, Points *points) {
+    if (line == NULL)
+        return false;
+
+    // Liczb jest co najwyżej o jedną więcej niż spacji.
+    size_t count = 1;
+    for (string c = line; *c != '\0'; c++)
+        if (*c == ' ')
+            count++;
+
+    poly_coeff_t *xs = SafeCalloc(count, sizeof(poly_coeff_t));
+    size_t parsed = 0;
+    string end = line;
+    while (NumberTryToParse(line, COEFF, &xs[parsed], &end, ' ')) {
+        parsed++;
+        line = end + 1;
+    }
+    if (NumberTryToParse(line, COEFF, &xs[parsed], NULL, '\n')) {
+        points->count = parsed + 1;
+        points->xs = xs;
+        return true;
+    }
+
+    free(xs);
+    return false;
+}
+
+/**
+ * Sprawdza czy linia powinna być interpretowana jako polecenie AT_POINTS.
+ * Jeśli powinna, próbuje dokonać parsowania
+ * parametrów polecenia oraz ustawia odpowiedni rodzaj i specyfikację
+ * czynności argumentowi action (jeśli parsowanie się nie powiedzie
+ * jest to opis błędu wejścia - niepoprawne parametry bądź ich brak),
+ * a następnie zwraca prawdę. Jeśli nie powinna, zwraca fałsz.
+ * @param[in] line : rozważana linia
+ * @param[out] action : wskaźnik na zmienną typu \a Action
+ * @return Czy linię należy interpretować jako polecenie AT_POINTS?
+ */
+static bool IsAtPoints(string line, Action *action) {
+    if (strncmp(line, "AT_POINTS", 9) == 0
+        && (line[9] == '\n' || line[9] == ' ' || line[9] == '\t')) {
+        ShiftToParameter(&line);
+        // Dokonujemy próby parsowania parametrów
+        if (PointsTryToParse(line, &action->spec.command.param.points)) {
+            action->type = COMMAND;
+            action->spec.command.name = AT_POINTS;
+        } else {
+            action->type = INPUT_ERROR;
+            action->spec.error = AT_POINTS_WRONG_VALUE;
+        }
+        return true;
+    }
+    return false;
+}
+
+/**
+ * Sprawdza czy linia powinna być interpretowana jako polecenie EVAL.
+ * Jeśli powinna, próbuje dokonać parsowania
+ * parametrów polecenia oraz ustawia odpowiedni rodzaj i specyfikację
+ * czynności argumentowi action (jeśli parsowanie się nie powiedzie
+ * jest to opis błędu wejścia - niepoprawne parametry bądź ich brak),
+ * a następnie zwraca prawdę. Jeśli nie powinna, zwraca fałsz.
+ * @param[in] line : rozważana linia
+ * @param[out] action : wskaźnik na zmienną typu \a Action
+ * @return Czy linię należy interpretować jako polecenie EVAL?
+ */
+static bool IsEval(string line, Action *action) {
+    if (strncmp(line, "EVAL", 4) == 0
+        && (line[4] == '\n' || line[4] == ' ' || line[4] == '\t')) {
+        ShiftToParameter(&line);
+        // Dokonujemy próby parsowania parametrów
+        if (PointsTryToParse(line, &action->spec.command.param.points)) {
+            action->type = COMMAND;
+            action->spec.command.name = EVAL;
+        } else {
+            action->type = INPUT_ERROR;
+            action->spec.error = EVAL_WRONG_VALUE;
+        }
+        return true;
+    }
+    return false;
+}
+
+/**
+ * Sprawdza czy linia powinna być interpretowana jako polecenie PROG_EVAL.
+ * Jeśli powinna, próbuje dokonać parsowania
+ * parametrów polecenia oraz ustawia odpowiedni rodzaj i specyfikację
+ * czynności argumentowi action (jeśli parsowanie się nie powiedzie
+ * jest to opis błędu wejścia - niepoprawne parametry bądź ich brak),
+ * a następnie zwraca prawdę. Jeśli nie powinna, zwraca fałsz.
+ * @param[in] line : rozważana linia
+ * @param[out] action : wskaźnik na zmienną typu \a Action
+ * @return Czy linię należy interpretować jako polecenie PROG_EVAL?
+ */
+static bool IsProgEval(string line, Action *action) {
+    if (strncmp(line, "PROG_EVAL", 9) == 0
+        && (line[9] == '\n' || line[9] == ' ' || line[9] == '\t')) {
+        ShiftToParameter(&line);
+        // Dokonujemy próby parsowania parametrów
+        if (PointsTryToParse(line, &action->spec.command.param.points)) {
+            action->type = COMMAND;
+            action->spec.command.name = PROG_EVAL;
+        } else {
+            action->type = INPUT_ERROR;
+            action->spec.error = PROG_EVAL_WRONG_VALUE;
+        }
+        return true;
+    }
+    return false;
+}
+
 /**
  * Sprawdza czy linia jest poleceniem bezparametrowym.
  * Jeśli tak, ustawia odpowiedni rodzaj i specyfikację czynności
@@ -471,7 +724,14 @@ static bool CommandTryToParse(string line, Action *action) {
     if (IsNoParamCommand(line, action)
         || IsDegBy(line, action)
         || IsAt(line, action)
-        || IsCompose(line, action))
+        || IsCompose(line, action)
+        || IsThreads(line, action)
+        || IsMod(line, action)
+        || IsExact(line, action)
+        || IsAtPoints(line, action)
+        || IsEval(line, action)
+        || IsProgEval(line, action)
+        || IsEqError(line, action))
         return true;
     return false;
 }
@@ -5,329 +5,1263 @@
   @date 2021
 */
 
+#include <stdatomic.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include "poly.h"
 #include "safe_alloc.h"
+#include "index_heap.h"
+#include "mono_sort.h"
+#include "thread_pool.h"
+#include "poly_packed.h"
+#include "poly_mod.h"
+#include "poly_points.h"
+#include "big_int.h"
 
-void PolyDestroy(Poly *p) {
-    if (!PolyIsCoeff(p)) {
-        for (size_t i = 0; i < p->size; i++)
-            MonoDestroy(&p->arr[i]);
+/**
+ * To jest nagłówek umieszczany w pamięci bezpośrednio przed tablicą
+ * jednomianów. Przechowuje liczbę wielomianów współdzielących tablicę
+ * oraz opis wielomianu o tej tablicy jednomianów: skrót jego struktury,
+ * stopień, liczbę niezerowych jednomianów po rozwinięciu i liczbę
+ * zmiennych. Opis liczony jest z opisów współczynników, więc nie wymaga
+ * przeglądania całego drzewa, a pozwala odpowiadać na pytania o stopień
+ * i szybko odrzucać różne wielomiany w czasie stałym.
+ * Za tablicą jednomianów, w tym samym bloku pamięci, znajduje się ciągła
+ * tablica ich wykładników (układ struktury tablic). Funkcje przeglądające
+ * same wykładniki - scalanie, mnożenie, porównywanie - czytają wtedy
+ * 4 bajty na jednomian zamiast całego 24-bajtowego jednomianu.
+ * Tablica wykładników jest wypełniana razem z zapisem jednomianów przez
+ * MonosWriter albo funkcją MonosSeal, gdy tablica jednomianów staje się
+ * tablicą gotowego wielomianu.
+ */
+typedef struct MonosHeader {
+    atomic_size_t refs; ///< liczba właścicieli tablicy
+    uint64_t hash; ///< skrót struktury wielomianu
+    size_t terms; ///< liczba jednomianów wielomianu po rozwinięciu
+    poly_exp_t deg; ///< stopień wielomianu, obcięty do POLY_EXP_MAX
+    uint32_t depth; ///< liczba zmiennych wielomianu, czyli głębokość drzewa
+} MonosHeader;
+
+static_assert(sizeof(MonosHeader) % _Alignof(Mono) == 0,
+              "nagłówek musi zachowywać wyrównanie jednomianów");
+static_assert(sizeof(Mono) % _Alignof(poly_exp_t) == 0,
+              "jednomiany muszą zachowywać wyrównanie wykładników");
 
-        free(p->arr);
-        p->arr = NULL;
-    }
+/**
+ * Zwraca rozmiar bloku pamięci tablicy jednomianów.
+ * @param[in] count : liczba jednomianów
+ * @return rozmiar bloku w bajtach
+ */
+static inline size_t MonosBlockSize(size_t count) {
+    return sizeof(MonosHeader) + count * (sizeof(Mono) + sizeof(poly_exp_t));
 }
 
-Poly PolyClone(const Poly *p) {
-    Poly clone;
+/**
+ * Zwraca nagłówek tablicy jednomianów.
+ * @param[in] monos : tablica jednomianów zaalokowana funkcją MonosAlloc
+ * @return wskaźnik na nagłówek
+ */
+static inline MonosHeader *MonosGetHeader(const Mono *monos) {
+    return (MonosHeader *) monos - 1;
+}
 
-    if (PolyIsCoeff(p)) {
-        clone.arr = NULL;
-        clone.coeff = p->coeff;
+/**
+ * Zwraca tablicę wykładników tablicy jednomianów.
+ * @param[in] monos : tablica jednomianów zaalokowana funkcją MonosAlloc
+ * @param[in] count : liczba jednomianów, na które zaalokowano tablicę
+ * @return wskaźnik na tablicę wykładników
+ */
+static inline poly_exp_t *MonosExps(const Mono *monos, size_t count) {
+    return (poly_exp_t *) (monos + count);
+}
+
+/**
+ * Miesza bity liczby (funkcja końcowa generatora SplitMix64).
+ * @param[in] x : liczba
+ * @return wymieszana liczba
+ */
+static inline uint64_t HashMix(uint64_t x) {
+    x ^= x >> 30;
+    x *= UINT64_C(0xBF58476D1CE4E5B9);
+    x ^= x >> 27;
+    x *= UINT64_C(0x94D049BB133111EB);
+    return x ^ (x >> 31);
+}
+
+/**
+ * Opis wielomianu liczony przyrostowo z kolejnych jednomianów jego
+ * tablicy jednomianów (patrz MonosHeader).
+ */
+typedef struct MonosDigest {
+    uint64_t hash; ///< niewymieszany skrót dotychczasowych jednomianów
+    size_t terms; ///< liczba jednomianów po rozwinięciu
+    poly_exp_t deg; ///< stopień, obcięty do POLY_EXP_MAX
+    uint32_t depth; ///< największa liczba zmiennych współczynników
+} MonosDigest;
+
+/**
+ * Tworzy opis pustej tablicy jednomianów.
+ * @return opis
+ */
+static inline MonosDigest NewMonosDigest(void) {
+    return (MonosDigest) {.hash = 0, .terms = 0, .deg = -1, .depth = 0};
+}
+
+/**
+ * Dołącza do opisu kolejny jednomian tablicy. Zakłada, że opis
+ * współczynnika jednomianu jest aktualny.
+ * @param[in, out] digest : opis
+ * @param[in] m : jednomian o niezerowym współczynniku
+ */
+static inline void MonosDigestAdd(MonosDigest *digest, const Mono *m) {
+    const Poly *c = &m->p;
+    // Suma wykładników może nie mieścić się w typie poly_exp_t.
+    int64_t child_deg = m->exp;
+
+    if (PolyIsCoeff(c)) {
+        digest->hash = (digest->hash + PolyHash(c))
+                       * UINT64_C(0x9E3779B97F4A7C15);
+        digest->terms += digest->terms < SIZE_MAX;
     } else {
-        clone.size = p->size;
-        clone.arr = SafeCalloc(clone.size, sizeof(Mono));
-        for (size_t i = 0; i < clone.size; i++)
-            clone.arr[i] = MonoClone(&p->arr[i]);
+        const MonosHeader *child = MonosGetHeader(c->arr);
+        digest->hash = (digest->hash + child->hash)
+                       * UINT64_C(0x9E3779B97F4A7C15);
+        // Przy współdzielonych poddrzewach liczba jednomianów może
+        // nie mieścić się w typie size_t.
+        digest->terms = digest->terms > SIZE_MAX - child->terms
+                        ? SIZE_MAX : digest->terms + child->terms;
+        child_deg += child->deg;
+        if (child->depth > digest->depth)
+            digest->depth = child->depth;
     }
 
-    return clone;
+    digest->hash += (uint64_t) m->exp;
+    if (child_deg > digest->deg)
+        digest->deg = child_deg > POLY_EXP_MAX ? POLY_EXP_MAX
+                                               : (poly_exp_t) child_deg;
 }
 
 /**
- * Redukuje wielomian. Jeśli wielomian @f$p@f$ jest postaci @f$c\cdot x^0@f$,
- * gdzie @f$c@f$ to wielomian będący współczynnikiem, upraszcza @f$p@f$ do
- * postaci @f$c@f$.
- * @param[in, out] p : wielomian @f$p@f$
+ * Zapisuje opis wielomianu w nagłówku tablicy jednomianów.
+ * @param[in, out] monos : tablica jednomianów zaalokowana funkcją MonosAlloc
+ * @param[in] count : liczba jednomianów, na które zaalokowano tablicę
+ * @param[in] digest : opis wszystkich jednomianów tablicy
  */
-static void PolyReduce(Poly *p) {
-    if (!PolyIsCoeff(p) && p->size == 1 && p->arr[0].exp == 0
-        && PolyIsCoeff(&p->arr[0].p)) {
+static void MonosDigestStore(Mono *monos, size_t count,
+                             const MonosDigest *digest) {
+    MonosHeader *header = MonosGetHeader(monos);
+    header->hash = HashMix(digest->hash + count);
+    header->terms = digest->terms;
+    header->deg = digest->deg;
+    header->depth = digest->depth + 1;
+}
 
-        Poly p_temp = p->arr[0].p;
-        free(p->arr);
-        *p = p_temp;
+/**
+ * Wypełnia tablicę wykładników i opis wielomianu w nagłówku tablicy
+ * jednomianów. Należy ją wywołać po każdej zmianie jednomianów tablicy,
+ * która jest lub staje się tablicą jednomianów wielomianu, chyba że
+ * jednomiany zapisano przez MonosWriter. Zakłada, że opisy współczynników
+ * jednomianów są aktualne.
+ * @param[in, out] monos : tablica jednomianów zaalokowana funkcją MonosAlloc
+ * @param[in] count : liczba jednomianów, na które zaalokowano tablicę
+ */
+static void MonosSeal(Mono *monos, size_t count) {
+    poly_exp_t *exps = MonosExps(monos, count);
+    MonosDigest digest = NewMonosDigest();
+
+    for (size_t i = 0; i < count; i++) {
+        exps[i] = monos[i].exp;
+        MonosDigestAdd(&digest, &monos[i]);
     }
+    MonosDigestStore(monos, count, &digest);
 }
 
 /**
- * Zwraca tablicę jednomianów zawierającą elementy tablicy @p arr1 i @p arr2.
- * @param[in] arr1 : tablica jednomianów
- * @param[in] arr2 : tablica jednomianów
- * @param[in] size1 : rozmiar tablicy @p arr1
- * @param[in] size2 : rozmiar tablicy @p arr2
- * @return tablicę jednomianów będąca złączeniem tablic @p arr1 i @p arr2
+ * Alokuje niezainicjalizowaną tablicę jednomianów z jednym właścicielem.
+ * @param[in] count : liczba jednomianów
+ * @return wskaźnik na tablicę
  */
-static Mono *MergeMonoArrays(Mono arr1[], Mono arr2[],
-                             size_t size1, size_t size2) {
-    Mono *monos = SafeCalloc(size1 + size2, sizeof(Mono));
+static Mono *MonosAlloc(size_t count) {
+    MonosHeader *header = SafeAlloc(MonosBlockSize(count));
+    atomic_init(&header->refs, 1);
+    return (Mono *) (header + 1);
+}
 
-    for (size_t i = 0; i < size1; i++)
-        monos[i] = arr1[i];
+/**
+ * Zwalnia tablicę jednomianów zaalokowaną funkcją MonosAlloc
+ * lub MonosResize. Nie usuwa samych jednomianów.
+ * Zakłada, że tablica ma co najwyżej jednego właściciela.
+ * @param[in] monos : tablica jednomianów (może być NULL)
+ * @param[in] count : liczba jednomianów, na które zaalokowano tablicę
+ */
+static void MonosFree(Mono *monos, size_t count) {
+    if (monos == NULL)
+        return;
 
-    for (size_t i = 0; i < size2; i++)
-        monos[i + size1] = arr2[i];
+    MonosHeader *header = MonosGetHeader(monos);
+    assert(atomic_load(&header->refs) <= 1);
+    SafeFree(header, MonosBlockSize(count));
+}
 
-    return monos;
+/**
+ * Zmienia rozmiar tablicy jednomianów zaalokowanej funkcją MonosAlloc
+ * lub MonosResize, zachowując jej początkowe jednomiany, ale nie
+ * tablicę wykładników.
+ * Zakłada, że tablica ma jednego właściciela.
+ * @param[in] monos : tablica jednomianów
+ * @param[in] old_count : liczba jednomianów, na które zaalokowano tablicę
+ * @param[in] new_count : nowa liczba jednomianów
+ * @return wskaźnik na tablicę o nowym rozmiarze
+ */
+static Mono *MonosResize(Mono *monos, size_t old_count, size_t new_count) {
+    MonosHeader *header = monos == NULL ? NULL : MonosGetHeader(monos);
+    assert(header == NULL || atomic_load(&header->refs) == 1);
+
+    header = SafeResize(header,
+                        header == NULL ? 0 : MonosBlockSize(old_count),
+                        MonosBlockSize(new_count));
+    if (monos == NULL)
+        atomic_init(&header->refs, 1);
+    return (Mono *) (header + 1);
 }
 
 /**
- * Porównuje jednomiany ze względu na wykładnik.
- * @param[in] a : jednomian @f$a@f$
- * @param[in] b : jednomian @f$b@f$
- * @return -1 gdy @p a.exp < @p b.exp, 1 gdy @p a.exp > @p b.exp, 0
- * w przeciwnym przypadku
+ * To jest struktura zapisująca kolejne jednomiany wielomianu do tablicy
+ * jednomianów. Razem z jednomianem zapisuje jego wykładnik w tablicy
+ * wykładników i dołącza go do opisu wielomianu, więc gotowej tablicy nie
+ * trzeba już ponownie przeglądać funkcją MonosSeal. Dopóki zapis trwa,
+ * tablica wykładników leży za wszystkimi @p capacity jednomianami.
  */
-static int CompareMono(const void *a, const void *b) {
-    Mono m1 = *(Mono *) a;
-    Mono m2 = *(Mono *) b;
+typedef struct MonosWriter {
+    Mono *monos; ///< tablica jednomianów
+    size_t count; ///< liczba zapisanych jednomianów
+    size_t capacity; ///< liczba jednomianów, na które zaalokowano tablicę
+    MonosDigest digest; ///< opis zapisanych jednomianów
+} MonosWriter;
 
-    if (m1.exp < m2.exp)
-        return -1;
-    else if (m1.exp > m2.exp)
-        return 1;
-    return 0;
+/**
+ * Rozpoczyna zapis jednomianów do pustej tablicy @p monos.
+ * @param[in] monos : tablica jednomianów z jednym właścicielem (może być
+ *                    NULL, gdy @p capacity jest równe 0)
+ * @param[in] capacity : liczba jednomianów, na które zaalokowano tablicę
+ * @return struktura zapisująca
+ */
+static MonosWriter NewMonosWriter(Mono *monos, size_t capacity) {
+    return (MonosWriter) {.monos = monos, .count = 0, .capacity = capacity,
+                          .digest = NewMonosDigest()};
 }
 
 /**
- * Sortuje tablicę jednomianów rosnąco względem wykładnika.
- * @param[in] count : rozmiar tablicy @p monos
- * @param[in, out] monos : tablica jednomianów
+ * Dwukrotnie powiększa tablicę struktury zapisującej, przenosząc
+ * za nią tablicę wykładników.
+ * @param[in, out] writer : struktura zapisująca
  */
-static void SortMono(size_t count, Mono monos[]) {
-    qsort(monos, count, sizeof(Mono), CompareMono);
+static void MonosWriterGrow(MonosWriter *writer) {
+    size_t capacity = writer->capacity == 0 ? 1 : 2 * writer->capacity;
+    Mono *monos = MonosResize(writer->monos, writer->capacity, capacity);
+    if (writer->count > 0)
+        memmove(MonosExps(monos, capacity),
+                MonosExps(monos, writer->capacity),
+                writer->count * sizeof(poly_exp_t));
+    writer->monos = monos;
+    writer->capacity = capacity;
 }
 
 /**
- * Zwraca liczbę jednomianów tożsamościowo równych zeru, zawartych w @f$p@f$.
- * @param[in] p : wielomian niebędący współczynnikiem @f$p@f$
- * @return liczba jednomianów zerowych zawartych w @f$p@f$
+ * Dopisuje jednomian na koniec tablicy struktury zapisującej, w razie
+ * potrzeby ją powiększając. Wykładnik jednomianu musi być większy od
+ * wykładników jednomianów zapisanych wcześniej.
+ * @param[in, out] writer : struktura zapisująca
+ * @param[in] m : jednomian o niezerowym współczynniku
  */
-static size_t NumberOfZeros(Poly *p) {
-    assert(!PolyIsCoeff(p));
-    size_t n = 0;
+static inline void MonosWriterPut(MonosWriter *writer, Mono m) {
+    if (writer->count == writer->capacity)
+        MonosWriterGrow(writer);
+    MonosExps(writer->monos, writer->capacity)[writer->count] = m.exp;
+    writer->monos[writer->count++] = m;
+    MonosDigestAdd(&writer->digest, &m);
+}
 
-    for (size_t i = 0; i < p->size; i++) {
-        if (PolyIsZero(&p->arr[i].p))
-            n++;
+/**
+ * Kończy zapis jednomianów. Zmniejsza tablicę do liczby zapisanych
+ * jednomianów, przenosząc tablicę wykładników tuż za nie, i zapisuje
+ * opis wielomianu w nagłówku. Nie redukuje wielomianu.
+ * @param[in, out] writer : struktura zapisująca
+ * @return wielomian złożony z zapisanych jednomianów
+ */
+static Poly MonosWriterFinish(MonosWriter *writer) {
+    Mono *monos = writer->monos;
+    size_t count = writer->count, capacity = writer->capacity;
+    MonosDigest digest = writer->digest;
+    *writer = NewMonosWriter(NULL, 0);
+
+    if (count == 0) {
+        MonosFree(monos, capacity);
+        return PolyZero();
+    }
+
+    if (count < capacity) {
+        memmove(MonosExps(monos, count), MonosExps(monos, capacity),
+                count * sizeof(poly_exp_t));
+        monos = MonosResize(monos, capacity, count);
     }
+    MonosDigestStore(monos, count, &digest);
 
-    return n;
+    return (Poly) {.size = count, .arr = monos};
 }
 
 /**
- * Usuwa zerowe jednomiany zawarte w wielomianie @f$p@f$.
- * @param[in, out] p : wskaźnik na wielomian niebędący współczynnikiem @f$p@f$
+ * Sprawdza, czy tablica jednomianów wielomianu ma jednego właściciela,
+ * czyli czy można ją modyfikować w miejscu.
+ * @param[in] p : wielomian niebędący współczynnikiem
+ * @return Czy tablica jednomianów nie jest współdzielona?
  */
-static void PolyDeleteZeros(Poly *p) {
+static bool PolyIsUnique(const Poly *p) {
     assert(!PolyIsCoeff(p));
-    size_t size = p->size - NumberOfZeros(p);
+    return atomic_load_explicit(&MonosGetHeader(p->arr)->refs,
+                                memory_order_acquire) == 1;
+}
+
+/**
+ * Tworzy jednomian współdzielący współczynnik z jednomianem @p m.
+ * @param[in] m : jednomian
+ * @return jednomian równy @p m
+ */
+static Mono MonoShare(const Mono *m) {
+    return (Mono) {.p = PolyShare(&m->p), .exp = m->exp};
+}
+
+/**
+ * Zapewnia, że tablica jednomianów wielomianu @p p ma jednego właściciela
+ * (kopiowanie przy zapisie). Jeśli tablica jest współdzielona, zastępuje ją
+ * kopią, której jednomiany współdzielą współczynniki z oryginałem.
+ * @param[in, out] p : wielomian niebędący współczynnikiem
+ */
+static void PolyMakeUnique(Poly *p) {
+    if (PolyIsUnique(p))
+        return;
+
+    MonosWriter writer = NewMonosWriter(MonosAlloc(p->size), p->size);
+    for (size_t i = 0; i < p->size; i++)
+        MonosWriterPut(&writer, MonoShare(&p->arr[i]));
+
+    PolyDestroy(p);
+    *p = MonosWriterFinish(&writer);
+}
+
+void PolyDestroy(Poly *p) {
+    if (PolyIsBig(p)) {
+        BigIntDestroy(p->big);
+        p->arr = NULL;
+    } else if (!PolyIsCoeff(p)) {
+        MonosHeader *header = MonosGetHeader(p->arr);
+
+        if (atomic_fetch_sub_explicit(&header->refs, 1,
+                                      memory_order_acq_rel) == 1) {
+            for (size_t i = 0; i < p->size; i++)
+                MonoDestroy(&p->arr[i]);
 
-    // Wielomian jest wielomianem zerowym
-    if (size == 0) {
-        free(p->arr);
-        *p = (Poly) {.coeff = 0, .arr = NULL};
+            MonosFree(p->arr, p->size);
+        }
+        p->arr = NULL;
     }
-        // Wielomian nie jest zerowy, ale zawiera zerowe jednomiany
-    else if (size < p->size) {
-        Mono *arr = SafeCalloc(size, sizeof(Mono));
+}
+
+Poly PolyShare(const Poly *p) {
+    if (PolyIsBig(p))
+        BigIntShare(p->big);
+    else if (!PolyIsCoeff(p))
+        atomic_fetch_add_explicit(&MonosGetHeader(p->arr)->refs, 1,
+                                  memory_order_relaxed);
+    return *p;
+}
+
+const poly_exp_t *PolyExps(const Poly *p) {
+    assert(!PolyIsCoeff(p));
+    return MonosExps(p->arr, p->size);
+}
+
+bool PolyIsShared(const Poly *p) {
+    return !PolyIsCoeff(p) && !PolyIsUnique(p);
+}
+
+bool PolyHasSharedArrays(const Poly *p) {
+    if (PolyIsCoeff(p))
+        return false;
+    if (PolyIsShared(p))
+        return true;
+
+    for (size_t i = 0; i < p->size; i++)
+        if (PolyHasSharedArrays(&p->arr[i].p))
+            return true;
+    return false;
+}
 
-        for (size_t i = 0, j = 0; i < p->size; i++)
-            if (!PolyIsZero(&p->arr[i].p))
-                arr[j++] = p->arr[i];
+Poly PolyClone(const Poly *p) {
+    Poly clone;
 
-        free(p->arr);
-        p->size = size;
-        p->arr = arr;
+    // Duże współczynniki są niezmienne, dlatego wystarczy je współdzielić.
+    if (PolyIsCoeff(p)) {
+        clone = PolyShare(p);
+    } else {
+        MonosWriter writer = NewMonosWriter(MonosAlloc(p->size), p->size);
+        for (size_t i = 0; i < p->size; i++)
+            MonosWriterPut(&writer, MonoClone(&p->arr[i]));
+        clone = MonosWriterFinish(&writer);
     }
+
+    return clone;
+}
+
+/** Arytmetyka modulo moduł współczynników. Moduł równy 0 oznacza
+ * działania modulo @f$2^{64}@f$ (patrz PolySetModulus). */
+static ModRing coeff_ring = {.mod = 0};
+
+/** Czy współczynniki są liczbami bez ograniczeń (patrz PolySetExact). */
+static bool coeff_exact = false;
+
+/**
+ * Dodaje współczynniki w bieżącym trybie współczynników.
+ * @param[in] a : współczynnik
+ * @param[in] b : współczynnik
+ * @return @f$a + b@f$
+ */
+static inline poly_coeff_t CoeffAdd(poly_coeff_t a, poly_coeff_t b) {
+    if (coeff_ring.mod == 0)
+        return a + b;
+    return (poly_coeff_t) ModAdd(&coeff_ring, (uint64_t) a, (uint64_t) b);
 }
 
 /**
- * Zwraca liczbę różnych wykładników jednomianów, które zawarte sa w tablicy @p monos.
- * @param[in] count : rozmiar tablicy @p monos
- * @param[in] monos : tablica jednomianów
- * @return liczba różnych wykładników jednomianów z tablicy @p monos
+ * Mnoży współczynniki w bieżącym trybie współczynników.
+ * @param[in] a : współczynnik
+ * @param[in] b : współczynnik
+ * @return @f$a b@f$
  */
-static size_t DistinctExponentsCount(size_t count, const Mono monos[]) {
-    size_t n = 0;
+static inline poly_coeff_t CoeffMul(poly_coeff_t a, poly_coeff_t b) {
+    if (coeff_ring.mod == 0)
+        return a * b;
+    return (poly_coeff_t) ModMul(&coeff_ring, (uint64_t) a, (uint64_t) b);
+}
 
-    for (size_t i = 0; i < count; i++) {
-        while (i < count - 1 && monos[i].exp == monos[i + 1].exp)
-            i++;
-        n++;
+/**
+ * Zapisuje liczbę jako współczynnik - liczbę mieszczącą się w typie
+ * poly_coeff_t zawsze zapisuje w tym typie. Przejmuje na własność
+ * liczbę @p a.
+ * @param[in] a : liczba
+ * @return współczynnik równy @p a
+ */
+static Poly PolyFromBigInt(BigInt *a) {
+    int64_t value;
+    if (BigIntToInt(a, &value)) {
+        BigIntDestroy(a);
+        return PolyFromCoeff(value);
     }
+    return (Poly) {.size = 0, .big = a};
+}
 
-    return n;
+/**
+ * Zapisuje współczynnik jako liczbę dowolnej wielkości.
+ * @param[in] c : współczynnik
+ * @return liczba równa @p c
+ */
+static BigInt *CoeffToBigInt(const Poly *c) {
+    if (PolyIsBig(c))
+        return BigIntShare(c->big);
+    return BigIntFromInt(c->coeff);
 }
 
 /**
- * Zwraca wielomian będący sumą wszystkich wielomianów przy
- * jednomianach z tablicy @p monos o rozważanym wykładniku.
- * Ustawia indeks @p i na indeks wskazujący na ostatni jednomian
- * z tablicy @p monos o rozważanym wykładniku.
- * @param[in] count : rozmiar tablicy monos
- * @param[in] monos : tablica jednomianów posortowanych rosnąco względem wykładnika
- * @param[in, out] i : indeks pierwszego jednomianu w tablicy @p monos o rozważanym
- *                wykładniku
- * @return wielomian będący sumą jednomianów
+ * Dodaje współczynniki w trybie dokładnym, gdy suma nie mieści się
+ * w typie poly_coeff_t lub któryś ze składników jest duży.
+ * @param[in] a : współczynnik
+ * @param[in] b : współczynnik
+ * @return @f$a + b@f$
  */
-static Poly
-PolyAddMonosWithSameExponent(size_t count, const Mono monos[], size_t *i) {
+static Poly CoeffSumBig(const Poly *a, const Poly *b) {
+    BigInt *x = CoeffToBigInt(a), *y = CoeffToBigInt(b);
+    Poly sum = PolyFromBigInt(BigIntAdd(x, y));
+    BigIntDestroy(x);
+    BigIntDestroy(y);
+    return sum;
+}
 
-    if (*i < count - 1 && monos[*i].exp == monos[*i + 1].exp) {
-        /* Dodajemy pierwsze dwa jednomiany inicjując zmienną,
-         * która będzie zawierać wynik */
-        Poly p_sum = PolyAdd(&monos[*i].p, &monos[*i + 1].p);
-        (*i)++;
+/**
+ * Mnoży współczynniki w trybie dokładnym, gdy iloczyn nie mieści się
+ * w typie poly_coeff_t lub któryś z czynników jest duży.
+ * @param[in] a : współczynnik
+ * @param[in] b : współczynnik
+ * @return @f$a b@f$
+ */
+static Poly CoeffProductBig(const Poly *a, const Poly *b) {
+    BigInt *x = CoeffToBigInt(a), *y = CoeffToBigInt(b);
+    Poly product = PolyFromBigInt(BigIntMul(x, y));
+    BigIntDestroy(x);
+    BigIntDestroy(y);
+    return product;
+}
 
-        // Dodajemy resztę jednomianów o tym samym wykładniku.
-        while (*i < count - 1 && monos[*i].exp == monos[*i + 1].exp) {
-            Poly p_temp = p_sum;
-            p_sum = PolyAdd(&p_sum, &monos[*i + 1].p);
-            PolyDestroy(&p_temp);
-            (*i)++;
-        }
+/**
+ * Dodaje współczynniki w bieżącym trybie współczynników. W trybie
+ * dokładnym sumę współczynników typu poly_coeff_t liczy bezpośrednio,
+ * sprawdzając jedynie przepełnienie.
+ * @param[in] a : współczynnik
+ * @param[in] b : współczynnik
+ * @return @f$a + b@f$
+ */
+static inline Poly CoeffSum(const Poly *a, const Poly *b) {
+    poly_coeff_t sum;
+    if (!coeff_exact)
+        return PolyFromCoeff(CoeffAdd(a->coeff, b->coeff));
+    if (!PolyIsBig(a) && !PolyIsBig(b)
+        && !__builtin_add_overflow(a->coeff, b->coeff, &sum))
+        return PolyFromCoeff(sum);
+    return CoeffSumBig(a, b);
+}
+
+/**
+ * Mnoży współczynniki w bieżącym trybie współczynników (patrz CoeffSum).
+ * @param[in] a : współczynnik
+ * @param[in] b : współczynnik
+ * @return @f$a b@f$
+ */
+static inline Poly CoeffProduct(const Poly *a, const Poly *b) {
+    poly_coeff_t product;
+    if (!coeff_exact)
+        return PolyFromCoeff(CoeffMul(a->coeff, b->coeff));
+    if (!PolyIsBig(a) && !PolyIsBig(b)
+        && !__builtin_mul_overflow(a->coeff, b->coeff, &product))
+        return PolyFromCoeff(product);
+    return CoeffProductBig(a, b);
+}
+
+/**
+ * Dodaje współczynnik do współczynnika w miejscu.
+ * @param[in, out] acc : współczynnik @f$a@f$, zastępowany przez @f$a + c@f$
+ * @param[in] c : współczynnik @f$c@f$ (może być tym samym obiektem)
+ */
+static inline void CoeffAddTo(Poly *acc, const Poly *c) {
+    poly_coeff_t sum;
+    if (!coeff_exact) {
+        acc->coeff = CoeffAdd(acc->coeff, c->coeff);
+    } else if (!PolyIsBig(acc) && !PolyIsBig(c)
+               && !__builtin_add_overflow(acc->coeff, c->coeff, &sum)) {
+        acc->coeff = sum;
+    } else {
+        Poly big_sum = CoeffSumBig(acc, c);
+        PolyDestroy(acc);
+        *acc = big_sum;
+    }
+}
 
-        return p_sum;
+/**
+ * Mnoży współczynnik przez współczynnik w miejscu.
+ * @param[in, out] acc : współczynnik @f$a@f$, zastępowany przez @f$a c@f$
+ * @param[in] c : współczynnik @f$c@f$ (może być tym samym obiektem)
+ */
+static inline void CoeffMulBy(Poly *acc, const Poly *c) {
+    poly_coeff_t product;
+    if (!coeff_exact) {
+        acc->coeff = CoeffMul(acc->coeff, c->coeff);
+    } else if (!PolyIsBig(acc) && !PolyIsBig(c)
+               && !__builtin_mul_overflow(acc->coeff, c->coeff, &product)) {
+        acc->coeff = product;
+    } else {
+        Poly big_product = CoeffProductBig(acc, c);
+        PolyDestroy(acc);
+        *acc = big_product;
+    }
+}
 
-    } // W tablicy monos jest tylko jeden jednomian o rozważanym wykładniku
+void PolySetModulus(poly_coeff_t mod) {
+    if (mod == 0)
+        coeff_ring = (ModRing) {.mod = 0};
     else
-        return PolyClone(&monos[*i].p);
+        coeff_ring = NewModRing((uint64_t) mod);
+    coeff_exact = false;
+}
+
+void PolySetExact(bool exact) {
+    coeff_exact = exact;
+    if (exact)
+        coeff_ring = (ModRing) {.mod = 0};
+}
+
+bool PolyGetExact(void) {
+    return coeff_exact;
+}
+
+bool PolyHasBigCoeffs(const Poly *p) {
+    if (!coeff_exact || PolyIsCoeff(p))
+        return PolyIsBig(p);
+
+    for (size_t i = 0; i < p->size; i++)
+        if (PolyHasBigCoeffs(&p->arr[i].p))
+            return true;
+    return false;
+}
+
+poly_coeff_t PolyGetModulus(void) {
+    return (poly_coeff_t) coeff_ring.mod;
+}
+
+poly_coeff_t PolyCoeffReduce(poly_coeff_t c) {
+    if (coeff_ring.mod == 0)
+        return c;
+    return (poly_coeff_t) ModFromSigned(&coeff_ring, c);
 }
 
 /**
-* Zwraca wielomian powstały poprzez zsumowanie jednomianów
-  zawartych w tablicy @p monos. Wynikowy wielomian
-  nie jest zredukowany do pożądanej postaci.
-* @param[in] count : liczba jednomianów
-* @param[in] monos : tablica jednomianów
-* @return wielomian będący sumą jednomianów, niezredukowany
-*/
-static Poly PolyAddMonosBrute(size_t count, const Mono monos[]) {
-    Poly p = PolyFromCoeff(0);
+ * Redukuje wielomian. Jeśli wielomian @f$p@f$ jest postaci @f$c\cdot x^0@f$,
+ * gdzie @f$c@f$ to wielomian będący współczynnikiem, upraszcza @f$p@f$ do
+ * postaci @f$c@f$.
+ * @param[in, out] p : wielomian @f$p@f$
+ */
+static void PolyReduce(Poly *p) {
+    if (!PolyIsCoeff(p) && p->size == 1 && p->arr[0].exp == 0
+        && PolyIsCoeff(&p->arr[0].p)) {
 
-    p.size = DistinctExponentsCount(count, monos);
-    p.arr = SafeCalloc(p.size, sizeof(Mono));
+        Poly p_temp = p->arr[0].p;
+        MonosFree(p->arr, 1);
+        *p = p_temp;
+    }
+}
 
-    for (size_t i = 0, j = 0; i < count; i++) {
-        Poly p_sum = PolyAddMonosWithSameExponent(count, monos, &i);
-        p.arr[j] = MonoFromPoly(&p_sum, monos[i].exp);
-        j++;
+/**
+ * Tworzy wielomian z tablicy @p monos zawierającej @p count niezerowych
+ * jednomianów posortowanych ściśle rosnąco względem wykładnika.
+ * Przejmuje na własność tablicę @p monos zaalokowaną na @p capacity
+ * jednomianów. Jeśli tablica jest za duża, zmniejsza ją do rozmiaru
+ * @p count. Redukuje wynikowy wielomian.
+ * @param[in] count : liczba jednomianów
+ * @param[in] capacity : liczba jednomianów, na które zaalokowano tablicę
+ * @param[in] monos : tablica jednomianów
+ * @return wielomian złożony z jednomianów z tablicy @p monos
+ */
+static Poly PolyFromSortedMonos(size_t count, size_t capacity, Mono *monos) {
+    if (count == 0) {
+        MonosFree(monos, capacity);
+        return PolyZero();
     }
 
+    if (count < capacity)
+        monos = MonosResize(monos, capacity, count);
+    MonosSeal(monos, count);
+
+    Poly p = {.size = count, .arr = monos};
+    PolyReduce(&p);
+
     return p;
 }
 
 /**
-* Sumuje listę jednomianów i tworzy z nich wielomian.
-* Nie przejmuje na własność zawartość tablicy @p monos.
-* @param[in] count : liczba jednomianów
-* @param[in] monos : tablica jednomianów
-* @return wielomian będący sumą jednomianów
-*/
-static Poly PolyAddMonosNoOwnershipTransfer(size_t count, const Mono monos[]) {
-
-    SortMono(count, (Mono *) monos);
-    Poly p = PolyAddMonosBrute(count, monos);
-    PolyDeleteZeros(&p);
+ * Tworzy wielomian z jednomianów zapisanych przez @p writer
+ * (patrz MonosWriterFinish). Redukuje wynikowy wielomian.
+ * @param[in, out] writer : struktura zapisująca
+ * @return wielomian złożony z zapisanych jednomianów
+ */
+static Poly PolyFromMonosWriter(MonosWriter *writer) {
+    Poly p = MonosWriterFinish(writer);
     PolyReduce(&p);
 
     return p;
 }
 
+/**
+ * Dodaje dwie tablice jednomianów posortowane ściśle rosnąco względem
+ * wykładnika. Scala je liniowo, sumując współczynniki przy równych
+ * wykładnikach i pomijając jednomiany, które się wyzerowały. Wykładniki
+ * porównuje w ciągłych tablicach @p p_exps i @p q_exps.
+ * Nie modyfikuje tablic @p p_monos i @p q_monos.
+ * @param[in] p_count : rozmiar tablicy @p p_monos
+ * @param[in] p_exps : wykładniki jednomianów z tablicy @p p_monos
+ * @param[in] p_monos : tablica jednomianów
+ * @param[in] q_count : rozmiar tablicy @p q_monos
+ * @param[in] q_exps : wykładniki jednomianów z tablicy @p q_monos
+ * @param[in] q_monos : tablica jednomianów
+ * @return wielomian będący sumą jednomianów z obu tablic
+ */
+static Poly PolyAddSortedMonos(size_t p_count, const poly_exp_t p_exps[],
+                               const Mono p_monos[], size_t q_count,
+                               const poly_exp_t q_exps[],
+                               const Mono q_monos[]) {
+    size_t capacity = p_count + q_count;
+    MonosWriter writer = NewMonosWriter(MonosAlloc(capacity), capacity);
+    size_t i = 0, j = 0;
+
+    while (i < p_count && j < q_count) {
+        if (p_exps[i] < q_exps[j]) {
+            MonosWriterPut(&writer, MonoShare(&p_monos[i++]));
+        } else if (p_exps[i] > q_exps[j]) {
+            MonosWriterPut(&writer, MonoShare(&q_monos[j++]));
+        } else {
+            Poly p_sum = PolyAdd(&p_monos[i].p, &q_monos[j].p);
+            if (!PolyIsZero(&p_sum))
+                MonosWriterPut(&writer, MonoFromPoly(&p_sum, p_exps[i]));
+            i++;
+            j++;
+        }
+    }
+
+    while (i < p_count)
+        MonosWriterPut(&writer, MonoShare(&p_monos[i++]));
+    while (j < q_count)
+        MonosWriterPut(&writer, MonoShare(&q_monos[j++]));
+
+    return PolyFromMonosWriter(&writer);
+}
+
 Poly PolyAdd(const Poly *p, const Poly *q) {
     if (PolyIsCoeff(p) && PolyIsCoeff(q))
-        return (Poly) {.coeff = p->coeff + q->coeff, .arr = NULL};
+        return CoeffSum(p, q);
 
     if (PolyIsCoeff(q))
         return PolyAdd(q, p);
 
-    size_t count;
-    Mono *monos;
     if (PolyIsCoeff(p)) {
+        if (PolyIsZero(p))
+            return PolyShare(q);
+
+        /* Współczynnik traktujemy jak jednoelementową tablicę
+         * z jednomianem o wykładniku 0. */
         Mono m = MonoFromPoly(p, 0);
-        monos = MergeMonoArrays(&m, q->arr, 1, q->size);
-        count = q->size + 1;
+        return PolyAddSortedMonos(1, &m.exp, &m, q->size,
+                                  MonosExps(q->arr, q->size), q->arr);
     }
-        // Wielomiany p i q nie są współczynnikami
-    else {
-        monos = MergeMonoArrays(p->arr, q->arr, p->size, q->size);
-        count = p->size + q->size;
+
+    // Wielomiany p i q nie są współczynnikami
+    return PolyAddSortedMonos(p->size, MonosExps(p->arr, p->size), p->arr,
+                              q->size, MonosExps(q->arr, q->size), q->arr);
+}
+
+/**
+ * Dodaje w miejscu do wielomianu @p acc jednomiany z tablicy @p monos
+ * posortowanej ściśle rosnąco względem wykładnika. Powiększa tablicę
+ * jednomianów wielomianu @p acc i scala obie tablice od końca, dzięki
+ * czemu jednomiany o wykładnikach większych od wszystkich wykładników
+ * @p acc są tylko dopisywane. Przejmuje na własność jednomiany z tablicy
+ * @p monos, ale nie samą tablicę.
+ * @param[in, out] acc : wielomian niebędący współczynnikiem
+ * @param[in] count : rozmiar tablicy @p monos
+ * @param[in] monos : tablica jednomianów
+ */
+static void PolyAddMonosInPlace(Poly *acc, size_t count, Mono monos[]) {
+    PolyMakeUnique(acc);
+    size_t total = acc->size + count;
+    Mono *arr = MonosResize(acc->arr, acc->size, total);
+    size_t i = acc->size, j = count, k = total;
+
+    // Wypełniamy tablicę od końca, k wskazuje za ostatnie zapisane miejsce.
+    while (j > 0) {
+        if (i > 0 && arr[i - 1].exp > monos[j - 1].exp) {
+            arr[--k] = arr[--i];
+        } else if (i > 0 && arr[i - 1].exp == monos[j - 1].exp) {
+            Mono m = arr[--i];
+            PolyAddTo(&m.p, &monos[--j].p);
+            if (!PolyIsZero(&m.p))
+                arr[--k] = m;
+        } else {
+            arr[--k] = monos[--j];
+        }
     }
 
-    Poly p_sum = PolyAddMonosNoOwnershipTransfer(count, monos);
-    free(monos);
+    // Jednomiany arr[0..i) są na miejscu, za nimi może powstać luka.
+    size_t tail = total - k;
+    if (k > i)
+        memmove(arr + i, arr + k, tail * sizeof(Mono));
 
-    return p_sum;
+    *acc = PolyFromSortedMonos(i + tail, total, arr);
 }
 
-Poly PolyAddMonos(size_t count, const Mono monos[]) {
-    if (count == 0)
-        return PolyFromCoeff(0);
+void PolyAddTo(Poly *acc, Poly *p) {
+    if (PolyIsCoeff(p)) {
+        if (PolyIsCoeff(acc)) {
+            CoeffAddTo(acc, p);
+            if (PolyIsBig(p))
+                PolyDestroy(p);
+        } else if (!PolyIsZero(p)) {
+            /* Współczynnik traktujemy jak jednoelementową tablicę
+             * z jednomianem o wykładniku 0. */
+            Mono m = MonoFromPoly(p, 0);
+            PolyAddMonosInPlace(acc, 1, &m);
+        }
+        *p = PolyZero();
+        return;
+    }
+
+    if (PolyIsCoeff(acc)) {
+        // Przejmujemy tablicę p i dodajemy do niej współczynnik.
+        Poly coeff = *acc;
+        *acc = *p;
+        *p = coeff;
+        PolyAddTo(acc, p);
+        return;
+    }
+
+    PolyMakeUnique(p);
+    PolyAddMonosInPlace(acc, p->size, p->arr);
+    MonosFree(p->arr, p->size);
+    *p = PolyZero();
+}
+
+/**
+ * Dopisuje jednomian na koniec tablicy jednomianów, w razie potrzeby
+ * dwukrotnie ją powiększając.
+ * @param[in, out] monos : wskaźnik na tablicę jednomianów
+ * @param[in, out] count : wskaźnik na liczbę jednomianów w tablicy
+ * @param[in, out] capacity : wskaźnik na liczbę jednomianów, na które
+ *                            zaalokowano tablicę
+ * @param[in] m : jednomian
+ */
+static void MonosAppend(Mono **monos, size_t *count, size_t *capacity,
+                        Mono m) {
+    if (*count == *capacity) {
+        size_t new_capacity = *capacity == 0 ? 1 : 2 * *capacity;
+        *monos = MonosResize(*monos, *capacity, new_capacity);
+        *capacity = new_capacity;
+    }
+    (*monos)[(*count)++] = m;
+}
+
+PolyBuilder NewPolyBuilder(size_t capacity) {
+    return (PolyBuilder) {.monos = capacity == 0 ? NULL : MonosAlloc(capacity),
+                          .count = 0, .capacity = capacity, .sorted = true};
+}
+
+void PolyBuilderAdd(PolyBuilder *builder, Mono *m) {
+    if (PolyIsZero(&m->p))
+        return;
+
+    if (builder->count > 0) {
+        Mono *last = &builder->monos[builder->count - 1];
+
+        // Jednomian o wykładniku ostatniego dodajemy od razu.
+        if (m->exp == last->exp) {
+            PolyAddTo(&last->p, &m->p);
+            if (PolyIsZero(&last->p))
+                builder->count--;
+            return;
+        }
+        if (m->exp < last->exp)
+            builder->sorted = false;
+    }
+
+    MonosAppend(&builder->monos, &builder->count, &builder->capacity, *m);
+    m->p = PolyZero();
+}
+
+Poly PolyBuilderFinish(PolyBuilder *builder) {
+    Mono *monos = builder->monos;
+    size_t count = builder->count, capacity = builder->capacity;
+    bool sorted = builder->sorted;
+    *builder = NewPolyBuilder(0);
+
+    if (sorted)
+        return PolyFromSortedMonos(count, capacity, monos);
+
+    MonoSort(count, monos);
+
+    // Sumujemy jednomiany o równych wykładnikach i pomijamy zerowe.
+    size_t unique = 0;
+    for (size_t i = 0; i < count;) {
+        Mono m = monos[i++];
+        while (i < count && monos[i].exp == m.exp)
+            PolyAddTo(&m.p, &monos[i++].p);
+        if (!PolyIsZero(&m.p))
+            monos[unique++] = m;
+    }
 
-    // Kopiujemy tablicę monos.
-    Mono *monos_copy = MergeMonoArrays(NULL, (Mono *) monos, 0, count);
+    return PolyFromSortedMonos(unique, capacity, monos);
+}
 
-    Poly p = PolyAddMonosNoOwnershipTransfer(count, monos_copy);
-    free(monos_copy);
+void PolyBuilderDestroy(PolyBuilder *builder) {
+    for (size_t i = 0; i < builder->count; i++)
+        MonoDestroy(&builder->monos[i]);
+    MonosFree(builder->monos, builder->capacity);
+    *builder = NewPolyBuilder(0);
+}
+
+Poly PolyAddMonos(size_t count, const Mono monos[]) {
+    PolyBuilder builder = NewPolyBuilder(count);
     for (size_t i = 0; i < count; i++)
-        MonoDestroy((Mono *) &monos[i]);
+        PolyBuilderAdd(&builder, (Mono *) &monos[i]);
 
-    return p;
+    return PolyBuilderFinish(&builder);
 }
 
+static Poly PolyMulRecursive(const Poly *p, const Poly *q);
+
 /**
  * Zwraca wielomian będący sumą iloczynów jednomianów
  * zawartych w tablicach @p p_monos i @p q_monos. Mnoży każdy
  * jednomian z tablicy @p p_monos z każdym jednomianem z tablicy
  * @p q_monos, i zwraca sumę tych iloczynów.
+ * Iloczyny generowane są w kolejności rosnących wykładników przy użyciu
+ * kopca (algorytm Johnsona), a iloczyny o równych wykładnikach są od razu
+ * sumowane. Kopiec zawiera co najwyżej @p p_count elementów, dlatego
+ * zużycie pamięci zależy od rozmiaru wyniku, a nie od liczby iloczynów.
+ * Wykładniki iloczynów wyznaczane są z ciągłych tablic @p p_exps
+ * i @p q_exps.
  * @param[in] p_count : rozmiar tablicy @p p_monos
- * @param[in] p_monos : tablica jednomianów
+ * @param[in] p_exps : wykładniki jednomianów z tablicy @p p_monos
+ * @param[in] p_monos : tablica jednomianów posortowana rosnąco
  * @param[in] q_count : rozmiar tablicy @p q_monos
- * @param[in] q_monos : tablica jednomianów
+ * @param[in] q_exps : wykładniki jednomianów z tablicy @p q_monos
+ * @param[in] q_monos : tablica jednomianów posortowana rosnąco
+ * @return wielomian będący sumą iloczynów jednomianów
+ * zawartych w tablicach @p p_monos i @p q_monos
+ */
+static Poly PolyMulMonos(size_t p_count, const poly_exp_t *p_exps,
+                         const Mono *p_monos, size_t q_count,
+                         const poly_exp_t *q_exps, const Mono *q_monos) {
+    // Kopiec ma rozmiar krótszej z tablic.
+    if (p_count > q_count)
+        return PolyMulMonos(q_count, q_exps, q_monos,
+                            p_count, p_exps, p_monos);
+
+    IndexHeap heap = NewIndexHeap(p_count);
+    MonosWriter writer = NewMonosWriter(NULL, 0);
+
+    IndexHeapPush(&heap, (IndexPair) {
+            .exp = p_exps[0] + q_exps[0], .i = 0, .j = 0});
+
+    while (!IndexHeapEmpty(heap)) {
+        poly_exp_t exp = IndexHeapMinExp(heap);
+        Poly p_sum = PolyZero();
+
+        // Sumujemy wszystkie iloczyny o wykładniku exp.
+        while (!IndexHeapEmpty(heap) && IndexHeapMinExp(heap) == exp) {
+            IndexPair pair = IndexHeapPop(&heap);
+            Poly product = PolyMulRecursive(&p_monos[pair.i].p,
+                                            &q_monos[pair.j].p);
+            PolyAddTo(&p_sum, &product);
+
+            /* Kolejnym iloczynem w wierszu i jest (i, j + 1). Wiersz i + 1
+             * rozpoczynamy, gdy pobraliśmy pierwszy iloczyn wiersza i. */
+            if (pair.j + 1 < q_count)
+                IndexHeapPush(&heap, (IndexPair) {
+                        .exp = p_exps[pair.i] + q_exps[pair.j + 1],
+                        .i = pair.i, .j = pair.j + 1});
+            if (pair.j == 0 && pair.i + 1 < p_count)
+                IndexHeapPush(&heap, (IndexPair) {
+                        .exp = p_exps[pair.i + 1] + q_exps[0],
+                        .i = pair.i + 1, .j = 0});
+        }
+
+        if (!PolyIsZero(&p_sum))
+            MonosWriterPut(&writer, MonoFromPoly(&p_sum, exp));
+    }
+    IndexHeapDestroy(heap);
+
+    return PolyFromMonosWriter(&writer);
+}
+
+/**
+ * Minimalna liczba iloczynów jednomianów najwyższego poziomu, od której
+ * mnożenie jest wykonywane równolegle.
+ */
+#define PARALLEL_MUL_MIN_PRODUCTS 4096
+
+/** Liczba fragmentów czynnika przypadających na jeden wątek puli. */
+#define PARALLEL_MUL_CHUNKS_PER_THREAD 4
+
+/** Pula wątków mnożenia lub NULL, gdy mnożenie jest sekwencyjne. */
+static ThreadPool *mul_pool = NULL;
+
+void PolySetThreads(size_t threads) {
+    assert(threads > 0);
+    if (mul_pool != NULL) {
+        ThreadPoolDestroy(mul_pool);
+        mul_pool = NULL;
+    }
+    if (threads > 1)
+        mul_pool = NewThreadPool(threads);
+}
+
+size_t PolyGetThreads(void) {
+    return mul_pool == NULL ? 1 : ThreadPoolSize(mul_pool);
+}
+
+/**
+ * Sprawdza, czy iloczyn wielomianów należy wyliczyć na puli wątków
+ * mnożenia. Mnożenia wywołane wewnątrz zadań puli są sekwencyjne.
+ * @param[in] p : wielomian @f$p@f$
+ * @param[in] q : wielomian @f$q@f$
+ * @return Czy mnożenie wykonać równolegle?
+ */
+static bool MulInParallel(const Poly *p, const Poly *q) {
+    return mul_pool != NULL && !ThreadPoolInTask()
+           && !PolyIsCoeff(p) && !PolyIsCoeff(q)
+           && p->size * q->size >= PARALLEL_MUL_MIN_PRODUCTS;
+}
+
+/**
+ * To jest struktura opisująca zadanie wymnożenia fragmentu jednej
+ * tablicy jednomianów przez drugą tablicę.
+ */
+typedef struct MulChunk {
+    size_t p_count; ///< rozmiar fragmentu pierwszej tablicy
+    const poly_exp_t *p_exps; ///< wykładniki fragmentu pierwszej tablicy
+    const Mono *p_monos; ///< fragment pierwszej tablicy
+    size_t q_count; ///< rozmiar drugiej tablicy
+    const poly_exp_t *q_exps; ///< wykładniki drugiej tablicy
+    const Mono *q_monos; ///< druga tablica
+    Poly res; ///< wynik - posortowany iloczyn częściowy
+} MulChunk;
+
+/**
+ * Wykonuje zadanie typu MulChunk.
+ * @param[in, out] arg : wskaźnik na zadanie
+ */
+static void MulChunkRun(void *arg) {
+    MulChunk *chunk = arg;
+    chunk->res = PolyMulMonos(chunk->p_count, chunk->p_exps, chunk->p_monos,
+                              chunk->q_count, chunk->q_exps, chunk->q_monos);
+}
+
+/** To jest struktura opisująca zadanie dodania do siebie dwóch wielomianów. */
+typedef struct AddPair {
+    Poly *p; ///< pierwszy składnik, zastępowany przez sumę
+    Poly *q; ///< drugi składnik, usuwany
+} AddPair;
+
+/**
+ * Wykonuje zadanie typu AddPair.
+ * @param[in, out] arg : wskaźnik na zadanie
+ */
+static void AddPairRun(void *arg) {
+    AddPair *pair = arg;
+    PolyAddTo(pair->p, pair->q);
+}
+
+/**
+ * Sumuje wielomiany z tablicy @p polys na puli wątków mnożenia. Pary
+ * dodawane są w tym samym zrównoważonym drzewie co w PolySumBalanced,
+ * a każdy poziom drzewa wykonywany jest równolegle. Kształt drzewa nie
+ * zależy od liczby wątków, dlatego wynik również.
+ * Usuwa wielomiany z tablicy @p polys. Zakłada, że tablica jest niepusta.
+ * @param[in] count : rozmiar tablicy @p polys
+ * @param[in, out] polys : tablica wielomianów
+ * @return suma wielomianów z tablicy @p polys
+ */
+static Poly PolySumParallel(size_t count, Poly polys[]) {
+    assert(count > 0);
+    AddPair *pairs = SafeCalloc(count, sizeof(AddPair));
+    Task *tasks = SafeCalloc(count, sizeof(Task));
+
+    for (size_t step = 1; step < count; step *= 2) {
+        size_t pairs_count = 0;
+        for (size_t i = 0; i + step < count; i += 2 * step) {
+            pairs[pairs_count] = (AddPair) {.p = &polys[i],
+                                            .q = &polys[i + step]};
+            tasks[pairs_count] = (Task) {.run = AddPairRun,
+                                         .arg = &pairs[pairs_count]};
+            pairs_count++;
+        }
+        ThreadPoolRun(mul_pool, pairs_count, tasks);
+    }
+
+    free(pairs);
+    free(tasks);
+
+    return polys[0];
+}
+
+/**
+ * Mnoży tablice jednomianów równolegle. Dłuższa tablica dzielona jest
+ * na fragmenty, które wątki puli mnożą przez krótszą tablicę, a otrzymane
+ * posortowane iloczyny częściowe są scalane parami w zrównoważonym
+ * drzewie, którego każdy poziom również wykonywany jest równolegle.
+ * Mnożenia współczynników jednomianów wewnątrz zadań są sekwencyjne.
+ * @param[in] p_count : rozmiar tablicy @p p_monos
+ * @param[in] p_exps : wykładniki jednomianów z tablicy @p p_monos
+ * @param[in] p_monos : tablica jednomianów posortowana rosnąco
+ * @param[in] q_count : rozmiar tablicy @p q_monos
+ * @param[in] q_exps : wykładniki jednomianów z tablicy @p q_monos
+ * @param[in] q_monos : tablica jednomianów posortowana rosnąco
  * @return wielomian będący sumą iloczynów jednomianów
  * zawartych w tablicach @p p_monos i @p q_monos
  */
+static Poly PolyMulMonosParallel(size_t p_count, const poly_exp_t *p_exps,
+                                 const Mono *p_monos, size_t q_count,
+                                 const poly_exp_t *q_exps,
+                                 const Mono *q_monos) {
+    if (p_count < q_count)
+        return PolyMulMonosParallel(q_count, q_exps, q_monos,
+                                    p_count, p_exps, p_monos);
+
+    size_t count = ThreadPoolSize(mul_pool) * PARALLEL_MUL_CHUNKS_PER_THREAD;
+    if (count > p_count)
+        count = p_count;
+
+    MulChunk *chunks = SafeCalloc(count, sizeof(MulChunk));
+    Task *tasks = SafeCalloc(count, sizeof(Task));
+    for (size_t i = 0; i < count; i++) {
+        size_t begin = i * p_count / count, end = (i + 1) * p_count / count;
+        chunks[i] = (MulChunk) {.p_count = end - begin,
+                                .p_exps = p_exps + begin,
+                                .p_monos = p_monos + begin,
+                                .q_count = q_count, .q_exps = q_exps,
+                                .q_monos = q_monos};
+        tasks[i] = (Task) {.run = MulChunkRun, .arg = &chunks[i]};
+    }
+    ThreadPoolRun(mul_pool, count, tasks);
+
+    Poly *polys = SafeCalloc(count, sizeof(Poly));
+    for (size_t i = 0; i < count; i++)
+        polys[i] = chunks[i].res;
+    free(chunks);
+    free(tasks);
+
+    Poly res = PolySumParallel(count, polys);
+    free(polys);
+
+    return res;
+}
+
+/**
+ * Mnoży wielomian przez współczynnik (patrz PolyMulByCoeff).
+ * @param[in] p : wielomian @f$p@f$
+ * @param[in] c : współczynnik @f$c@f$
+ * @return @f$c \cdot p@f$
+ */
+static Poly PolyScale(const Poly *p, const Poly *c) {
+    if (PolyIsCoeff(p))
+        return CoeffProduct(p, c);
+    if (PolyIsZero(c))
+        return PolyZero();
+    if (c->arr == NULL && c->coeff == 1)
+        return PolyShare(p);
+
+    MonosWriter writer = NewMonosWriter(MonosAlloc(p->size), p->size);
+    for (size_t i = 0; i < p->size; i++) {
+        Poly p_scaled = PolyScale(&p->arr[i].p, c);
+        if (!PolyIsZero(&p_scaled))
+            MonosWriterPut(&writer, MonoFromPoly(&p_scaled, p->arr[i].exp));
+    }
+
+    return PolyFromMonosWriter(&writer);
+}
+
+Poly PolyMulByCoeff(const Poly *p, poly_coeff_t c) {
+    Poly coeff = PolyFromCoeff(PolyCoeffReduce(c));
+    return PolyScale(p, &coeff);
+}
+
+/**
+ * Mnoży wielomian przez współczynnik w miejscu
+ * (patrz PolyMulByCoeffInPlace).
+ * @param[in, out] p : wielomian @f$p@f$, zastępowany przez @f$c \cdot p@f$
+ * @param[in] c : współczynnik @f$c@f$
+ */
+static void PolyScaleInPlace(Poly *p, const Poly *c) {
+    if (PolyIsCoeff(p)) {
+        CoeffMulBy(p, c);
+        return;
+    }
+    if (PolyIsZero(c)) {
+        PolyDestroy(p);
+        *p = PolyZero();
+        return;
+    }
+    if (c->arr == NULL && c->coeff == 1)
+        return;
+
+    PolyMakeUnique(p);
+    size_t count = 0;
+    for (size_t i = 0; i < p->size; i++) {
+        PolyScaleInPlace(&p->arr[i].p, c);
+        if (!PolyIsZero(&p->arr[i].p))
+            p->arr[count++] = p->arr[i];
+    }
 
-static Poly PolyMulMonos(size_t p_count, Mono *p_monos,
-                         size_t q_count, Mono *q_monos) {
+    /* Gdy żaden jednomian się nie wyzerował, tablica zachowuje swój
+     * kształt i nie wymaga żadnej alokacji, ale zmieniły się
+     * współczynniki, a z nimi opis wielomianu. Tablica jest wtedy
+     * w pamięci podręcznej, więc osobny przebieg MonosSeal jest tańszy
+     * niż ponowne zapisywanie jednomianów przez MonosWriter. */
+    if (count < p->size)
+        *p = PolyFromSortedMonos(count, p->size, p->arr);
+    else
+        MonosSeal(p->arr, p->size);
+}
 
-    Mono *monos = SafeCalloc(p_count * q_count, sizeof(Mono));
+void PolyMulByCoeffInPlace(Poly *p, poly_coeff_t c) {
+    Poly coeff = PolyFromCoeff(PolyCoeffReduce(c));
+    PolyScaleInPlace(p, &coeff);
+}
 
-    for (size_t i = 0, z = 0; i < p_count; i++) {
-        for (size_t j = 0; j < q_count; j++) {
-            Poly p_mul = PolyMul(&p_monos[i].p, &q_monos[j].p);
-            monos[z++] = MonoFromPoly(&p_mul, p_monos[i].exp + q_monos[j].exp);
-        }
+Poly PolyReduceCoeffs(const Poly *p) {
+    if (PolyIsBig(p)) {
+        if (coeff_exact)
+            return PolyShare(p);
+        if (coeff_ring.mod == 0)
+            return PolyFromCoeff((poly_coeff_t) BigIntLowWord(p->big));
+        return PolyFromCoeff(
+                (poly_coeff_t) BigIntModWord(p->big, coeff_ring.mod));
     }
+    if (PolyIsCoeff(p))
+        return PolyFromCoeff(PolyCoeffReduce(p->coeff));
 
-    Poly res = PolyAddMonos(p_count * q_count, monos);
-    free(monos);
+    MonosWriter writer = NewMonosWriter(MonosAlloc(p->size), p->size);
+    for (size_t i = 0; i < p->size; i++) {
+        Poly coeff = PolyReduceCoeffs(&p->arr[i].p);
+        if (!PolyIsZero(&coeff))
+            MonosWriterPut(&writer, MonoFromPoly(&coeff, p->arr[i].exp));
+    }
 
-    return res;
+    return PolyFromMonosWriter(&writer);
 }
 
-Poly PolyMul(const Poly *p, const Poly *q) {
+/**
+ * Mnoży wielomiany, wymnażając rekurencyjnie ich jednomiany, bez próby
+ * podstawienia Kroneckera. Służy do mnożenia współczynników wewnątrz
+ * PolyMulMonos - gdy podstawienie nie opłacało się dla całych
+ * wielomianów, zwykle nie opłaca się też dla ich współczynników.
+ * @param[in] p : wielomian @f$p@f$
+ * @param[in] q : wielomian @f$q@f$
+ * @return @f$p * q@f$
+ */
+static Poly PolyMulRecursive(const Poly *p, const Poly *q) {
     if (PolyIsCoeff(p) && PolyIsCoeff(q))
-        return (Poly) {.coeff = p->coeff * q->coeff, .arr = NULL};
+        return CoeffProduct(p, q);
 
     if (PolyIsCoeff(q))
-        return PolyMul(q, p);
+        return PolyScale(p, q);
 
-    if (PolyIsCoeff(p)) {
-        Mono m = MonoFromPoly(p, 0);
-        return PolyMulMonos(1, &m, q->size, q->arr);
-    }
+    if (PolyIsCoeff(p))
+        return PolyScale(q, p);
 
     // Wielomiany p i q nie są współczynnikami
-    return PolyMulMonos(p->size, p->arr, q->size, q->arr);
+    if (MulInParallel(p, q))
+        return PolyMulMonosParallel(p->size, MonosExps(p->arr, p->size),
+                                    p->arr, q->size,
+                                    MonosExps(q->arr, q->size), q->arr);
+
+    return PolyMulMonos(p->size, MonosExps(p->arr, p->size), p->arr,
+                        q->size, MonosExps(q->arr, q->size), q->arr);
+}
+
+Poly PolyMul(const Poly *p, const Poly *q) {
+    /* Wielomiany o niewielu zmiennych i ograniczonych stopniach mnożymy
+     * jak wielomiany jednej zmiennej. Podstawienie Kroneckera działa
+     * w jednym wątku, dlatego duże iloczyny przy włączonej puli wątków
+     * liczymy równolegle. */
+    Poly res;
+    if (!MulInParallel(p, q) && PolyMulKronecker(p, q, &res))
+        return res;
+
+    return PolyMulRecursive(p, q);
+}
+
+void PolyMulAddTo(Poly *acc, const Poly *p, const Poly *q) {
+    Poly product = PolyMul(p, q);
+    PolyAddTo(acc, &product);
 }
 
 Poly PolyNeg(const Poly *p) {
-    Poly q = PolyFromCoeff(-1);
-    return PolyMul(p, &q);
+    return PolyMulByCoeff(p, -1);
 }
 
 Poly PolySub(const Poly *p, const Poly *q) {
@@ -355,19 +1289,23 @@ poly_exp_t PolyDegBy(const Poly *p, size_t var_idx) {
             return -1;
         if (PolyIsCoeff(p))
             return 0;
-        return p->arr[p->size - 1].exp;
+        return MonosExps(p->arr, p->size)[p->size - 1];
     }
 
     /* Przypadki gdy sprawdzamy stopień względem zmiennej,
      * której nie reprezentuje dany wielomian. */
     if (PolyIsZero(p))
         return -1;
-    if (PolyIsCoeff(p))
+    if (PolyIsCoeff(p) || var_idx >= MonosGetHeader(p->arr)->depth)
         return 0;
 
+    /* Stopień współczynnika względem dowolnej zmiennej nie przekracza
+     * jego stopnia zapisanego w nagłówku, więc pomijamy współczynniki,
+     * które nie mogą zwiększyć wyniku. */
     poly_exp_t res = -1;
     for (size_t i = 0; i < p->size; i++)
-        res = max(res, PolyDegBy(&p->arr[i].p, var_idx - 1));
+        if (PolyDeg(&p->arr[i].p) > res)
+            res = max(res, PolyDegBy(&p->arr[i].p, var_idx - 1));
 
     return res;
 }
@@ -378,39 +1316,66 @@ poly_exp_t PolyDeg(const Poly *p) {
     if (PolyIsCoeff(p))
         return 0;
 
-    poly_exp_t res = -1;
-    for (size_t i = 0; i < p->size; i++)
-        res = max(res, PolyDeg(&p->arr[i].p) + p->arr[i].exp);
+    return MonosGetHeader(p->arr)->deg;
+}
 
-    return res;
+uint64_t PolyHash(const Poly *p) {
+    // Równe duże liczby mają równe najmłodsze słowa.
+    if (PolyIsBig(p))
+        return HashMix(BigIntLowWord(p->big));
+    if (PolyIsCoeff(p))
+        return (uint64_t) p->coeff;
+
+    return MonosGetHeader(p->arr)->hash;
 }
 
-/**
- * Sprawdza równość dwóch jednomianów
- * @param[in] m : jednomian
- * @param[in] n : jednomian
- * @return prawda gdy @f$ m = n @f$, fałsz w przeciwnym przypadku
- */
-static bool MonoIsEq(const Mono *m, const Mono *n) {
-    if (m->exp == n->exp)
-        return PolyIsEq(&m->p, &n->p);
+size_t PolyTerms(const Poly *p) {
+    if (PolyIsCoeff(p))
+        return PolyIsZero(p) ? 0 : 1;
 
-    return false;
+    return MonosGetHeader(p->arr)->terms;
 }
 
 bool PolyIsEq(const Poly *p, const Poly *q) {
-    if (PolyIsCoeff(p) && PolyIsCoeff(q))
+    if (PolyIsCoeff(p) && PolyIsCoeff(q)) {
+        // Liczby mieszczące się w typie poly_coeff_t nigdy nie są duże.
+        if (PolyIsBig(p) || PolyIsBig(q))
+            return PolyIsBig(p) && PolyIsBig(q)
+                   && BigIntIsEq(p->big, q->big);
         return p->coeff == q->coeff;
+    }
+
+    // Wielomiany współdzielące tablicę jednomianów są równe.
+    if (p->arr == q->arr)
+        return true;
 
     else if (!PolyIsCoeff(p) && !PolyIsCoeff(q) && p->size == q->size) {
+        const MonosHeader *p_header = MonosGetHeader(p->arr);
+        const MonosHeader *q_header = MonosGetHeader(q->arr);
+
+        // Wielomiany o różnych opisach są różne.
+        if (p_header->hash != q_header->hash
+            || p_header->terms != q_header->terms
+            || p_header->deg != q_header->deg)
+            return false;
+
+        const poly_exp_t *p_exps = MonosExps(p->arr, p->size);
+        const poly_exp_t *q_exps = MonosExps(q->arr, q->size);
+
+        /* Wykładniki porównujemy w ciągłych tablicach, zanim zaczniemy
+         * rekurencyjnie porównywać współczynniki. */
+        if (memcmp(p_exps, q_exps, p->size * sizeof(poly_exp_t)) != 0)
+            return false;
+
         for (size_t i = 0; i < p->size; i++) {
             /* Sprawdzamy czy jest spełniony niezmiennik dotyczący
-             * uporządkowania jednomianów. */
-            assert(i == 0 ||
-                   (MonoGetExp(&p->arr[i]) > MonoGetExp(&p->arr[i - 1]) &&
-                    MonoGetExp(&q->arr[i]) > MonoGetExp(&q->arr[i - 1])));
+             * uporządkowania jednomianów oraz zgodność tablicy wykładników
+             * z jednomianami. */
+            assert(i == 0 || (p_exps[i] > p_exps[i - 1]
+                              && q_exps[i] > q_exps[i - 1]));
+            assert(p_exps[i] == MonoGetExp(&p->arr[i]));
 
-            if (!MonoIsEq(&p->arr[i], &q->arr[i]))
+            if (!PolyIsEq(&p->arr[i].p, &q->arr[i].p))
                 return false;
         }
 
@@ -433,64 +1398,328 @@ static poly_coeff_t Exponantiate(poly_coeff_t x, poly_exp_t exp) {
 
     poly_coeff_t temp = Exponantiate(x, exp / 2);
     if (exp % 2 == 0)
-        return temp * temp;
+        return CoeffMul(temp, temp);
+
+    return CoeffMul(CoeffMul(temp, temp), x);
+}
+
+/**
+ * Podnosi liczbę @p x do potęgi @p exp (patrz Exponantiate), sprawdzając
+ * przepełnienie typu poly_coeff_t.
+ * @param[in] x : potęgowana liczba
+ * @param[in] exp : wykładnik potęgi
+ * @param[out] res : @f$ x^{exp} @f$, ustawiane, gdy nie ma przepełnienia
+ * @return Czy potęga mieści się w typie poly_coeff_t?
+ */
+static bool ExponantiateChecked(poly_coeff_t x, poly_exp_t exp,
+                                poly_coeff_t *res) {
+    if (exp == 0) {
+        *res = 1;
+        return true;
+    }
+
+    poly_coeff_t temp;
+    return ExponantiateChecked(x, exp / 2, &temp)
+           && !__builtin_mul_overflow(temp, temp, res)
+           && (exp % 2 == 0 || !__builtin_mul_overflow(*res, x, res));
+}
+
+/**
+ * Zwraca wartość współczynnika @p x podniesionego do potęgi @p exp
+ * w trybie dokładnym (patrz Exponantiate).
+ * @param[in] x : potęgowany współczynnik
+ * @param[in] exp : wykładnik potęgi
+ * @return @f$ x^{exp} @f$
+ */
+static Poly ExponantiateExact(const Poly *x, poly_exp_t exp) {
+    if (exp == 0)
+        return PolyFromCoeff(1);
+
+    Poly res = ExponantiateExact(x, exp / 2);
+    CoeffMulBy(&res, &res);
+    if (exp % 2 != 0)
+        CoeffMulBy(&res, x);
+
+    return res;
+}
+
+/**
+ * Mnoży współczynnik w miejscu przez potęgę współczynnika.
+ * @param[in, out] acc : współczynnik @f$a@f$, zastępowany przez
+ *                       @f$a x^{exp}@f$
+ * @param[in] x : potęgowany współczynnik
+ * @param[in] exp : wykładnik potęgi
+ */
+static inline void CoeffMulByPower(Poly *acc, const Poly *x, poly_exp_t exp) {
+    poly_coeff_t small_power;
+    if (!coeff_exact) {
+        acc->coeff = CoeffMul(acc->coeff, Exponantiate(x->coeff, exp));
+        return;
+    }
+    if (!PolyIsBig(x) && ExponantiateChecked(x->coeff, exp, &small_power)) {
+        Poly power = PolyFromCoeff(small_power);
+        CoeffMulBy(acc, &power);
+        return;
+    }
 
-    return temp * temp * x;
+    Poly power = ExponantiateExact(x, exp);
+    CoeffMulBy(acc, &power);
+    PolyDestroy(&power);
 }
 
 /**
- * Tworzy tablicę @p monos jednomianów powstałych poprzez
- * podstawienie za zmienną @f$x_0@f$ w jednomianach zawartych w
- * wielomianie @p p, wartości @p x i "opakowanie"  tak utworzonych
- * wielomianów w sztuczną zmienną o wykładniku 0.
- * Wielomian będący iloczynem wielomianu stojącego
- * przy jednomianie oraz wartości @p x podniesionej do odpowiedniej potęgi,
- * zamieniamy w jednomian nowej zmiennej o wykładniku 0 i zapisujemy
- * w tablicy @p monos. Umożliwi nam to później wywołanie funkcji
- * PolyAddMonos w celu obliczenia wyniku funkcji PolyAt.
+ * Sumuje wielomiany z tablicy @p polys, dodając je parami
+ * w zrównoważonym drzewie. Dzięki temu każdy jednomian bierze udział
+ * w co najwyżej @f$\lceil \log_2 count \rceil@f$ scaleniach.
+ * Usuwa wielomiany z tablicy @p polys. Zakłada, że tablica jest niepusta.
+ * @param[in] count : rozmiar tablicy @p polys
+ * @param[in, out] polys : tablica wielomianów
+ * @return suma wielomianów z tablicy @p polys
+ */
+static Poly PolySumBalanced(size_t count, Poly polys[]) {
+    assert(count > 0);
+    for (size_t step = 1; step < count; step *= 2)
+        for (size_t i = 0; i + step < count; i += 2 * step)
+            PolyAddTo(&polys[i], &polys[i + step]);
+
+    return polys[0];
+}
+
+/**
+ * Wylicza sumę @f$\sum c_i x^{e_i}@f$ po tych jednomianach
+ * @f$c_i x_0^{e_i}@f$ wielomianu @p p, których współczynniki
+ * @f$c_i@f$ są liczbami. Korzysta ze schematu Hornera, przechodząc
+ * od najwyższego wykładnika i mnożąc akumulator przez
+ * @f$x^{e_{i+1} - e_i}@f$.
  * @param[in] p : wielomian niebędący współczynnikiem
- * @param[in] x : wartość, którą podstawiamy za zmienną
- * @return tablica jednomianów powstałych w opisany wyżej sposób
+ * @param[in] x : współczynnik, który podstawiamy za zmienną
+ * @return wartość sumy
  */
-static Mono *MonosAtFromPoly(const Poly *p, poly_coeff_t x) {
-    assert(!PolyIsCoeff(p));
-    Mono *monos = SafeCalloc(p->size, sizeof(Mono));
-    Poly p_coeff, p_mul;
+static Poly CoeffMonosAt(const Poly *p, const Poly *x) {
+    Poly acc = PolyZero();
+    poly_exp_t acc_exp = 0;
+    bool started = false;
+
+    for (size_t i = p->size; i-- > 0;) {
+        if (!PolyIsCoeff(&p->arr[i].p))
+            continue;
+        if (started)
+            CoeffMulByPower(&acc, x, acc_exp - p->arr[i].exp);
+        CoeffAddTo(&acc, &p->arr[i].p);
+        acc_exp = p->arr[i].exp;
+        started = true;
+    }
 
+    if (started)
+        CoeffMulByPower(&acc, x, acc_exp);
+    return acc;
+}
+
+/**
+ * Wylicza wartość wielomianu @p p w punkcie @p x (patrz PolyAt), gdy
+ * wartość sumy po jednomianach o współczynnikach będących liczbami jest
+ * już znana (patrz CoeffMonosAt).
+ * @param[in] p : wielomian niebędący współczynnikiem
+ * @param[in] x : niezerowy współczynnik, który podstawiamy za zmienną
+ * @param[in] coeff : wartość sumy po jednomianach o współczynnikach
+ *                    będących liczbami, przejmowana na własność
+ * @return @f$p(x, x_0, x_1, \ldots)@f$
+ */
+static Poly PolyMonosAt(const Poly *p, const Poly *x, Poly coeff) {
+    Poly *terms = SafeCalloc(p->size + 1, sizeof(Poly));
+    size_t count = 0;
+
+    /* Współczynniki będące wielomianami mnożymy przez kolejne potęgi x,
+     * wyliczane z poprzednich jako x^{e_i} = x^{e_{i-1}} * x^{e_i - e_{i-1}}. */
+    Poly power = PolyFromCoeff(1);
+    poly_exp_t power_exp = 0;
     for (size_t i = 0; i < p->size; i++) {
-        p_coeff = PolyFromCoeff(Exponantiate(x, p->arr[i].exp));
-        p_mul = PolyMul(&p->arr[i].p, &p_coeff);
-        monos[i] = MonoFromPoly(&p_mul, 0);
+        if (PolyIsCoeff(&p->arr[i].p))
+            continue;
+        CoeffMulByPower(&power, x, p->arr[i].exp - power_exp);
+        power_exp = p->arr[i].exp;
+
+        Poly term = PolyScale(&p->arr[i].p, &power);
+        if (!PolyIsZero(&term))
+            terms[count++] = term;
     }
+    PolyDestroy(&power);
+
+    if (!PolyIsZero(&coeff))
+        terms[count++] = coeff;
 
-    return monos;
+    Poly res = count == 0 ? PolyZero() : PolySumBalanced(count, terms);
+    free(terms);
+
+    return res;
 }
 
 Poly PolyAt(const Poly *p, poly_coeff_t x) {
     if (PolyIsCoeff(p))
-        return *p;
+        return PolyShare(p);
 
-    Mono *monos = MonosAtFromPoly(p, x);
-    Poly res = PolyAddMonos(p->size, monos);
-    free(monos);
+    Poly x_coeff = PolyFromCoeff(PolyCoeffReduce(x));
+    // Dla x = 0 pozostaje jedynie współczynnik przy x^0.
+    if (PolyIsZero(&x_coeff))
+        return p->arr[0].exp == 0 ? PolyShare(&p->arr[0].p) : PolyZero();
+
+    return PolyMonosAt(p, &x_coeff, CoeffMonosAt(p, &x_coeff));
+}
 
-    /* Wywołując MonosAtFromPoly sztucznie dodaliśmy zmienną o wykładniku 0,
-     * dlatego musimy teraz zredukować wielomian jeżeli PolyAddMonos nie
-     * zrobiło tego wcześniej.
-     * (PolyAddMonos zredukuje wielomian tylko gdy wynikiem jest
-     * współczynnik. - My chcemy zredukować także gdy nie jest
-     * współczynnikiem.) */
-    if (!PolyIsCoeff(&res)) {
-        Poly p_temp = res.arr[0].p;
-        free(res.arr);
-        res = p_temp;
+void PolyAtPoints(const Poly *p, size_t count, const poly_coeff_t xs[],
+                  Poly res[]) {
+    /* Jądra liczą na słowach maszynowych, dlatego w trybie dokładnym
+     * podstawiamy punkty po kolei. */
+    if (PolyIsCoeff(p) || coeff_exact) {
+        for (size_t j = 0; j < count; j++)
+            res[j] = PolyAt(p, xs[j]);
+        return;
     }
 
-    return res;
+    // Wydzielamy jednomiany, których współczynniki są liczbami.
+    uint64_t *coeffs = SafeCalloc(p->size, sizeof(uint64_t));
+    poly_exp_t *exps = SafeCalloc(p->size, sizeof(poly_exp_t));
+    size_t terms = 0;
+    for (size_t i = 0; i < p->size; i++) {
+        if (PolyIsCoeff(&p->arr[i].p)) {
+            coeffs[terms] = (uint64_t) p->arr[i].p.coeff;
+            exps[terms++] = p->arr[i].exp;
+        }
+    }
+
+    uint64_t *points = SafeCalloc(count, sizeof(uint64_t));
+    uint64_t *values = SafeCalloc(count, sizeof(uint64_t));
+    for (size_t j = 0; j < count; j++)
+        points[j] = (uint64_t) PolyCoeffReduce(xs[j]);
+    if (coeff_ring.mod == 0)
+        PointsEval(terms, coeffs, exps, count, points, values);
+    else
+        PointsEvalMod(&coeff_ring, terms, coeffs, exps, count, points, values);
+
+    for (size_t j = 0; j < count; j++) {
+        Poly value = PolyFromCoeff((poly_coeff_t) values[j]);
+        Poly x_coeff = PolyFromCoeff((poly_coeff_t) points[j]);
+        if (terms == p->size)
+            res[j] = value;
+        else if (PolyIsZero(&x_coeff))
+            res[j] = PolyAt(p, 0);
+        else
+            res[j] = PolyMonosAt(p, &x_coeff, value);
+    }
+
+    free(coeffs);
+    free(exps);
+    free(points);
+    free(values);
+}
+
+/** Liczba ramek funkcji PolyEval mieszczących się na stosie wywołań.
+ * Głębsze wielomiany przenoszą ramki na stertę. */
+#define EVAL_FRAMES 64
+
+/** To jest struktura przechowująca stan schematu Hornera w jednym
+ * wierzchołku wielomianu wyliczanego funkcją PolyEval. */
+typedef struct EvalFrame {
+    const Poly *p; ///< wielomian niebędący współczynnikiem
+    size_t next; ///< indeks ostatnio wyliczonego współczynnika
+    size_t level; ///< indeks zmiennej współczynników wielomianu @p p
+    poly_coeff_t x; ///< liczba podstawiana pod zmienną wielomianu @p p
+    poly_coeff_t acc; ///< wartość jednomianów o indeksach od @p next
+    poly_exp_t acc_exp; ///< wykładnik jednomianu o indeksie @p next
+} EvalFrame;
+
+/**
+ * Zwraca współczynnik jako liczbę. Duży współczynnik zamienia na resztę
+ * z dzielenia przez @f$2^{64}@f$.
+ * @param[in] p : współczynnik
+ * @return wartość współczynnika
+ */
+static inline poly_coeff_t CoeffWord(const Poly *p) {
+    return PolyIsBig(p) ? (poly_coeff_t) BigIntLowWord(p->big) : p->coeff;
+}
+
+/**
+ * Zwraca wartość liczby @p x podniesionej do potęgi @p exp, omijając
+ * potęgowanie w częstych przypadkach wykładników 0 i 1.
+ * @param[in] x : potęgowana liczba
+ * @param[in] exp : wykładnik potęgi
+ * @return @f$ x^{exp} @f$
+ */
+static inline poly_coeff_t EvalPower(poly_coeff_t x, poly_exp_t exp) {
+    if (exp <= 1)
+        return exp == 0 ? 1 : x;
+    return Exponantiate(x, exp);
+}
+
+poly_coeff_t PolyEval(const Poly *p, size_t n, const poly_coeff_t values[]) {
+    EvalFrame local[EVAL_FRAMES];
+    EvalFrame *frames = local;
+    size_t capacity = EVAL_FRAMES, depth = 0, level = 0;
+    const Poly *node = p;
+    poly_coeff_t value;
+
+    while (true) {
+        /* Schodzimy do ostatniego jednomianu kolejnych wierzchołków, aż
+         * trafimy na współczynnik. Gdy pod zmienną podstawiamy zero,
+         * zostaje jedynie jednomian przy jej zerowej potędze. */
+        while (!PolyIsCoeff(node)) {
+            poly_coeff_t x = level < n ? PolyCoeffReduce(values[level]) : 0;
+            level++;
+            if (x == 0) {
+                if (node->arr[0].exp != 0)
+                    break;
+                node = &node->arr[0].p;
+                continue;
+            }
+
+            if (depth == capacity) {
+                EvalFrame *grown = SafeCalloc(2 * capacity, sizeof(EvalFrame));
+                memcpy(grown, frames, capacity * sizeof(EvalFrame));
+                if (frames != local)
+                    free(frames);
+                frames = grown;
+                capacity *= 2;
+            }
+            frames[depth++] = (EvalFrame) {.p = node, .next = node->size,
+                                           .level = level, .x = x};
+            node = &node->arr[node->size - 1].p;
+        }
+        value = PolyIsCoeff(node) ? CoeffWord(node) : 0;
+
+        /* Dołączamy wartość do akumulatora wierzchołka wyżej. Gdy był to
+         * jego ostatni jednomian, mnożymy akumulator przez x^{e_0}
+         * i wracamy poziom wyżej. */
+        while (depth > 0) {
+            EvalFrame *frame = &frames[depth - 1];
+            size_t i = --frame->next;
+            poly_exp_t exp = frame->p->arr[i].exp;
+            if (i + 1 == frame->p->size)
+                frame->acc = value;
+            else
+                frame->acc = CoeffAdd(CoeffMul(frame->acc, EvalPower(
+                        frame->x, frame->acc_exp - exp)), value);
+            frame->acc_exp = exp;
+            if (i > 0)
+                break;
+
+            value = CoeffMul(frame->acc, EvalPower(frame->x, exp));
+            depth--;
+        }
+        if (depth == 0)
+            break;
+        node = &frames[depth - 1].p->arr[frames[depth - 1].next - 1].p;
+        level = frames[depth - 1].level;
+    }
+
+    if (frames != local)
+        free(frames);
+    return value;
 }
 
 void Print(Poly p) {
-    if (PolyIsCoeff(&p))
+    if (PolyIsBig(&p))
+        BigIntPrint(p.big);
+    else if (PolyIsCoeff(&p))
         printf("%ld", p.coeff);
     else {
         for (size_t i = 0; i < p.size; i++) {
@@ -536,36 +1765,6 @@ static Poly PolyExponantiate(Poly p, poly_exp_t exp) {
     return res;
 }
 
-/**
- * Dodaje dwa wielomiany. Zwalnia pamięć przez nie zajmowaną.
- * @param[in, out] p : wielomian @f$p@f$
- * @param[in, out] q : wielomian @f$q@f$
- * @return @f$p * q@f$
- */
-static Poly PolyAddDestroyArgs(Poly *p, Poly *q) {
-    Poly res = PolyAdd(p, q);
-    PolyDestroy(p);
-    PolyDestroy(q);
-    return res;
-}
-
-/**
- * Dodaje wielomiany zawarte w tablicy @p polys.
- * Zakłada, że tablica jest niepusta.
- * @param count : rozmiar tablicy
- * @param polys : tablica wielomianów
- * @return wynik dodania wielomianów z tablicy @p polys
- */
-static Poly PolyAddPolys(size_t count, Poly *polys) {
-    assert(count > 0);
-    Poly res = PolyZero();
-    for (size_t i = 0; i < count; i++)
-        res = PolyAddDestroyArgs(&res, &polys[i]);
-    free(polys);
-
-    return res;
-}
-
 /**
  * Zwraca wynik operacji compose na wielomianie @p w przypadku gdy
  * parametr k jest równy zero.
@@ -574,7 +1773,7 @@ static Poly PolyAddPolys(size_t count, Poly *polys) {
  */
 static Poly PolyComposeNoArgs(const Poly *p) {
     if (PolyIsCoeff(p))
-        return *p;
+        return PolyShare(p);
     if (p->arr[0].exp == 0)
         return PolyComposeNoArgs(&p->arr[0].p);
     else
@@ -598,27 +1797,374 @@ Poly PolyCloneMonos(size_t count, const Mono *monos) {
     if (count == 0 || monos == NULL)
         return PolyZero();
 
-    // Kopiujemy tablicę monos.
-    Mono *monos_copy = MergeMonoArrays(NULL, (Mono *) monos, 0, count);
-    Poly p = PolyAddMonosNoOwnershipTransfer(count, monos_copy);
-    free(monos_copy);
+    PolyBuilder builder = NewPolyBuilder(count);
+    for (size_t i = 0; i < count; i++) {
+        Mono m = MonoShare(&monos[i]);
+        PolyBuilderAdd(&builder, &m);
+    }
 
-    return p;
+    return PolyBuilderFinish(&builder);
+}
+
+/**
+ * To jest struktura przechowująca potęgi wielomianu podstawianego
+ * za jedną ze zmiennych w operacji złożenia. Potęgi wyliczane są dla
+ * wszystkich wykładników, z którymi ta zmienna występuje w składanym
+ * wielomianie, i współdzielone przez całą rekurencję.
+ */
+typedef struct PowerTable {
+    const Poly *base; ///< potęgowany wielomian
+    poly_exp_t *exps; ///< wykładniki potęg, po zbudowaniu posortowane rosnąco
+    Poly *powers; ///< potęgi - powers[i] to base podniesiony do potęgi exps[i]
+    size_t size; ///< liczba wykładników
+    size_t capacity; ///< liczba wykładników, dla których zaalokowano pamięć
+} PowerTable;
+
+/**
+ * Zwraca liczbę zmiennych wielomianu, czyli głębokość jego drzewa.
+ * @param[in] p : wielomian
+ * @return liczba zmiennych (0 dla współczynnika)
+ */
+static size_t PolyDepth(const Poly *p) {
+    if (PolyIsCoeff(p))
+        return 0;
+
+    return MonosGetHeader(p->arr)->depth;
+}
+
+/**
+ * Dopisuje wykładnik do tablicy potęg, w razie potrzeby
+ * dwukrotnie powiększając tablicę wykładników.
+ * @param[in, out] table : tablica potęg
+ * @param[in] exp : wykładnik
+ */
+static void PowerTableAddExp(PowerTable *table, poly_exp_t exp) {
+    if (table->size == table->capacity) {
+        table->capacity = table->capacity == 0 ? 4 : 2 * table->capacity;
+        table->exps = SafeRealloc(table->exps,
+                                  table->capacity * sizeof(poly_exp_t));
+    }
+    table->exps[table->size++] = exp;
+}
+
+/**
+ * Minimalna liczba jednomianów wielomianu, od której iloczyny złożonych
+ * współczynników i potęg są wyliczane równolegle.
+ */
+#define PARALLEL_COMPOSE_MIN_MONOS 16
+
+/**
+ * Sprawdza, czy złożenie wielomianu @p p należy wykonać na puli wątków
+ * mnożenia. Złożenia wywołane wewnątrz zadań puli są sekwencyjne.
+ * @param[in] p : wielomian niebędący współczynnikiem
+ * @return Czy złożenie wykonać równolegle?
+ */
+static bool ComposeInParallel(const Poly *p) {
+    return mul_pool != NULL && !ThreadPoolInTask()
+           && p->size >= PARALLEL_COMPOSE_MIN_MONOS;
+}
+
+/**
+ * Sprawdza, czy złożenie wielomianu @p p należy wykonać schematem Hornera.
+ * Schemat Hornera mnoży akumulator przez niskie potęgi @f$q_0@f$ i nie
+ * przechowuje wysokich potęg, ale każde mnożenie obejmuje cały
+ * dotychczasowy wynik, a potęg nie da się współdzielić między węzłami
+ * tego samego poziomu. Opłaca się więc tylko w korzeniu i tylko wtedy,
+ * gdy złożone współczynniki są stałymi - w przeciwnym przypadku szybsze
+ * jest zsumowanie niezależnych iloczynów współczynników i potęg.
+ * Schemat Hornera jest sekwencyjny, dlatego nie jest używany, gdy
+ * złożenie można wykonać równolegle.
+ * @param[in] p : wielomian niebędący współczynnikiem, korzeń złożenia
+ * @param[in] k : liczba podstawianych wielomianów, dodatnia
+ * @return Czy złożenie wykonać schematem Hornera?
+ */
+static bool ComposeUsesHorner(const Poly *p, size_t k) {
+    if (ComposeInParallel(p))
+        return false;
+    if (k == 1)
+        return true;
+
+    for (size_t i = 0; i < p->size; i++)
+        if (!PolyIsCoeff(&p->arr[i].p))
+            return false;
+
+    return true;
+}
+
+/**
+ * Dopisuje do tablic potęg wszystkie wykładniki potrzebne do złożenia
+ * wielomianu @p p względem zmiennych @f$x_{level}, \ldots, x_{levels-1}@f$.
+ * Przy złożeniu schematem Hornera są to różnice kolejnych wykładników
+ * oraz najmniejszy niezerowy wykładnik, a w przeciwnym przypadku
+ * wszystkie wykładniki.
+ * @param[in] p : wielomian (współczynnik na poziomie @p level)
+ * @param[in] k : liczba podstawianych wielomianów na poziomie @p level
+ * @param[in] level : indeks zmiennej wielomianu @p p
+ * @param[in] levels : liczba tablic potęg
+ * @param[in, out] tables : tablice potęg kolejnych zmiennych
+ */
+static void CollectComposeExps(const Poly *p, size_t k, size_t level,
+                               size_t levels, PowerTable tables[]) {
+    if (PolyIsCoeff(p) || level == levels)
+        return;
+
+    bool horner = level == 0 && ComposeUsesHorner(p, k);
+    if (horner && p->arr[0].exp > 0)
+        PowerTableAddExp(&tables[level], p->arr[0].exp);
+    for (size_t i = 0; i < p->size; i++) {
+        if (!horner)
+            PowerTableAddExp(&tables[level], p->arr[i].exp);
+        else if (i > 0)
+            PowerTableAddExp(&tables[level], p->arr[i].exp - p->arr[i - 1].exp);
+        CollectComposeExps(&p->arr[i].p, k - 1, level + 1, levels, tables);
+    }
+}
+
+/**
+ * Porównuje wykładniki.
+ * @param[in] a : wskaźnik na wykładnik
+ * @param[in] b : wskaźnik na wykładnik
+ * @return -1, 0 lub 1, gdy pierwszy wykładnik jest odpowiednio mniejszy,
+ *         równy lub większy od drugiego
+ */
+static int CompareExp(const void *a, const void *b) {
+    poly_exp_t e1 = *(const poly_exp_t *) a;
+    poly_exp_t e2 = *(const poly_exp_t *) b;
+    return (e1 > e2) - (e1 < e2);
+}
+
+/**
+ * Wyszukuje binarnie wykładnik wśród pierwszych @p count wykładników
+ * zbudowanej tablicy potęg.
+ * @param[in] table : tablica potęg
+ * @param[in] count : liczba przeszukiwanych wykładników
+ * @param[in] exp : szukany wykładnik
+ * @return indeks wykładnika lub @p count, gdy go nie ma
+ */
+static size_t PowerTableFind(const PowerTable *table, size_t count,
+                             poly_exp_t exp) {
+    size_t lo = 0, hi = count;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (table->exps[mid] < exp)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    return lo < count && table->exps[lo] == exp ? lo : count;
+}
+
+/**
+ * Sortuje wykładniki tablicy potęg, usuwa powtórzenia i wylicza potęgi
+ * przyrostowo: @f$b^{e_i} = b^{e_{i-1}} \cdot b^{e_i - e_{i-1}}@f$.
+ * Potęga różnicy wykładników jest brana z tablicy, jeśli została już
+ * wyliczona, a w przeciwnym przypadku liczona szybkim potęgowaniem.
+ * @param[in, out] table : tablica potęg
+ */
+static void PowerTableBuild(PowerTable *table) {
+    if (table->size == 0)
+        return;
+
+    qsort(table->exps, table->size, sizeof(poly_exp_t), CompareExp);
+
+    size_t size = 0;
+    for (size_t i = 0; i < table->size; i++)
+        if (size == 0 || table->exps[size - 1] != table->exps[i])
+            table->exps[size++] = table->exps[i];
+    table->size = size;
+
+    table->powers = SafeCalloc(size, sizeof(Poly));
+    for (size_t i = 0; i < size; i++) {
+        if (i == 0) {
+            table->powers[0] = PolyExponantiate(*table->base, table->exps[0]);
+            continue;
+        }
+
+        poly_exp_t gap = table->exps[i] - table->exps[i - 1];
+        size_t gap_idx = PowerTableFind(table, i, gap);
+        Poly gap_power = gap_idx < i ? PolyShare(&table->powers[gap_idx])
+                                     : PolyExponantiate(*table->base, gap);
+        table->powers[i] = PolyMul(&table->powers[i - 1], &gap_power);
+        PolyDestroy(&gap_power);
+    }
+}
+
+/**
+ * Zwraca potęgę z tablicy potęg. Zakłada, że tablica jest zbudowana
+ * i zawiera wykładnik @p exp.
+ * @param[in] table : tablica potęg
+ * @param[in] exp : wykładnik
+ * @return wskaźnik na potęgę
+ */
+static const Poly *PowerTableGet(const PowerTable *table, poly_exp_t exp) {
+    size_t idx = PowerTableFind(table, table->size, exp);
+    assert(idx < table->size);
+    return &table->powers[idx];
+}
+
+/**
+ * Zwalnia pamięć zajmowaną przez tablicę potęg.
+ * @param[in, out] table : tablica potęg
+ */
+static void PowerTableDestroy(PowerTable *table) {
+    for (size_t i = 0; table->powers != NULL && i < table->size; i++)
+        PolyDestroy(&table->powers[i]);
+    free(table->powers);
+    free(table->exps);
+}
+
+static Poly PolyComposeWithPowers(const Poly *p, size_t k,
+                                  const PowerTable tables[]);
+
+/**
+ * Dokonuje złożenia wielomianu @p p schematem Hornera względem
+ * zmiennej @f$x_0@f$: akumulator jest mnożony przez @f$q_0@f$ podniesiony
+ * do różnicy kolejnych wykładników i powiększany o złożony współczynnik
+ * kolejnego jednomianu.
+ * @param[in] p : wielomian niebędący współczynnikiem
+ * @param[in] k : liczba podstawianych wielomianów, dodatnia
+ * @param[in] tables : zbudowane tablice potęg kolejnych zmiennych
+ * @return wielomian będący wynikiem złożenia
+ */
+static Poly PolyComposeHorner(const Poly *p, size_t k,
+                              const PowerTable tables[]) {
+    size_t i = p->size - 1;
+    Poly acc = PolyComposeWithPowers(&p->arr[i].p, k - 1, tables + 1);
+    while (i > 0) {
+        poly_exp_t gap = p->arr[i].exp - p->arr[i - 1].exp;
+        Poly gap_power = PolyShare(PowerTableGet(&tables[0], gap));
+        acc = PolyMulDestroyArgs(&acc, &gap_power);
+
+        i--;
+        Poly coeff_poly = PolyComposeWithPowers(&p->arr[i].p, k - 1,
+                                                tables + 1);
+        PolyAddTo(&acc, &coeff_poly);
+    }
+
+    if (p->arr[0].exp > 0) {
+        Poly power = PolyShare(PowerTableGet(&tables[0], p->arr[0].exp));
+        acc = PolyMulDestroyArgs(&acc, &power);
+    }
+
+    return acc;
+}
+
+/**
+ * Zwraca iloczyn złożonego współczynnika jednomianu @p m i potęgi
+ * @f$q_0@f$ o wykładniku jednomianu @p m.
+ * @param[in] m : jednomian
+ * @param[in] k : liczba podstawianych wielomianów, dodatnia
+ * @param[in] tables : zbudowane tablice potęg kolejnych zmiennych
+ * @return złożenie jednomianu @p m
+ */
+static Poly ComposeTerm(const Mono *m, size_t k, const PowerTable tables[]) {
+    Poly coeff_poly = PolyComposeWithPowers(&m->p, k - 1, tables + 1);
+    Poly var_poly = PolyShare(PowerTableGet(&tables[0], m->exp));
+    return PolyMulDestroyArgs(&coeff_poly, &var_poly);
+}
+
+/**
+ * To jest struktura opisująca zadanie złożenia jednego jednomianu.
+ */
+typedef struct ComposeTask {
+    const Mono *m; ///< składany jednomian
+    size_t k; ///< liczba podstawianych wielomianów
+    const PowerTable *tables; ///< tablice potęg kolejnych zmiennych
+    Poly *res; ///< miejsce na wynik
+} ComposeTask;
+
+/**
+ * Wykonuje zadanie typu ComposeTask.
+ * @param[in, out] arg : wskaźnik na zadanie
+ */
+static void ComposeTaskRun(void *arg) {
+    ComposeTask *task = arg;
+    *task->res = ComposeTerm(task->m, task->k, task->tables);
+}
+
+/**
+ * Dokonuje złożenia wielomianu @p p, sumując niezależne iloczyny
+ * złożonych współczynników i potęg @f$q_0@f$ w zrównoważonym drzewie.
+ * Gdy pozwala na to ComposeInParallel, iloczyny wyliczane są przez
+ * wątki puli mnożenia, a drzewo sumowania wykonywane jest równolegle -
+ * jego kształt, a więc i wynik, nie zależy od liczby wątków.
+ * @param[in] p : wielomian niebędący współczynnikiem
+ * @param[in] k : liczba podstawianych wielomianów, dodatnia
+ * @param[in] tables : zbudowane tablice potęg kolejnych zmiennych
+ * @return wielomian będący wynikiem złożenia
+ */
+static Poly PolyComposePowerSum(const Poly *p, size_t k,
+                                const PowerTable tables[]) {
+    Poly *polys = SafeCalloc(p->size, sizeof(Poly));
+    Poly res;
+
+    if (ComposeInParallel(p)) {
+        ComposeTask *terms = SafeCalloc(p->size, sizeof(ComposeTask));
+        Task *tasks = SafeCalloc(p->size, sizeof(Task));
+        for (size_t i = 0; i < p->size; i++) {
+            terms[i] = (ComposeTask) {.m = &p->arr[i], .k = k,
+                                      .tables = tables, .res = &polys[i]};
+            tasks[i] = (Task) {.run = ComposeTaskRun, .arg = &terms[i]};
+        }
+        ThreadPoolRun(mul_pool, p->size, tasks);
+        free(terms);
+        free(tasks);
+
+        res = PolySumParallel(p->size, polys);
+    } else {
+        for (size_t i = 0; i < p->size; i++)
+            polys[i] = ComposeTerm(&p->arr[i], k, tables);
+
+        res = PolySumBalanced(p->size, polys);
+    }
+    free(polys);
+
+    return res;
+}
+
+/**
+ * Dokonuje złożenia wielomianu @p p, korzystając z tablic potęg
+ * wielomianów podstawianych za kolejne zmienne.
+ * @param[in] p : wielomian
+ * @param[in] k : liczba podstawianych wielomianów
+ * @param[in] tables : zbudowane tablice potęg kolejnych zmiennych
+ * @return wielomian będący wynikiem złożenia
+ */
+static Poly PolyComposeWithPowers(const Poly *p, size_t k,
+                                  const PowerTable tables[]) {
+    if (PolyIsCoeff(p))
+        return PolyShare(p);
+    if (k == 0)
+        return PolyComposeNoArgs(p);
+
+    return PolyComposePowerSum(p, k, tables);
 }
 
 Poly PolyCompose(const Poly *p, size_t k, const Poly *q) {
     if (PolyIsCoeff(p))
-        return *p;
+        return PolyShare(p);
     if (k == 0)
         return PolyComposeNoArgs(p);
 
-    Poly *polys = SafeCalloc(p->size, sizeof(Poly));
-    for (size_t i = 0; i < p->size; i++) {
-        Poly coeff_poly = PolyCompose(&p->arr[i].p, k - 1, q + 1);
-        Poly var_poly = PolyExponantiate(q[0], p->arr[i].exp);
-        var_poly = PolyMulDestroyArgs(&coeff_poly, &var_poly);
-        polys[i] = var_poly;
-    }
+    // Tablice potęg potrzebne są tylko dla zmiennych występujących w p.
+    size_t levels = PolyDepth(p);
+    if (levels > k)
+        levels = k;
+
+    PowerTable *tables = SafeCalloc(levels, sizeof(PowerTable));
+    for (size_t j = 0; j < levels; j++)
+        tables[j].base = &q[j];
+    CollectComposeExps(p, k, 0, levels, tables);
+    for (size_t j = 0; j < levels; j++)
+        PowerTableBuild(&tables[j]);
 
-    return PolyAddPolys(p->size, polys);
-}
\ No newline at end of file
+    Poly res = ComposeUsesHorner(p, k) ? PolyComposeHorner(p, k, tables)
+                                       : PolyComposePowerSum(p, k, tables);
+
+    for (size_t j = 0; j < levels; j++)
+        PowerTableDestroy(&tables[j]);
+    free(tables);
+
+    return res;
+}
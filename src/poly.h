@@ -10,8 +10,10 @@
 #define __POLY_H__
 
 #include <assert.h>
+#include <limits.h>
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 
 /** To jest typ reprezentujący współczynniki. */
 typedef long poly_coeff_t;
@@ -19,26 +21,38 @@ typedef long poly_coeff_t;
 /** To jest typ reprezentujący wykładniki. */
 typedef int poly_exp_t;
 
+/** Największa wartość typu poly_exp_t. */
+#define POLY_EXP_MAX INT_MAX
+
 struct Mono;
 
+struct BigInt;
+
 /**
  * To jest struktura przechowująca wielomian.
  * Wielomian jest albo liczbą całkowitą, czyli wielomianem stałym
- * (wtedy `arr == NULL`), albo niepustą listą jednomianów (wtedy `arr != NULL`).
+ * (wtedy `arr == NULL`), albo niepustą listą jednomianów (wtedy `arr != NULL`
+ * i `size > 0`). W dokładnym trybie współczynników (patrz PolySetExact)
+ * wielomian stały może być też liczbą niemieszczącą się w typie
+ * poly_coeff_t (wtedy `size == 0`, a `big != NULL`).
  */
 typedef struct Poly {
     /**
     * To jest unia przechowująca współczynnik wielomianu lub
     * liczbę jednomianów w wielomianie.
     * Jeżeli `arr == NULL`, wtedy jest to współczynnik będący liczbą całkowitą.
-    * W przeciwnym przypadku jest to niepusta lista jednomianów.
+    * W przeciwnym przypadku jest to liczba jednomianów (0 dla dużego
+    * współczynnika).
     */
     union {
         poly_coeff_t coeff; ///< współczynnik
         size_t size; ///< rozmiar wielomianu, liczba jednomianów
     };
-    /** To jest tablica przechowująca listę jednomianów. */
-    struct Mono *arr;
+    /** To jest unia przechowująca listę jednomianów lub duży współczynnik. */
+    union {
+        struct Mono *arr; ///< tablica jednomianów
+        struct BigInt *big; ///< współczynnik spoza typu poly_coeff_t
+    };
 } Poly;
 
 /**
@@ -97,7 +111,17 @@ static inline Mono MonoFromPoly(const Poly *p, poly_exp_t n) {
  * @return Czy wielomian jest współczynnikiem?
  */
 static inline bool PolyIsCoeff(const Poly *p) {
-    return p->arr == NULL;
+    return p->arr == NULL || p->size == 0;
+}
+
+/**
+ * Sprawdza, czy wielomian jest współczynnikiem niemieszczącym się w typie
+ * poly_coeff_t (patrz PolySetExact).
+ * @param[in] p : wielomian
+ * @return Czy wielomian jest dużym współczynnikiem?
+ */
+static inline bool PolyIsBig(const Poly *p) {
+    return p->arr != NULL && p->size == 0;
 }
 
 /**
@@ -106,7 +130,7 @@ static inline bool PolyIsCoeff(const Poly *p) {
  * @return Czy wielomian jest równy zeru?
  */
 static inline bool PolyIsZero(const Poly *p) {
-    return PolyIsCoeff(p) && p->coeff == 0;
+    return p->arr == NULL && p->coeff == 0;
 }
 
 /**
@@ -130,6 +154,43 @@ static inline void MonoDestroy(Mono *m) {
  */
 Poly PolyClone(const Poly *p);
 
+/**
+ * Robi płytką kopię wielomianu w czasie stałym. Kopia współdzieli tablicę
+ * jednomianów z oryginałem - tablica jest zwalniana dopiero wtedy, gdy
+ * usunięty zostanie ostatni współdzielący ją wielomian. Funkcje interfejsu
+ * nigdy nie modyfikują współdzielonej tablicy - przed zmianą w miejscu
+ * wykonują jej kopię.
+ * @param[in] p : wielomian
+ * @return wielomian równy @p p
+ */
+Poly PolyShare(const Poly *p);
+
+/**
+ * Zwraca tablicę wykładników jednomianów wielomianu. Wykładniki
+ * przechowywane są w ciągłej tablicy obok tablicy jednomianów, dlatego
+ * przeglądanie samych wykładników nie wczytuje współczynników.
+ * Element @p i tablicy jest równy `p->arr[i].exp`.
+ * @param[in] p : wielomian niebędący współczynnikiem
+ * @return tablica wykładników o rozmiarze `p->size`
+ */
+const poly_exp_t *PolyExps(const Poly *p);
+
+/**
+ * Sprawdza, czy tablica jednomianów wielomianu jest współdzielona
+ * z innym wielomianem (patrz PolyShare).
+ * @param[in] p : wielomian
+ * @return Czy wielomian nie jest współczynnikiem i współdzieli tablicę?
+ */
+bool PolyIsShared(const Poly *p);
+
+/**
+ * Sprawdza, czy wielomian lub któryś z jego współczynników współdzieli
+ * tablicę jednomianów z innym wielomianem (patrz PolyIsShared).
+ * @param[in] p : wielomian
+ * @return Czy któraś tablica jednomianów wielomianu jest współdzielona?
+ */
+bool PolyHasSharedArrays(const Poly *p);
+
 /**
  * Robi pełną, głęboką kopię jednomianu.
  * @param[in] m : jednomian
@@ -139,6 +200,52 @@ static inline Mono MonoClone(const Mono *m) {
     return (Mono) {.p = PolyClone(&m->p), .exp = m->exp};
 }
 
+/**
+ * To jest struktura budująca wielomian z jednomianów dodawanych po kolei.
+ * Jednomiany dopisywane są na koniec tablicy, a jednomian o wykładniku
+ * równym wykładnikowi ostatniego jest od razu do niego dodawany. Dopóki
+ * wykładniki rosną, tablica jest gotowym wielomianem - w przeciwnym
+ * przypadku jest sortowana i scalana dopiero przy jego tworzeniu.
+ */
+typedef struct PolyBuilder {
+    Mono *monos; ///< tablica dodanych jednomianów
+    size_t count; ///< liczba jednomianów w tablicy
+    size_t capacity; ///< liczba jednomianów, na które zaalokowano tablicę
+    bool sorted; ///< czy wykładniki jednomianów w tablicy rosną ściśle
+} PolyBuilder;
+
+/**
+ * Tworzy pusty budowniczy wielomianu.
+ * @param[in] capacity : przewidywana liczba jednomianów (może być 0)
+ * @return pusty budowniczy
+ */
+PolyBuilder NewPolyBuilder(size_t capacity);
+
+/**
+ * Dodaje jednomian do budowanego wielomianu.
+ * Przejmuje na własność zawartość jednomianu @p m, pozostawiając w nim
+ * wielomian tożsamościowo równy zeru.
+ * @param[in, out] builder : budowniczy
+ * @param[in, out] m : jednomian
+ */
+void PolyBuilderAdd(PolyBuilder *builder, Mono *m);
+
+/**
+ * Zwraca wielomian będący sumą jednomianów dodanych do budowniczego
+ * i opróżnia go. Wynikowy wielomian używa tablicy budowniczego - gdy
+ * wykładniki dodawanych jednomianów rosły, nie wymaga ani sortowania,
+ * ani kopiowania jednomianów.
+ * @param[in, out] builder : budowniczy
+ * @return wielomian będący sumą jednomianów
+ */
+Poly PolyBuilderFinish(PolyBuilder *builder);
+
+/**
+ * Usuwa jednomiany dodane do budowniczego i zwalnia jego pamięć.
+ * @param[in, out] builder : budowniczy
+ */
+void PolyBuilderDestroy(PolyBuilder *builder);
+
 /**
  * Dodaje dwa wielomiany.
  * @param[in] p : wielomian @f$p@f$
@@ -147,6 +254,18 @@ static inline Mono MonoClone(const Mono *m) {
  */
 Poly PolyAdd(const Poly *p, const Poly *q);
 
+/**
+ * Dodaje wielomian @p p do wielomianu @p acc w miejscu. Przejmuje na
+ * własność wielomian @p p, pozostawiając w nim wielomian tożsamościowo
+ * równy zeru. Używa ponownie tablic jednomianów obu wielomianów (jeśli
+ * nie są współdzielone) i powiększa tablicę @p acc, zamiast tworzyć nową,
+ * dlatego dodanie do dużego wielomianu jednomianów o większych wykładnikach
+ * kosztuje tyle, ile ich dopisanie. Wielomiany muszą być różnymi obiektami.
+ * @param[in, out] acc : wielomian @f$acc@f$, zastępowany przez @f$acc + p@f$
+ * @param[in, out] p : wielomian @f$p@f$
+ */
+void PolyAddTo(Poly *acc, Poly *p);
+
 /**
  * Sumuje listę jednomianów i tworzy z nich wielomian.
  * Przejmuje na własność zawartość tablicy @p monos.
@@ -164,6 +283,121 @@ Poly PolyAddMonos(size_t count, const Mono monos[]);
  */
 Poly PolyMul(const Poly *p, const Poly *q);
 
+/**
+ * Mnoży wielomian przez liczbę. Zachowuje kolejność jednomianów
+ * i pomija jedynie te, które się wyzerowały.
+ * @param[in] p : wielomian @f$p@f$
+ * @param[in] c : liczba @f$c@f$
+ * @return @f$c \cdot p@f$
+ */
+Poly PolyMulByCoeff(const Poly *p, poly_coeff_t c);
+
+/**
+ * Mnoży wielomian przez liczbę w miejscu. Gdy żaden jednomian się nie
+ * wyzeruje, ponownie używa tablic jednomianów wielomianu @p p (jeśli
+ * nie są współdzielone), a w przeciwnym przypadku je zmniejsza.
+ * @param[in, out] p : wielomian @f$p@f$, zastępowany przez @f$c \cdot p@f$
+ * @param[in] c : liczba @f$c@f$
+ */
+void PolyMulByCoeffInPlace(Poly *p, poly_coeff_t c);
+
+/**
+ * Ustawia liczbę wątków używanych przez mnożenie wielomianów.
+ * Dla @p threads większego od 1 mnożenie dużych wielomianów dzieli
+ * jednomiany jednego z czynników między wątki puli z podkradaniem zadań,
+ * a częściowe iloczyny scala równolegle w drzewie. Wartość 1 przywraca
+ * mnożenie sekwencyjne i kończy działanie wątków puli. Funkcji nie wolno
+ * wywoływać w trakcie mnożenia w innym wątku.
+ * @param[in] threads : liczba wątków, dodatnia
+ */
+void PolySetThreads(size_t threads);
+
+/**
+ * Zwraca liczbę wątków używanych przez mnożenie wielomianów.
+ * @return liczba wątków
+ */
+size_t PolyGetThreads(void);
+
+/**
+ * Ustawia moduł współczynników. Dla @p mod równego 0 (domyślnie)
+ * współczynniki są liczbami typu poly_coeff_t, a działania na nich
+ * przepełniają się tak jak działania modulo @f$2^{64}@f$ (o ile nie włączono
+ * trybu dokładnego, patrz PolySetExact). Wyłącza tryb dokładny. Dla @p mod
+ * od 2 do @f$2^{62} - 1@f$ (zwykle liczby pierwszej) wszystkie działania na
+ * wielomianach wykonywane są modulo @p mod, a współczynniki są resztami
+ * z przedziału @f$[0, mod)@f$. Wielomiany przekazywane funkcjom interfejsu
+ * muszą wtedy spełniać ten warunek (patrz PolyCoeffReduce
+ * i PolyReduceCoeffs) - liczby przekazywane funkcjom PolyMulByCoeff i PolyAt
+ * mogą być dowolne. Funkcji nie wolno wywoływać w trakcie działań na
+ * wielomianach w innym wątku.
+ * @param[in] mod : moduł współczynników lub 0
+ */
+void PolySetModulus(poly_coeff_t mod);
+
+/**
+ * Zwraca moduł współczynników ustawiony funkcją PolySetModulus.
+ * @return moduł współczynników lub 0
+ */
+poly_coeff_t PolyGetModulus(void);
+
+/**
+ * Włącza lub wyłącza dokładny tryb współczynników. W trybie dokładnym
+ * współczynniki są liczbami całkowitymi bez ograniczeń: działania na
+ * współczynnikach typu poly_coeff_t sprawdzają przepełnienie i dopiero
+ * wtedy zapisują wynik jako liczbę dowolnej wielkości (patrz PolyIsBig),
+ * a wynik mieszczący się w typie poly_coeff_t zawsze zapisywany jest
+ * w tym typie. Tryb dokładny wyłącza tryb modularny i odwrotnie (patrz
+ * PolySetModulus). Po wyłączeniu trybu wielomiany z dużymi
+ * współczynnikami należy przekształcić funkcją PolyReduceCoeffs.
+ * Funkcji nie wolno wywoływać w trakcie działań na wielomianach
+ * w innym wątku.
+ * @param[in] exact : czy włączyć tryb dokładny
+ */
+void PolySetExact(bool exact);
+
+/**
+ * Sprawdza, czy włączony jest dokładny tryb współczynników.
+ * @return Czy tryb dokładny jest włączony?
+ */
+bool PolyGetExact(void);
+
+/**
+ * Sprawdza, czy wielomian zawiera współczynnik niemieszczący się w typie
+ * poly_coeff_t. Poza trybem dokładnym takich współczynników nie ma,
+ * dlatego wtedy od razu zwraca fałsz.
+ * @param[in] p : wielomian
+ * @return Czy któryś współczynnik wielomianu jest duży?
+ */
+bool PolyHasBigCoeffs(const Poly *p);
+
+/**
+ * Zamienia liczbę na współczynnik: w trybie modularnym zwraca jej resztę
+ * z dzielenia przez moduł, a w przeciwnym przypadku samą liczbę.
+ * @param[in] c : liczba
+ * @return współczynnik przystający do @p c
+ */
+poly_coeff_t PolyCoeffReduce(poly_coeff_t c);
+
+/**
+ * Zamienia wszystkie współczynniki wielomianu funkcją PolyCoeffReduce,
+ * pomijając jednomiany, które się wyzerowały. Duże współczynniki
+ * (patrz PolySetExact) poza trybem dokładnym zastępuje ich resztą
+ * z dzielenia przez moduł lub przez @f$2^{64}@f$.
+ * @param[in] p : wielomian o dowolnych współczynnikach
+ * @return wielomian o współczynnikach przystających do współczynników @p p
+ */
+Poly PolyReduceCoeffs(const Poly *p);
+
+/**
+ * Dodaje iloczyn wielomianów @p p i @p q do wielomianu @p acc w miejscu
+ * (patrz PolyAddTo). Nie modyfikuje wielomianów @p p i @p q.
+ * @param[in, out] acc : wielomian @f$acc@f$, zastępowany przez
+ *                       @f$acc + p \cdot q@f$
+ * @param[in] p : wielomian @f$p@f$
+ * @param[in] q : wielomian @f$q@f$
+ */
+void PolyMulAddTo(Poly *acc, const Poly *p, const Poly *q);
+
 /**
  * Zwraca przeciwny wielomian.
  * @param[in] p : wielomian @f$p@f$
@@ -185,6 +419,10 @@ Poly PolySub(const Poly *p, const Poly *q);
  * Zmienna o indeksie 0 oznacza zmienną główną tego wielomianu.
  * Większe indeksy oznaczają zmienne wielomianów znajdujących się
  * we współczynnikach.
+ * Dla zmiennej głównej i zmiennych, od których wielomian nie zależy,
+ * działa w czasie stałym. Dla pozostałych zmiennych przegląda drzewo
+ * wielomianu do poziomu zmiennej, pomijając współczynniki, których
+ * stopień (patrz PolyDeg) nie przekracza dotąd znalezionego wyniku.
  * @param[in] p : wielomian
  * @param[in] var_idx : indeks zmiennej
  * @return stopień wielomianu @p p z względu na zmienną o indeksie @p var_idx
@@ -193,11 +431,32 @@ poly_exp_t PolyDegBy(const Poly *p, size_t var_idx);
 
 /**
  * Zwraca stopień wielomianu (-1 dla wielomianu tożsamościowo równego zeru).
+ * Stopień większy niż POLY_EXP_MAX jest obcinany do POLY_EXP_MAX.
+ * Działa w czasie stałym.
  * @param[in] p : wielomian
  * @return stopień wielomianu @p p
  */
 poly_exp_t PolyDeg(const Poly *p);
 
+/**
+ * Zwraca skrót struktury wielomianu. Równe wielomiany mają równe skróty.
+ * Skrót wielomianu niebędącego współczynnikiem jest zapamiętany przy jego
+ * tablicy jednomianów, więc funkcja działa w czasie stałym.
+ * @param[in] p : wielomian
+ * @return skrót wielomianu @p p
+ */
+uint64_t PolyHash(const Poly *p);
+
+/**
+ * Zwraca liczbę niezerowych jednomianów wielomianu po rozwinięciu go
+ * do sumy jednomianów wszystkich zmiennych (0 dla wielomianu zerowego).
+ * Wynik przekraczający zakres typu size_t jest obcinany do SIZE_MAX.
+ * Działa w czasie stałym.
+ * @param[in] p : wielomian
+ * @return liczba jednomianów wielomianu @p p
+ */
+size_t PolyTerms(const Poly *p);
+
 /**
  * Sprawdza równość dwóch wielomianów. Zakłada przy tym, że jeśli
  * wielomian nie jest współczynnikiem, to tablica zawieranych przez
@@ -224,6 +483,39 @@ bool PolyIsEq(const Poly *p, const Poly *q);
  */
 Poly PolyAt(const Poly *p, poly_coeff_t x);
 
+/**
+ * Wylicza wartości wielomianu w wielu punktach (patrz PolyAt).
+ * Jednomiany, których współczynniki są liczbami, przechodzi raz dla
+ * wszystkich punktów, licząc ich sumę schematem Hornera jednocześnie
+ * w kilku punktach (patrz poly_points.h). Jednomiany, których
+ * współczynniki są wielomianami, mnoży przez potęgi każdego z punktów
+ * osobno. W trybie dokładnym (patrz PolySetExact) wywołuje PolyAt dla
+ * kolejnych punktów.
+ * @param[in] p : wielomian @f$p@f$
+ * @param[in] count : liczba punktów
+ * @param[in] xs : punkty @f$x_j@f$
+ * @param[out] res : tablica długości @p count na wielomiany
+ *                   @f$p(x_j, x_0, x_1, \ldots)@f$
+ */
+void PolyAtPoints(const Poly *p, size_t count, const poly_coeff_t xs[],
+                  Poly res[]);
+
+/**
+ * Wylicza wartość wielomianu, pod którego zmienne
+ * @f$x_0, \ldots, x_{n-1}@f$ podstawiamy kolejne liczby z tablicy
+ * @p values, a pod pozostałe zmienne zera. Przechodzi drzewo wielomianu
+ * raz, iteracyjnie, licząc na każdym poziomie schematem Hornera, bez
+ * tworzenia wielomianów pośrednich. Nie alokuje pamięci na stercie,
+ * chyba że wielomian ma więcej niż 64 poziomy zależne od podstawianych
+ * liczb. Wynik liczony jest w bieżącym trybie współczynników, a w trybie
+ * dokładnym (patrz PolySetExact) - modulo @f$2^{64}@f$.
+ * @param[in] p : wielomian @f$p@f$
+ * @param[in] n : liczba podstawianych liczb
+ * @param[in] values : podstawiane liczby @f$v_0, \ldots, v_{n-1}@f$
+ * @return @f$p(v_0, \ldots, v_{n-1}, 0, 0, \ldots)@f$
+ */
+poly_coeff_t PolyEval(const Poly *p, size_t n, const poly_coeff_t values[]);
+
 /**
  * Wypisuje wielomian.
  * @param[in] p : wielomian
@@ -0,0 +1,1371 @@
+/** @file
+  Testy wydajnościowe biblioteki wielomianów rzadkich wielu zmiennych.
+  Uruchomienie bez argumentów wykonuje wszystkie testy, a podanie nazw
+  testów jako argumentów wykonuje tylko wybrane.
+
+  @author Szymon Łukasik <sl428760@mimuw.students.edu.pl>
+  @date 2021
+*/
+
+#define _POSIX_C_SOURCE 199309L
+#define _DEFAULT_SOURCE
+
+#include <inttypes.h>
+#include <malloc.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <linux/perf_event.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include "poly.h"
+#include "safe_alloc.h"
+#include "mono_sort.h"
+#include "poly_compact.h"
+#include "poly_dense.h"
+#include "poly_mod.h"
+#include "poly_points.h"
+#include "poly_program.h"
+#include "poly_eq.h"
+
+/**
+ * Zwraca bieżący czas w milisekundach.
+ * @return czas w milisekundach
+ */
+static double NowMs(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+/**
+ * Otwiera sprzętowy licznik chybień pamięci podręcznej bieżącego wątku
+ * (perf_event_open). Licznik bywa niedostępny, np. w maszynach wirtualnych.
+ * @return deskryptor licznika lub -1, gdy licznik jest niedostępny
+ */
+static int CacheMissesOpen(void) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.size = sizeof(attr);
+    attr.config = PERF_COUNT_HW_CACHE_MISSES;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return (int) syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+/**
+ * Odczytuje licznik chybień pamięci podręcznej.
+ * @param[in] fd : deskryptor licznika lub -1
+ * @return liczba chybień od otwarcia licznika lub -1, gdy jest niedostępny
+ */
+static long long CacheMissesRead(int fd) {
+    long long count;
+    if (fd < 0 || read(fd, &count, sizeof(count)) != sizeof(count))
+        return -1;
+    return count;
+}
+
+/**
+ * Tworzy wielomian jednej zmiennej o @p count jednomianach o wykładnikach
+ * @f$start, start + step, start + 2 \cdot step, \ldots@f$
+ * i współczynnikach @f$1, 2, 3, \ldots@f$.
+ * @param[in] count : liczba jednomianów
+ * @param[in] start : najmniejszy wykładnik
+ * @param[in] step : odstęp między kolejnymi wykładnikami
+ * @return wielomian
+ */
+static Poly UnivariatePoly(size_t count, poly_exp_t start, poly_exp_t step) {
+    Mono *monos = SafeCalloc(count, sizeof(Mono));
+    for (size_t i = 0; i < count; i++) {
+        Poly c = PolyFromCoeff((poly_coeff_t) i + 1);
+        monos[i] = MonoFromPoly(&c, start + (poly_exp_t) i * step);
+    }
+    return PolyOwnMonos(count, monos);
+}
+
+/**
+ * Tworzy wielomian dwóch zmiennych
+ * @f$\sum_{i < count} q(x_1) x_0^i@f$, gdzie @f$q@f$ to wielomian
+ * jednej zmiennej o @p count jednomianach.
+ * @param[in] count : liczba jednomianów na każdym poziomie
+ * @return wielomian
+ */
+static Poly NestedPoly(size_t count) {
+    Poly q = UnivariatePoly(count, 0, 1);
+    Mono *monos = SafeCalloc(count, sizeof(Mono));
+    for (size_t i = 0; i < count; i++) {
+        Poly c = PolyClone(&q);
+        monos[i] = MonoFromPoly(&c, (poly_exp_t) i);
+    }
+    PolyDestroy(&q);
+    return PolyOwnMonos(count, monos);
+}
+
+/**
+ * Mierzy czas łańcucha dodawań wielomianów o przeplatających się
+ * wykładnikach.
+ */
+static void BenchAdd(void) {
+    const size_t sizes[] = {1000, 10000, 100000};
+    const int chain = 16;
+
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        Poly acc = UnivariatePoly(sizes[s], 0, 2);
+        double start = NowMs();
+        for (int k = 0; k < chain; k++) {
+            Poly q = UnivariatePoly(sizes[s], k % 2, 2);
+            Poly sum = PolyAdd(&acc, &q);
+            PolyDestroy(&acc);
+            PolyDestroy(&q);
+            acc = sum;
+        }
+        printf("add: n=%zu chain=%d: %.2f ms\n", sizes[s], chain,
+               NowMs() - start);
+        PolyDestroy(&acc);
+    }
+}
+
+/**
+ * Mierzy czas mnożenia wielomianów jednej zmiennej, w których wiele
+ * iloczynów jednomianów ma ten sam wykładnik, oraz wypisuje szczytowe
+ * zużycie pamięci procesu.
+ */
+static void BenchMul(void) {
+    const size_t sizes[] = {100, 1000, 3000};
+
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        Poly p = UnivariatePoly(sizes[s], 0, 1);
+        Poly q = UnivariatePoly(sizes[s], 0, 1);
+        double start = NowMs();
+        Poly r = PolyMul(&p, &q);
+        printf("mul: n=%zu result=%zu: %.2f ms\n", sizes[s], r.size,
+               NowMs() - start);
+        PolyDestroy(&p);
+        PolyDestroy(&q);
+        PolyDestroy(&r);
+    }
+
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    printf("mul: max rss %ld KiB\n", usage.ru_maxrss);
+}
+
+/**
+ * Wypełnia tablicę jednomianów o stałych współczynnikach wykładnikami
+ * ułożonymi według wzorca o numerze @p pattern: losowymi, losowymi
+ * z przedziału [0, 65535], posortowanymi, złożonymi z dwóch
+ * posortowanych połówek oraz posortowanymi z co setnym jednomianem
+ * zamienionym z losowym.
+ * @param[in] count : rozmiar tablicy
+ * @param[out] monos : tablica jednomianów
+ * @param[in] pattern : numer wzorca
+ */
+static void FillSortInput(size_t count, Mono monos[], int pattern) {
+    srand(428760);
+    for (size_t i = 0; i < count; i++) {
+        poly_exp_t exp = (poly_exp_t) i;
+        if (pattern == 0)
+            exp = rand();
+        else if (pattern == 1)
+            exp = rand() % 65536;
+        else if (pattern == 3)
+            exp = (poly_exp_t) (2 * (i % (count / 2)) + i / (count / 2));
+        monos[i] = (Mono) {.p = PolyFromCoeff(1), .exp = exp};
+    }
+
+    if (pattern == 4) {
+        for (size_t i = 0; i < count; i += 100) {
+            size_t j = (size_t) rand() % count;
+            Mono tmp = monos[i];
+            monos[i] = monos[j];
+            monos[j] = tmp;
+        }
+    }
+}
+
+/**
+ * Porównuje sortowanie jednomianów funkcją MonoSort z sortowaniem
+ * funkcją qsort na tablicach o różnym ułożeniu wykładników.
+ */
+static void BenchSort(void) {
+    const char *patterns[] = {"random", "random16", "sorted", "two runs",
+                              "1% swapped"};
+    const size_t count = 1000000;
+    Mono *monos = SafeCalloc(count, sizeof(Mono));
+
+    for (int pattern = 0; pattern < 5; pattern++) {
+        FillSortInput(count, monos, pattern);
+        double start = NowMs();
+        MonoSortQsort(count, monos);
+        double qsort_time = NowMs() - start;
+
+        FillSortInput(count, monos, pattern);
+        start = NowMs();
+        MonoSort(count, monos);
+        double sort_time = NowMs() - start;
+
+        printf("sort: %s n=%zu: qsort %.2f ms, MonoSort %.2f ms\n",
+               patterns[pattern], count, qsort_time, sort_time);
+    }
+
+    free(monos);
+}
+
+/**
+ * Mierzy czas tworzenia wielomianu z miliona jednomianów funkcją
+ * PolyAddMonos dla wykładników posortowanych, losowych oraz posortowanych
+ * z co setnym jednomianem zamienionym z losowym.
+ */
+static void BenchBuild(void) {
+    const int patterns[] = {2, 0, 4};
+    const char *names[] = {"sorted", "random", "1% swapped"};
+    const size_t count = 1000000;
+    Mono *monos = SafeCalloc(count, sizeof(Mono));
+
+    for (size_t k = 0; k < sizeof(patterns) / sizeof(patterns[0]); k++) {
+        FillSortInput(count, monos, patterns[k]);
+        double start = NowMs();
+        Poly p = PolyAddMonos(count, monos);
+        printf("build: %s n=%zu: %.2f ms\n", names[k], count,
+               NowMs() - start);
+        PolyDestroy(&p);
+    }
+
+    free(monos);
+}
+
+/**
+ * Porównuje sumowanie 1000 wielomianów po 100 jednomianów przez PolyAdd
+ * (z tworzeniem nowego wyniku) i przez PolyAddTo, gdy kolejne składniki
+ * mają coraz większe wykładniki oraz gdy nakładają się na siebie.
+ */
+static void BenchAddTo(void) {
+    const size_t count = 1000;
+
+    for (int overlap = 0; overlap < 2; overlap++) {
+        Poly *polys = SafeCalloc(count, sizeof(Poly));
+        for (size_t i = 0; i < count; i++)
+            polys[i] = UnivariatePoly(100, overlap ? (poly_exp_t) i
+                                                   : (poly_exp_t) (100 * i), 1);
+
+        double start = NowMs();
+        Poly sum = PolyZero();
+        for (size_t i = 0; i < count; i++) {
+            Poly tmp = PolyAdd(&sum, &polys[i]);
+            PolyDestroy(&sum);
+            sum = tmp;
+        }
+        double add_time = NowMs() - start;
+
+        start = NowMs();
+        Poly acc = PolyZero();
+        for (size_t i = 0; i < count; i++)
+            PolyAddTo(&acc, &polys[i]);
+        double add_to_time = NowMs() - start;
+
+        printf("add_to: %s: PolyAdd %.2f ms, PolyAddTo %.2f ms\n",
+               overlap ? "overlapping" : "increasing", add_time, add_to_time);
+        PolyDestroy(&sum);
+        PolyDestroy(&acc);
+        free(polys);
+    }
+}
+
+/**
+ * Tworzy wielomian trzech zmiennych
+ * @f$\sum_{i, j < count} (i + 1) x_0^{iS} x_1^{jS} x_2^{S}@f$
+ * dla @f$S = 2^{24}@f$. Iloczyn dwóch takich wielomianów ma wykładniki
+ * mieszczące się w typie poly_exp_t, ale zbyt duże, by mnożyć go przez
+ * podstawienie Kroneckera, więc zawsze mnożony jest rekurencyjnie.
+ * @param[in] count : liczba jednomianów na dwóch pierwszych poziomach
+ * @return wielomian
+ */
+static Poly SparseNestedPoly(size_t count) {
+    const poly_exp_t step = 1 << 24;
+    Poly one = PolyFromCoeff(1);
+    Mono last = MonoFromPoly(&one, step);
+    Poly x2 = PolyAddMonos(1, &last);
+    Poly q = UnivariatePoly(count, 0, step);
+    Poly inner = PolyMul(&q, &x2);
+    Mono *monos = SafeCalloc(count, sizeof(Mono));
+    for (size_t i = 0; i < count; i++) {
+        Poly c = PolyMulByCoeff(&inner, (poly_coeff_t) i + 1);
+        monos[i] = MonoFromPoly(&c, (poly_exp_t) i * step);
+    }
+    PolyDestroy(&x2);
+    PolyDestroy(&q);
+    PolyDestroy(&inner);
+    return PolyOwnMonos(count, monos);
+}
+
+/**
+ * Mierzy skalowanie mnożenia równoległego: mnoży dwa wielomiany trzech
+ * zmiennych o 64 jednomianach najwyższego poziomu (patrz
+ * SparseNestedPoly) przy 1, 2, 4, ... wątkach, aż do liczby dostępnych
+ * rdzeni (co najmniej 4). Przy każdej liczbie wątków działa ten sam
+ * algorytm mnożenia rekurencyjnego.
+ */
+static void BenchMulThreads(void) {
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    size_t max_threads = cores > 4 ? (size_t) cores : 4;
+    Poly p = SparseNestedPoly(64);
+    Poly q = SparseNestedPoly(64);
+    double base = 0;
+
+    for (size_t threads = 1; threads <= max_threads; threads *= 2) {
+        PolySetThreads(threads);
+        double start = NowMs();
+        Poly r = PolyMul(&p, &q);
+        double time = NowMs() - start;
+        if (threads == 1)
+            base = time;
+        printf("mul_threads: threads=%zu cores=%ld: %.2f ms (x%.2f)\n",
+               threads, cores, time, base / time);
+        PolyDestroy(&r);
+    }
+
+    PolySetThreads(1);
+    PolyDestroy(&p);
+    PolyDestroy(&q);
+}
+
+/**
+ * Mierzy skalowanie złożenia równoległego: składa wielomian dwóch zmiennych
+ * o 40 jednomianach najwyższego poziomu z wielomianami @f$x_0 + 1@f$ oraz
+ * @f$x_0 + x_1@f$ przy 1, 2, 4, ... wątkach, aż do liczby dostępnych
+ * rdzeni (co najmniej 4).
+ */
+static void BenchComposeThreads(void) {
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    size_t max_threads = cores > 4 ? (size_t) cores : 4;
+    Poly p = NestedPoly(40);
+    Poly q[2];
+    q[0] = UnivariatePoly(2, 0, 1);
+    Poly x1 = UnivariatePoly(1, 1, 1);
+    Poly one = PolyFromCoeff(1);
+    Mono m[2] = {MonoFromPoly(&x1, 0), MonoFromPoly(&one, 1)};
+    q[1] = PolyAddMonos(2, m);
+    double base = 0;
+
+    for (size_t threads = 1; threads <= max_threads; threads *= 2) {
+        PolySetThreads(threads);
+        double start = NowMs();
+        Poly r = PolyCompose(&p, 2, q);
+        double time = NowMs() - start;
+        if (threads == 1)
+            base = time;
+        printf("compose_threads: threads=%zu cores=%ld: %.2f ms (x%.2f)\n",
+               threads, cores, time, base / time);
+        PolyDestroy(&r);
+    }
+
+    PolySetThreads(1);
+    PolyDestroy(&p);
+    PolyDestroy(&q[0]);
+    PolyDestroy(&q[1]);
+}
+
+/**
+ * Wykonuje obciążenie złożone z mnożeń i dodawań wielomianów dwóch
+ * zmiennych o niewielkich współczynnikach-wielomianach.
+ * @param[in] rounds : liczba powtórzeń
+ */
+static void AllocWorkload(int rounds) {
+    Poly p = NestedPoly(40);
+
+    for (int r = 0; r < rounds; r++) {
+        Poly sq = PolyMul(&p, &p);
+        Poly sum = PolyAdd(&sq, &p);
+        PolyDestroy(&sq);
+        PolyDestroy(&sum);
+    }
+    PolyDestroy(&p);
+}
+
+/**
+ * Porównuje alokację przez malloc z pulą bloków i areną.
+ * Wypisuje czas oraz liczbę wywołań malloc.
+ */
+static void BenchAlloc(void) {
+    const int rounds = 5;
+    const char *names[] = {"system", "pool", "arena"};
+
+    for (int mode = 0; mode < 3; mode++) {
+        SafeAllocSetMode(mode == 0 ? ALLOC_SYSTEM : ALLOC_POOL);
+        SafeAllocResetStats();
+        double start = NowMs();
+        if (mode == 2)
+            SafeArenaBegin();
+        AllocWorkload(rounds);
+        if (mode == 2)
+            SafeArenaEnd();
+        AllocStats stats = SafeAllocGetStats();
+        printf("alloc: %s: %.2f ms, requests=%zu malloc=%zu saved=%zu\n",
+               names[mode], NowMs() - start, stats.allocs,
+               stats.system_allocs, stats.pool_hits + stats.arena_allocs);
+    }
+    SafeAllocSetMode(ALLOC_POOL);
+}
+
+/**
+ * Porównuje głęboką kopię wielomianu z kopią współdzieloną, wykonując
+ * sekwencję kopiowania, odczytu stopnia i usuwania kopii.
+ */
+static void BenchClone(void) {
+    const int rounds = 1000;
+    Poly p = NestedPoly(100);
+
+    for (int shared = 0; shared < 2; shared++) {
+        double start = NowMs();
+        for (int r = 0; r < rounds; r++) {
+            Poly c = shared ? PolyShare(&p) : PolyClone(&p);
+            PolyDeg(&c);
+            PolyDestroy(&c);
+        }
+        printf("clone: %s x%d: %.2f ms\n", shared ? "PolyShare" : "PolyClone",
+               rounds, NowMs() - start);
+    }
+    PolyDestroy(&p);
+}
+
+/**
+ * Mierzy czas wyliczania wartości wielomianu w punkcie dla wielomianu
+ * jednej zmiennej oraz wielomianu dwóch zmiennych.
+ */
+static void BenchAt(void) {
+    const int rounds = 20;
+    Poly u = UnivariatePoly(100000, 0, 3);
+    Poly n = NestedPoly(300);
+
+    double start = NowMs();
+    for (int r = 0; r < rounds; r++) {
+        Poly v = PolyAt(&u, 3);
+        PolyDestroy(&v);
+    }
+    printf("at: univariate n=100000 x%d: %.2f ms\n", rounds, NowMs() - start);
+
+    start = NowMs();
+    for (int r = 0; r < rounds; r++) {
+        Poly v = PolyAt(&n, 3);
+        PolyDestroy(&v);
+    }
+    printf("at: nested 300x300 x%d: %.2f ms\n", rounds, NowMs() - start);
+
+    PolyDestroy(&u);
+    PolyDestroy(&n);
+}
+
+/**
+ * Mierzy czas negowania wielomianu przez PolyNeg oraz w miejscu.
+ */
+static void BenchNeg(void) {
+    const int rounds = 20;
+    Poly p = NestedPoly(300);
+
+    double start = NowMs();
+    for (int r = 0; r < rounds; r++) {
+        Poly q = PolyNeg(&p);
+        PolyDestroy(&p);
+        p = q;
+    }
+    printf("neg: PolyNeg 300x300 x%d: %.2f ms\n", rounds, NowMs() - start);
+
+    start = NowMs();
+    for (int r = 0; r < rounds; r++)
+        PolyMulByCoeffInPlace(&p, -1);
+    printf("neg: in place 300x300 x%d: %.2f ms\n", rounds, NowMs() - start);
+
+    PolyDestroy(&p);
+}
+
+/**
+ * Mierzy czas złożenia wielomianu dwóch zmiennych z wielomianami
+ * @f$x_0 + 1@f$ oraz @f$x_0 + x_1@f$, a także wielomianu jednej zmiennej
+ * z gęstym wielomianem o 20 jednomianach.
+ */
+static void BenchCompose(void) {
+    const size_t sizes[] = {10, 20, 30};
+
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        Poly p = NestedPoly(sizes[s]);
+        Poly q[2];
+        q[0] = UnivariatePoly(2, 0, 1);
+        Poly x1 = UnivariatePoly(1, 1, 1);
+        Poly one = PolyFromCoeff(1);
+        Mono m[2] = {MonoFromPoly(&x1, 0), MonoFromPoly(&one, 1)};
+        q[1] = PolyAddMonos(2, m);
+
+        double start = NowMs();
+        Poly r = PolyCompose(&p, 2, q);
+        printf("compose: %zux%zu: %.2f ms\n", sizes[s], sizes[s],
+               NowMs() - start);
+
+        PolyDestroy(&r);
+        PolyDestroy(&p);
+        PolyDestroy(&q[0]);
+        PolyDestroy(&q[1]);
+    }
+
+    const size_t degrees[] = {20, 60, 120};
+
+    for (size_t s = 0; s < sizeof(degrees) / sizeof(degrees[0]); s++) {
+        Poly p = UnivariatePoly(degrees[s], 0, 1);
+        Poly q = UnivariatePoly(20, 0, 1);
+
+        double start = NowMs();
+        Poly r = PolyCompose(&p, 1, &q);
+        printf("compose: deg %zu of 20 terms: %.2f ms\n", degrees[s],
+               NowMs() - start);
+
+        PolyDestroy(&r);
+        PolyDestroy(&p);
+        PolyDestroy(&q);
+    }
+}
+
+/**
+ * Tworzy wielomian @f$(1 + x_0 + x_1 + \ldots + x_{vars-1})^n@f$.
+ * @param[in] vars : liczba zmiennych
+ * @param[in] n : wykładnik potęgi
+ * @return wielomian
+ */
+static Poly LinearPower(size_t vars, int n) {
+    Poly base = PolyFromCoeff(1);
+    for (size_t v = vars; v-- > 0;) {
+        // base = 1 + x_v * (base - 1 + 1), zaczynając od najgłębszej zmiennej
+        Poly one = PolyFromCoeff(1);
+        Mono monos[2] = {MonoFromPoly(&base, 0), MonoFromPoly(&one, 1)};
+        base = PolyAddMonos(2, monos);
+    }
+
+    Poly res = PolyFromCoeff(1);
+    for (int i = 0; i < n; i++) {
+        Poly tmp = PolyMul(&res, &base);
+        PolyDestroy(&res);
+        res = tmp;
+    }
+    PolyDestroy(&base);
+    return res;
+}
+
+/**
+ * Porównuje wyliczanie wartości wielomianu wielu zmiennych w punkcie
+ * przez PolyEval z podstawianiem kolejnych liczb funkcją PolyAt.
+ */
+static void BenchEval(void) {
+    const int rounds = 20;
+    const poly_coeff_t values[] = {3, -5, 7, 11, -13};
+    const char *names[] = {"nested 300x300", "(1+x0+x1+x2)^30",
+                           "(1+x0+...+x4)^10"};
+    const size_t vars[] = {2, 3, 5};
+    Poly polys[] = {NestedPoly(300), LinearPower(3, 30), LinearPower(5, 10)};
+
+    for (size_t i = 0; i < sizeof(polys) / sizeof(polys[0]); i++) {
+        poly_coeff_t at_value = 0, eval_value = 0;
+        double start = NowMs();
+        for (int r = 0; r < rounds; r++) {
+            Poly v = PolyClone(&polys[i]);
+            for (size_t j = 0; j < vars[i]; j++) {
+                Poly at = PolyAt(&v, values[j]);
+                PolyDestroy(&v);
+                v = at;
+            }
+            at_value = v.coeff;
+        }
+        double at_time = NowMs() - start;
+
+        start = NowMs();
+        for (int r = 0; r < rounds; r++)
+            eval_value = PolyEval(&polys[i], vars[i], values);
+        double eval_time = NowMs() - start;
+
+        printf("eval: %s x%d: at chain %.2f ms, eval %.2f ms%s\n", names[i],
+               rounds, at_time, eval_time,
+               at_value == eval_value ? "" : " (MISMATCH)");
+        PolyDestroy(&polys[i]);
+    }
+}
+
+/**
+ * Porównuje wyliczanie wartości wielomianu wielu zmiennych w wielu
+ * punktach przez PolyEval z wykonaniem programu skompilowanego z tego
+ * wielomianu. Kompilacja mierzona jest osobno.
+ */
+static void BenchProgram(void) {
+    const size_t count = 256;
+    const char *names[] = {"nested 300x300", "(1+x0+x1+x2)^30",
+                           "(1+x0+...+x4)^10"};
+    const size_t vars[] = {2, 3, 5};
+    Poly polys[] = {NestedPoly(300), LinearPower(3, 30), LinearPower(5, 10)};
+    poly_coeff_t *values = SafeCalloc(count * 5, sizeof(poly_coeff_t));
+    poly_coeff_t *eval_res = SafeCalloc(count, sizeof(poly_coeff_t));
+    poly_coeff_t *prog_res = SafeCalloc(count, sizeof(poly_coeff_t));
+    uint64_t state = 5;
+    for (size_t i = 0; i < count * 5; i++) {
+        state = state * 6364136223846793005u + 1442695040888963407u;
+        values[i] = (poly_coeff_t) state;
+    }
+
+    for (size_t i = 0; i < sizeof(polys) / sizeof(polys[0]); i++) {
+        double start = NowMs();
+        for (size_t j = 0; j < count; j++)
+            eval_res[j] = PolyEval(&polys[i], vars[i], values + j * vars[i]);
+        double eval_time = NowMs() - start;
+
+        start = NowMs();
+        PolyProgram prog = ProgramCompile(&polys[i]);
+        double compile_time = NowMs() - start;
+
+        start = NowMs();
+        ProgramEval(&prog, count, vars[i], values, prog_res);
+        double prog_time = NowMs() - start;
+
+        bool same = memcmp(eval_res, prog_res,
+                           count * sizeof(poly_coeff_t)) == 0;
+        printf("program: %s x%zu: eval %.2f ms, compile %.2f ms "
+               "(%zu instructions, %zu registers), program %.2f ms%s\n",
+               names[i], count, eval_time, compile_time, prog.size, prog.regs,
+               prog_time, same ? "" : " (MISMATCH)");
+        ProgramDestroy(&prog);
+        PolyDestroy(&polys[i]);
+    }
+    free(values);
+    free(eval_res);
+    free(prog_res);
+}
+
+/**
+ * Tworzy wielomian dwóch zmiennych jak NestedPoly, ale jego jednomiany
+ * współdzielą jedną tablicę jednomianów wielomianu @f$q@f$.
+ * @param[in] count : liczba jednomianów na każdym poziomie
+ * @return wielomian
+ */
+static Poly SharedNestedPoly(size_t count) {
+    Poly q = UnivariatePoly(count, 0, 1);
+    Mono *monos = SafeCalloc(count, sizeof(Mono));
+    for (size_t i = 0; i < count; i++) {
+        Poly c = PolyShare(&q);
+        monos[i] = MonoFromPoly(&c, (poly_exp_t) i);
+    }
+    PolyDestroy(&q);
+    return PolyOwnMonos(count, monos);
+}
+
+/**
+ * Porównuje sprawdzanie równości wielomianów zbudowanych osobno przez
+ * PolyIsEq z porównaniem probabilistycznym PolyIsEqRandom
+ * z prawdopodobieństwem błędu co najwyżej @f$2^{-64}@f$.
+ */
+static void BenchEqRandom(void) {
+    const int rounds = 20;
+    const char *names[] = {"shared nested 300x300", "nested 300x300",
+                           "(1+x0+x1+x2)^30", "(1+x0+x1+x2)^30 + 1"};
+    Poly one = PolyFromCoeff(1);
+    Poly power = LinearPower(3, 30);
+    Poly lefts[] = {SharedNestedPoly(300), NestedPoly(300),
+                    LinearPower(3, 30), LinearPower(3, 30)};
+    Poly rights[] = {SharedNestedPoly(300), NestedPoly(300),
+                     PolyClone(&power), PolyAdd(&power, &one)};
+    PolyEqSeed(1);
+
+    for (size_t i = 0; i < sizeof(lefts) / sizeof(lefts[0]); i++) {
+        bool exact = false, random = false;
+        double start = NowMs();
+        for (int r = 0; r < rounds; r++)
+            exact = PolyIsEq(&lefts[i], &rights[i]);
+        double exact_time = NowMs() - start;
+
+        start = NowMs();
+        for (int r = 0; r < rounds; r++)
+            random = PolyIsEqRandom(&lefts[i], &rights[i], 64);
+        double random_time = NowMs() - start;
+
+        printf("eq_random: %s x%d: is_eq %.2f ms, random %.2f ms%s\n",
+               names[i], rounds, exact_time, random_time,
+               exact == random ? "" : " (MISMATCH)");
+        PolyDestroy(&lefts[i]);
+        PolyDestroy(&rights[i]);
+    }
+    PolyDestroy(&power);
+}
+
+/**
+ * Tworzy losowy mały wielomian co najwyżej @p depth zmiennych
+ * o co najwyżej 4 jednomianach na każdym poziomie.
+ * @param[in] depth : największa liczba zmiennych
+ * @return wielomian
+ */
+static Poly RandomSmallPoly(int depth) {
+    if (depth == 0 || rand() % 4 == 0)
+        return PolyFromCoeff(rand() % 11 - 5);
+
+    size_t count = 1 + (size_t) rand() % 4;
+    Mono monos[4];
+    for (size_t i = 0; i < count; i++) {
+        Poly c = RandomSmallPoly(depth - 1);
+        monos[i] = MonoFromPoly(&c, rand() % 6);
+    }
+    return PolyAddMonos(count, monos);
+}
+
+/**
+ * Zwraca liczbę jednomianów wielomianu po wymnożeniu wszystkich poziomów,
+ * czyli liczbę jego niezerowych współczynników liczbowych.
+ * @param[in] p : wielomian
+ * @return liczba jednomianów
+ */
+static size_t TermsCount(const Poly *p) {
+    if (PolyIsCoeff(p))
+        return PolyIsZero(p) ? 0 : 1;
+
+    size_t count = 0;
+    for (size_t i = 0; i < p->size; i++)
+        count += TermsCount(&p->arr[i].p);
+    return count;
+}
+
+/**
+ * Zwraca liczbę bajtów zajętych na stercie według alokatora systemowego.
+ * @return liczba bajtów
+ */
+static size_t HeapBytes(void) {
+    return mallinfo2().uordblks;
+}
+
+/**
+ * Mierzy średni czas jednego mnożenia gęstych wielomianów podanym
+ * algorytmem.
+ * @param[in] mul : algorytm mnożenia
+ * @param[in] p_count : długość pierwszego czynnika
+ * @param[in] q_count : długość drugiego czynnika
+ * @param[in] reps : liczba powtórzeń
+ * @return czas jednego mnożenia w mikrosekundach
+ */
+static double DenseMulTime(void (*mul)(size_t, const uint64_t[], size_t,
+                                       const uint64_t[], uint64_t[]),
+                           size_t p_count, size_t q_count, int reps) {
+    uint64_t *p = calloc(p_count, sizeof(uint64_t));
+    uint64_t *q = calloc(q_count, sizeof(uint64_t));
+    uint64_t *res = calloc(p_count + q_count - 1, sizeof(uint64_t));
+    srand(428760);
+    for (size_t i = 0; i < p_count; i++)
+        p[i] = (uint64_t) rand() * (uint64_t) rand();
+    for (size_t i = 0; i < q_count; i++)
+        q[i] = (uint64_t) rand() * (uint64_t) rand();
+
+    double start = NowMs();
+    for (int k = 0; k < reps; k++)
+        mul(p_count, p, q_count, q, res);
+    double time = (NowMs() - start) * 1e3 / reps;
+
+    free(p);
+    free(q);
+    free(res);
+    return time;
+}
+
+/**
+ * Tworzy wielomian jednej zmiennej, w którym każdy wykładnik mniejszy
+ * niż @p count występuje z prawdopodobieństwem 1 / @p gap.
+ * @param[in] count : ograniczenie wykładników
+ * @param[in] gap : odwrotność gęstości wielomianu
+ * @return wielomian
+ */
+static Poly RandomDensePoly(size_t count, int gap) {
+    Mono *monos = SafeCalloc(count, sizeof(Mono));
+    size_t size = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (rand() % gap != 0)
+            continue;
+        Poly c = PolyFromCoeff(rand() % 1000 + 1);
+        monos[size++] = MonoFromPoly(&c, (poly_exp_t) i);
+    }
+    return PolyOwnMonos(size, monos);
+}
+
+/**
+ * Porównuje algorytmy mnożenia gęstych wielomianów jednej zmiennej
+ * (na tej podstawie dobrane są progi w DenseMul) oraz mierzy czas
+ * mnożenia PolyMul wielomianów jednej zmiennej o różnej gęstości.
+ */
+static void BenchDense(void) {
+    const size_t sizes[] = {16, 32, 64, 128, 256, 512, 1024, 2048, 4096,
+                            8192, 16384, 32768};
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        size_t n = sizes[s];
+        int reps = (int) (4096 * 4096 / (n * n)) + 1;
+        if (reps > 2000)
+            reps = 2000;
+        // Mnożenie wprost dużych wielomianów trwa zbyt długo.
+        char schoolbook[32] = "skipped";
+        if (n <= 4096)
+            snprintf(schoolbook, sizeof(schoolbook), "%.1f us",
+                     DenseMulTime(DenseMulSchoolbook, n, n, reps));
+        printf("dense: %zux%zu: schoolbook %s, karatsuba %.1f us, "
+               "ntt %.1f us\n", n, n, schoolbook,
+               DenseMulTime(DenseMulKaratsuba, n, n, reps),
+               DenseMulTime(DenseMulNtt, n, n, reps));
+    }
+
+    const size_t shorter[] = {1024, 4096, 16384};
+    for (size_t s = 0; s < sizeof(shorter) / sizeof(shorter[0]); s++)
+        printf("dense: 65536x%zu: karatsuba %.1f us, ntt %.1f us\n",
+               shorter[s],
+               DenseMulTime(DenseMulKaratsuba, 65536, shorter[s], 3),
+               DenseMulTime(DenseMulNtt, 65536, shorter[s], 3));
+
+    /* Wielomiany jednej zmiennej stopnia mniejszego niż 20000, w których
+     * każdy wykładnik występuje z prawdopodobieństwem 1 / gap. */
+    const int gaps[] = {1, 4, 16, 64, 256};
+    srand(428760);
+    for (size_t g = 0; g < sizeof(gaps) / sizeof(gaps[0]); g++) {
+        Poly p = RandomDensePoly(20000, gaps[g]);
+        Poly q = RandomDensePoly(20000, gaps[g]);
+        double start = NowMs();
+        Poly r = PolyMul(&p, &q);
+        printf("dense: PolyMul %zux%zu terms, density 1/%d: %.2f ms\n",
+               p.size, q.size, gaps[g], NowMs() - start);
+        PolyDestroy(&p);
+        PolyDestroy(&q);
+        PolyDestroy(&r);
+    }
+}
+
+/**
+ * Mierzy średni czas jednego mnożenia gęstych wielomianów modulo @p mod
+ * podanym algorytmem.
+ * @param[in] mul : algorytm mnożenia
+ * @param[in] n : długość obu czynników
+ * @param[in] mod : moduł
+ * @param[in] reps : liczba powtórzeń
+ * @return czas jednego mnożenia w mikrosekundach
+ */
+static double DenseMulModTime(void (*mul)(size_t, const uint64_t[], size_t,
+                                          const uint64_t[], const ModRing *,
+                                          uint64_t[]),
+                              size_t n, uint64_t mod, int reps) {
+    ModRing ring = NewModRing(mod);
+    uint64_t *p = calloc(n, sizeof(uint64_t));
+    uint64_t *q = calloc(n, sizeof(uint64_t));
+    uint64_t *res = calloc(2 * n - 1, sizeof(uint64_t));
+    srand(428760);
+    for (size_t i = 0; i < n; i++) {
+        p[i] = ((uint64_t) rand() * (uint64_t) rand()) % mod;
+        q[i] = ((uint64_t) rand() * (uint64_t) rand()) % mod;
+    }
+
+    double start = NowMs();
+    for (int k = 0; k < reps; k++)
+        mul(n, p, n, q, &ring, res);
+    double time = (NowMs() - start) * 1e3 / reps;
+
+    free(p);
+    free(q);
+    free(res);
+    return time;
+}
+
+/**
+ * Porównuje mnożenie modularne redukcją Barretta i Montgomery'ego
+ * z dzieleniem 128-bitowym, mnożenie gęstych wielomianów modulo
+ * @f$2^{61} - 1@f$ wprost
+ * i transformatą NTT (na tej podstawie dobrany jest próg w DenseMulMod)
+ * oraz czas PolyMul w trybie modulo @f$2^{64}@f$ i w trybie modularnym.
+ */
+static void BenchMod(void) {
+    /* Sumy iloczynów stałego czynnika i kolejnych elementów tablicy, jak
+     * w wewnętrznej pętli mnożenia wielomianów wprost. */
+    const uint64_t mods[] = {1000000007, (UINT64_C(1) << 61) - 1,
+                             (UINT64_C(1) << 61) - 2};
+    const size_t count = 4096;
+    const int rounds = 5000;
+    uint64_t *values = SafeCalloc(count, sizeof(uint64_t));
+    for (size_t m = 0; m < sizeof(mods) / sizeof(mods[0]); m++) {
+        ModRing ring = NewModRing(mods[m]);
+        srand(428760);
+        for (size_t i = 0; i < count; i++)
+            values[i] = ((uint64_t) rand() * (uint64_t) rand()) % mods[m];
+        uint64_t factor = values[count / 2];
+        uint64_t sums[3] = {0, 0, 0};
+        double times[3];
+        for (int kind = 0; kind < 3; kind++) {
+            uint64_t prepared = ModFactor(&ring, factor);
+            double start = NowMs();
+            for (int k = 0; k < rounds; k++) {
+                for (size_t i = 0; i < count; i++) {
+                    uint64_t product;
+                    if (kind == 0)
+                        product = ModMul(&ring, factor, values[i]);
+                    else if (kind == 1)
+                        product = ModMulBy(&ring, prepared, values[i]);
+                    else
+                        product = (uint64_t) ((unsigned __int128) factor
+                                              * values[i] % mods[m]);
+                    sums[kind] = ModAdd(&ring, sums[kind], product);
+                }
+            }
+            times[kind] = (NowMs() - start) * 1e6 / ((double) rounds * count);
+        }
+        printf("mod: m=%" PRIu64 ": barrett %.2f ns, montgomery %.2f ns, "
+               "division %.2f ns%s\n", mods[m], times[0], times[1], times[2],
+               sums[0] == sums[1] && sums[1] == sums[2] ? ""
+                                                        : " (wrong result)");
+    }
+    free(values);
+
+    const size_t sizes[] = {16, 32, 64, 128, 256, 512, 1024, 4096};
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        size_t n = sizes[s];
+        int reps = (int) (4096 * 4096 / (n * n)) + 1;
+        if (reps > 2000)
+            reps = 2000;
+        uint64_t mod = (UINT64_C(1) << 61) - 1;
+        printf("mod: dense %zux%zu: schoolbook %.1f us, ntt %.1f us\n", n, n,
+               DenseMulModTime(DenseMulSchoolbookMod, n, mod, reps),
+               DenseMulModTime(DenseMulNttMod, n, mod, reps));
+    }
+
+    const int gaps[] = {1, 16, 256};
+    const poly_coeff_t modulus[] = {0, (INT64_C(1) << 61) - 1};
+    for (size_t g = 0; g < sizeof(gaps) / sizeof(gaps[0]); g++) {
+        for (size_t m = 0; m < 2; m++) {
+            srand(428760);
+            Poly p = RandomDensePoly(20000, gaps[g]);
+            Poly q = RandomDensePoly(20000, gaps[g]);
+            PolySetModulus(modulus[m]);
+            double start = NowMs();
+            Poly r = PolyMul(&p, &q);
+            printf("mod: PolyMul density 1/%d, modulus %" PRId64 ": %.2f ms\n",
+                   gaps[g], modulus[m], NowMs() - start);
+            PolySetModulus(0);
+            PolyDestroy(&p);
+            PolyDestroy(&q);
+            PolyDestroy(&r);
+        }
+    }
+
+    Poly p = NestedPoly(150);
+    for (size_t m = 0; m < 2; m++) {
+        PolySetModulus(modulus[m]);
+        double start = NowMs();
+        Poly r = PolyMul(&p, &p);
+        printf("mod: PolyMul nested 150x150, modulus %" PRId64 ": %.2f ms\n",
+               modulus[m], NowMs() - start);
+        PolySetModulus(0);
+        PolyDestroy(&r);
+    }
+    PolyDestroy(&p);
+}
+
+/** Liczba działań mierzonych testem wydajnościowym exact. */
+#define EXACT_WORKLOADS 5
+
+/** Nazwy działań mierzonych testem wydajnościowym exact. */
+static const char *const EXACT_NAMES[EXACT_WORKLOADS] = {
+        "add chain n=100000", "at univariate n=100000 x=1 x20",
+        "at nested 300x300 x=-1 x20", "neg in place 300x300 x20",
+        "mul nested 150x150"};
+
+/**
+ * Wykonuje jedno z działań testu wydajnościowego exact. Wyniki wszystkich
+ * działań mieszczą się w typie poly_coeff_t.
+ * @param[in] kind : numer działania
+ * @param[in] u : wielomian jednej zmiennej o 100000 jednomianach
+ * @param[in, out] n : wielomian dwóch zmiennych 300x300
+ * @param[in] m : wielomian dwóch zmiennych 150x150
+ */
+static void ExactWorkload(int kind, const Poly *u, Poly *n, const Poly *m) {
+    const int rounds = 20;
+    Poly acc = PolyZero();
+    for (int r = 0; kind == 0 && r < rounds; r++) {
+        Poly sum = PolyAdd(&acc, u);
+        PolyDestroy(&acc);
+        acc = sum;
+    }
+    for (int r = 0; kind == 1 && r < rounds; r++) {
+        Poly v = PolyAt(u, 1);
+        PolyDestroy(&v);
+    }
+    for (int r = 0; kind == 2 && r < rounds; r++) {
+        Poly v = PolyAt(n, -1);
+        PolyDestroy(&v);
+    }
+    for (int r = 0; kind == 3 && r < rounds; r++)
+        PolyMulByCoeffInPlace(n, -1);
+    if (kind == 4) {
+        Poly v = PolyMul(m, m);
+        PolyDestroy(&v);
+    }
+    PolyDestroy(&acc);
+}
+
+/**
+ * Porównuje czas działań na wielomianach w zwykłym i w dokładnym trybie
+ * współczynników, gdy żaden współczynnik nie przepełnia typu
+ * poly_coeff_t, oraz czas wyliczania wartości wielomianu, przy którym
+ * współczynniki są promowane do liczb dowolnej wielkości.
+ */
+static void BenchExact(void) {
+    Poly u = UnivariatePoly(100000, 0, 3);
+    Poly n = NestedPoly(300);
+    Poly m = NestedPoly(150);
+    for (int kind = 0; kind < EXACT_WORKLOADS; kind++) {
+        double times[2];
+        for (int exact = 0; exact < 2; exact++) {
+            PolySetExact(exact == 1);
+            double start = NowMs();
+            ExactWorkload(kind, &u, &n, &m);
+            times[exact] = NowMs() - start;
+            PolySetExact(false);
+        }
+        printf("exact: %s: wrap %.2f ms, exact %.2f ms\n", EXACT_NAMES[kind],
+               times[0], times[1]);
+    }
+    PolyDestroy(&u);
+    PolyDestroy(&n);
+    PolyDestroy(&m);
+
+    const size_t sizes[] = {100, 1000, 3000};
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        Poly p = UnivariatePoly(sizes[s], 0, 1);
+        double times[2];
+        for (int exact = 0; exact < 2; exact++) {
+            PolySetExact(exact == 1);
+            double start = NowMs();
+            Poly v = PolyAt(&p, 3);
+            times[exact] = NowMs() - start;
+            PolyDestroy(&v);
+            PolySetExact(false);
+        }
+        printf("exact: at univariate n=%zu x=3 (promoted): wrap %.2f ms, "
+               "exact %.2f ms\n", sizes[s], times[0], times[1]);
+        PolyDestroy(&p);
+    }
+}
+
+/**
+ * Mierzy najkrótszy z pięciu czasów wyliczania wartości wielomianu
+ * w @p count punktach, poprzedzonych jednym niemierzonym wyliczeniem
+ * rozgrzewającym pamięć podręczną i alokator.
+ * @param[in] p : wielomian
+ * @param[in] count : liczba punktów
+ * @param[in] xs : punkty
+ * @param[in] batch : czy liczyć funkcją PolyAtPoints zamiast PolyAt
+ * @return czas w milisekundach
+ */
+static double AtPointsTime(const Poly *p, size_t count,
+                           const poly_coeff_t xs[], bool batch) {
+    Poly *values = SafeCalloc(count, sizeof(Poly));
+    double best = 0;
+    for (int r = -1; r < 5; r++) {
+        double start = NowMs();
+        if (batch)
+            PolyAtPoints(p, count, xs, values);
+        else
+            for (size_t j = 0; j < count; j++)
+                values[j] = PolyAt(p, xs[j]);
+        double time = NowMs() - start;
+        if (r == 0 || (r > 0 && time < best))
+            best = time;
+        for (size_t j = 0; j < count; j++)
+            PolyDestroy(&values[j]);
+    }
+    free(values);
+    return best;
+}
+
+/**
+ * Porównuje przepustowość (punkty na sekundę) wyliczania wartości
+ * wielomianu w wielu punktach przez PolyAt dla kolejnych punktów
+ * i przez PolyAtPoints liczącą w akumulatorach skalarnych oraz
+ * w torach wektorów, modulo @f$2^{64}@f$ i modulo liczba pierwsza.
+ */
+static void BenchAtPoints(void) {
+    const size_t count = 20000;
+    poly_coeff_t *xs = SafeCalloc(count, sizeof(poly_coeff_t));
+    uint64_t state = 428760;
+    for (size_t j = 0; j < count; j++) {
+        state = state * 6364136223846793005u + 1442695040888963407u;
+        xs[j] = (poly_coeff_t) state;
+    }
+
+    const char *names[] = {"dense n=100", "dense n=1000", "sparse n=1000",
+                           "nested 30x30"};
+    Poly polys[] = {UnivariatePoly(100, 0, 1), UnivariatePoly(1000, 0, 1),
+                    UnivariatePoly(1000, 0, 3), NestedPoly(30)};
+    for (size_t i = 0; i < sizeof(polys) / sizeof(polys[0]); i++) {
+        for (int mod = 0; mod < 2; mod++) {
+            PolySetModulus(mod == 0 ? 0 : 1000000007);
+            Poly p = PolyReduceCoeffs(&polys[i]);
+            double single = AtPointsTime(&p, count, xs, false);
+            PointsSetSimd(false);
+            double scalar = AtPointsTime(&p, count, xs, true);
+            bool simd = PointsSetSimd(true);
+            printf("at_points: %s %s: at %.2f Mpts/s, batch scalar "
+                   "%.2f Mpts/s", names[i], mod == 0 ? "wrap" : "mod p",
+                   count / single / 1000, count / scalar / 1000);
+            // Tory wektorów liczą tylko modulo 2^64.
+            if (simd && mod == 0)
+                printf(", batch avx2 %.2f Mpts/s",
+                       count / AtPointsTime(&p, count, xs, true) / 1000);
+            printf("\n");
+            PolyDestroy(&p);
+        }
+        PolySetModulus(0);
+        PolyDestroy(&polys[i]);
+    }
+    free(xs);
+}
+
+/**
+ * Porównuje pamięć zajmowaną przez 200000 małych wielomianów trzech
+ * zmiennych (tablica 16-bajtowych elementów, jak na stosie kalkulatora)
+ * w zwykłej i w zwartej postaci. Pamięć mierzona jest na stercie
+ * alokatora systemowego, razem z narzutem na każdą alokację.
+ */
+static void BenchCompact(void) {
+    const size_t count = 200000;
+    SafeAllocSetMode(ALLOC_SYSTEM);
+    srand(428760);
+
+    size_t base = HeapBytes();
+    Poly *polys = SafeCalloc(count, sizeof(Poly));
+    size_t terms = 0;
+    for (size_t i = 0; i < count; i++) {
+        polys[i] = RandomSmallPoly(3);
+        terms += TermsCount(&polys[i]);
+    }
+    size_t poly_bytes = HeapBytes() - base;
+
+    double start = NowMs();
+    CompactPoly *compact = SafeCalloc(count, sizeof(CompactPoly));
+    for (size_t i = 0; i < count; i++) {
+        compact[i] = CompactFromPoly(&polys[i]);
+        PolyDestroy(&polys[i]);
+    }
+    free(polys);
+    double compact_time = NowMs() - start;
+    size_t compact_bytes = HeapBytes() - base;
+
+    start = NowMs();
+    for (size_t i = 0; i < count; i++) {
+        Poly p = PolyFromCompact(&compact[i]);
+        PolyDestroy(&p);
+    }
+    double expand_time = NowMs() - start;
+
+    printf("compact: %zu polys, %zu terms\n", count, terms);
+    printf("compact: Poly %.1f bytes/term, compact %.1f bytes/term\n",
+           (double) poly_bytes / (double) terms,
+           (double) compact_bytes / (double) terms);
+    printf("compact: compact %.2f ms, expand %.2f ms\n", compact_time,
+           expand_time);
+
+    for (size_t i = 0; i < count; i++)
+        CompactDestroy(&compact[i]);
+    free(compact);
+    SafeAllocSetMode(ALLOC_POOL);
+}
+
+/**
+ * Mierzy czas odczytu stopnia wielomianu oraz porównania wielomianów
+ * różniących się jednym współczynnikiem w ostatnim jednomianie.
+ */
+static void BenchMetadata(void) {
+    const int rounds = 1000;
+    Poly p = NestedPoly(300), other = NestedPoly(300);
+    Poly last = PolyFromCoeff(1);
+    Mono m = MonoFromPoly(&last, 299);
+    Poly diff = PolyAddMonos(1, &m);
+    // Wielomian zbudowany osobno, by nie współdzielił tablic z p.
+    Poly q = PolyAdd(&other, &diff);
+
+    double start = NowMs();
+    poly_exp_t deg = 0;
+    for (int r = 0; r < rounds; r++)
+        deg = PolyDeg(&p);
+    printf("metadata: deg nested 300x300 x%d: %.2f ms (deg=%d)\n", rounds,
+           NowMs() - start, deg);
+
+    start = NowMs();
+    bool eq = true;
+    for (int r = 0; r < rounds; r++)
+        eq = PolyIsEq(&p, &q);
+    printf("metadata: is_eq nested 300x300, last coeff differs x%d: "
+           "%.2f ms (%s)\n", rounds, NowMs() - start, eq ? "eq" : "ne");
+
+    for (size_t var = 1; var <= 2; var++) {
+        start = NowMs();
+        for (int r = 0; r < rounds; r++)
+            deg = PolyDegBy(&p, var);
+        printf("metadata: deg_by x%zu nested 300x300 x%d: %.2f ms "
+               "(deg=%d)\n", var, rounds, NowMs() - start, deg);
+    }
+
+    // Wielomian trzech zmiennych, dla którego PolyDegBy przegląda drzewo.
+    Poly power = LinearPower(3, 30);
+    for (size_t var = 1; var <= 2; var++) {
+        start = NowMs();
+        for (int r = 0; r < rounds; r++)
+            deg = PolyDegBy(&power, var);
+        printf("metadata: deg_by x%zu (1+x0+x1+x2)^30 x%d: %.2f ms "
+               "(deg=%d)\n", var, rounds, NowMs() - start, deg);
+    }
+
+    PolyDestroy(&power);
+    PolyDestroy(&p);
+    PolyDestroy(&other);
+    PolyDestroy(&q);
+    PolyDestroy(&diff);
+}
+
+/**
+ * Tworzy wielomian dwóch zmiennych @f$\sum_{i < count} q(x_1) x_0^i@f$
+ * jak NestedPoly, ale z wykładnikiem ostatniego jednomianu najwyższego
+ * poziomu zwiększonym o @p last_shift.
+ * @param[in] count : liczba jednomianów na każdym poziomie
+ * @param[in] last_shift : przesunięcie ostatniego wykładnika
+ * @return wielomian
+ */
+static Poly NestedPolyShifted(size_t count, poly_exp_t last_shift) {
+    Poly q = UnivariatePoly(count, 0, 1);
+    Mono *monos = SafeCalloc(count, sizeof(Mono));
+    for (size_t i = 0; i < count; i++) {
+        Poly c = PolyClone(&q);
+        poly_exp_t exp = (poly_exp_t) i + (i + 1 == count ? last_shift : 0);
+        monos[i] = MonoFromPoly(&c, exp);
+    }
+    PolyDestroy(&q);
+    return PolyOwnMonos(count, monos);
+}
+
+/**
+ * Wypisuje czas i liczbę chybień pamięci podręcznej fragmentu testu
+ * układu pamięci.
+ * @param[in] name : nazwa fragmentu
+ * @param[in] start : czas rozpoczęcia w milisekundach
+ * @param[in] fd : deskryptor licznika chybień lub -1
+ * @param[in] misses : stan licznika w chwili rozpoczęcia
+ */
+static void LayoutReport(const char *name, double start, int fd,
+                         long long misses) {
+    double time = NowMs() - start;
+    long long end = CacheMissesRead(fd);
+    if (end < 0)
+        printf("layout: %s: %.2f ms, cache misses n/a\n", name, time);
+    else
+        printf("layout: %s: %.2f ms, cache misses %lld\n", name, time,
+               end - misses);
+}
+
+/**
+ * Mierzy operacje przeglądające głównie wykładniki: scalanie przy
+ * dodawaniu, mnożenie rzadkich wielomianów kopcem oraz porównywanie
+ * wielomianów różniących się dopiero ostatnim wykładnikiem, a także
+ * równych. Jeśli dostępny jest licznik sprzętowy, wypisuje też liczbę
+ * chybień pamięci podręcznej.
+ */
+static void BenchLayout(void) {
+    int fd = CacheMissesOpen();
+
+    Poly p = UnivariatePoly(100000, 0, 2);
+    Poly q = UnivariatePoly(100000, 1, 2);
+    double start = NowMs();
+    long long misses = CacheMissesRead(fd);
+    for (int k = 0; k < 20; k++) {
+        Poly r = PolyAdd(&p, &q);
+        PolyDestroy(&r);
+    }
+    LayoutReport("merge 100000+100000 x20", start, fd, misses);
+    PolyDestroy(&p);
+    PolyDestroy(&q);
+
+    p = UnivariatePoly(1000, 0, 1000);
+    q = UnivariatePoly(1000, 0, 1);
+    start = NowMs();
+    misses = CacheMissesRead(fd);
+    Poly r = PolyMul(&p, &q);
+    LayoutReport("sparse mul 1000x1000", start, fd, misses);
+    PolyDestroy(&p);
+    PolyDestroy(&q);
+    PolyDestroy(&r);
+
+    p = NestedPolyShifted(400, 0);
+    q = NestedPolyShifted(400, 1);
+    Poly p_copy = PolyClone(&p);
+    bool eq = true;
+    start = NowMs();
+    misses = CacheMissesRead(fd);
+    for (int k = 0; k < 100; k++)
+        eq &= !PolyIsEq(&p, &q);
+    LayoutReport("is_eq differing 400x400 x100", start, fd, misses);
+    start = NowMs();
+    misses = CacheMissesRead(fd);
+    for (int k = 0; k < 100; k++)
+        eq &= PolyIsEq(&p, &p_copy);
+    LayoutReport("is_eq equal 400x400 x100", start, fd, misses);
+    if (!eq)
+        printf("layout: wrong is_eq result\n");
+    PolyDestroy(&p);
+    PolyDestroy(&q);
+    PolyDestroy(&p_copy);
+
+    if (fd >= 0)
+        close(fd);
+}
+
+/** Opis pojedynczego testu wydajnościowego. */
+typedef struct Bench {
+    const char *name; ///< nazwa testu
+    void (*run)(void); ///< funkcja wykonująca test
+} Bench;
+
+/** Tablica dostępnych testów wydajnościowych. */
+static const Bench BENCHES[] = {
+        {"add", BenchAdd},
+        {"mul", BenchMul},
+        {"mul_threads", BenchMulThreads},
+        {"alloc", BenchAlloc},
+        {"clone", BenchClone},
+        {"at", BenchAt},
+        {"neg", BenchNeg},
+        {"compose", BenchCompose},
+        {"sort", BenchSort},
+        {"build", BenchBuild},
+        {"add_to", BenchAddTo},
+        {"compose_threads", BenchComposeThreads},
+        {"layout", BenchLayout},
+        {"compact", BenchCompact},
+        {"dense", BenchDense},
+        {"mod", BenchMod},
+        {"exact", BenchExact},
+        {"at_points", BenchAtPoints},
+        {"eval", BenchEval},
+        {"program", BenchProgram},
+        {"eq_random", BenchEqRandom},
+        {"metadata", BenchMetadata},
+};
+
+/**
+ * Uruchamia wybrane testy wydajnościowe.
+ * @param[in] argc : liczba argumentów
+ * @param[in] argv : nazwy testów do uruchomienia
+ * @return 0
+ */
+int main(int argc, char **argv) {
+    size_t count = sizeof(BENCHES) / sizeof(BENCHES[0]);
+
+    for (size_t i = 0; i < count; i++) {
+        bool selected = argc < 2;
+        for (int j = 1; j < argc; j++)
+            if (strcmp(argv[j], BENCHES[i].name) == 0)
+                selected = true;
+        if (selected)
+            BENCHES[i].run();
+    }
+
+    return 0;
+}
@@ -0,0 +1,236 @@
+/** @file
+  Implementacja biblioteki udostępniającej zwartą postać wielomianów.
+
+  @author Szymon Łukasik <sl428760@mimuw.students.edu.pl>
+  @date 2021
+*/
+
+#include <stdlib.h>
+
+#include "safe_alloc.h"
+#include "poly_compact.h"
+
+/** Współczynnik węzła jest liczbą. */
+#define COMPACT_COEFF 0
+
+/** Współczynnik węzła jest wielomianem o jednym jednomianie z liczbowym
+ * współczynnikiem. */
+#define COMPACT_SINGLE 1
+
+/** Współczynnik węzła jest wielomianem zapisanym w tablicy węzłów. */
+#define COMPACT_ARRAY 2
+
+/** Największa wartość 30-bitowego pola węzła. */
+#define COMPACT_FIELD_MAX ((UINT64_C(1) << 30) - 1)
+
+/** Znacznik wielomianu o jednym jednomianie z liczbowym współczynnikiem. */
+#define COMPACT_TAG_SINGLE 1
+
+/** Znacznik wielomianu zapisanego w bloku węzłów. */
+#define COMPACT_TAG_ARRAY 3
+
+/** Maska znacznika wielomianu w postaci zwartej. */
+#define COMPACT_TAG_MASK 3
+
+/**
+ * Tworzy nagłówek węzła.
+ * @param[in] exp : wykładnik jednomianu
+ * @param[in] kind : rodzaj współczynnika
+ * @param[in] field : liczba jednomianów lub wykładnik współczynnika
+ * @return nagłówek węzła
+ */
+static inline uint64_t NodeHead(poly_exp_t exp, uint64_t kind, uint64_t field) {
+    assert(field <= COMPACT_FIELD_MAX);
+    return (uint64_t) (uint32_t) exp | kind << 32 | field << 34;
+}
+
+/**
+ * Zwraca wykładnik jednomianu zapisanego w węźle.
+ * @param[in] node : węzeł
+ * @return wykładnik
+ */
+static inline poly_exp_t NodeExp(const CompactNode *node) {
+    return (poly_exp_t) (uint32_t) node->head;
+}
+
+/**
+ * Zwraca rodzaj współczynnika jednomianu zapisanego w węźle.
+ * @param[in] node : węzeł
+ * @return rodzaj współczynnika
+ */
+static inline uint64_t NodeKind(const CompactNode *node) {
+    return (node->head >> 32) & 3;
+}
+
+/**
+ * Zwraca 30-bitowe pole węzła: liczbę jednomianów lub wykładnik
+ * współczynnika.
+ * @param[in] node : węzeł
+ * @return wartość pola
+ */
+static inline uint64_t NodeField(const CompactNode *node) {
+    return node->head >> 34;
+}
+
+/**
+ * Sprawdza, czy wielomian ma jeden jednomian z liczbowym współczynnikiem
+ * i wykładnikiem nie większym niż @p max_exp.
+ * @param[in] p : wielomian
+ * @param[in] max_exp : największy dopuszczalny wykładnik
+ * @return Czy wielomian można zapisać bez tablicy węzłów?
+ */
+static bool IsSingle(const Poly *p, uint64_t max_exp) {
+    return !PolyIsCoeff(p) && p->size == 1 && PolyIsCoeff(&p->arr[0].p)
+           && (uint64_t) p->arr[0].exp <= max_exp;
+}
+
+/**
+ * Zwraca liczbę węzłów potrzebnych do zapisania jednomianów wielomianu
+ * i wszystkich ich współczynników.
+ * @param[in] p : wielomian niebędący współczynnikiem
+ * @return liczba węzłów
+ */
+static size_t NodesCount(const Poly *p) {
+    size_t count = p->size;
+    for (size_t i = 0; i < p->size; i++) {
+        const Poly *coeff = &p->arr[i].p;
+        if (!PolyIsCoeff(coeff) && !IsSingle(coeff, COMPACT_FIELD_MAX))
+            count += NodesCount(coeff);
+    }
+    return count;
+}
+
+/**
+ * Zapisuje jednomiany wielomianu w tablicy węzłów @p nodes,
+ * a jednomiany ich współczynników w kolejnych wolnych węzłach bloku.
+ * @param[in] p : wielomian niebędący współczynnikiem
+ * @param[out] nodes : tablica @p p->size węzłów
+ * @param[in, out] free_nodes : wskaźnik na pierwszy wolny węzeł bloku
+ */
+static void FillNodes(const Poly *p, CompactNode nodes[],
+                      CompactNode **free_nodes) {
+    for (size_t i = 0; i < p->size; i++) {
+        const Poly *coeff = &p->arr[i].p;
+        poly_exp_t exp = p->arr[i].exp;
+
+        if (PolyIsCoeff(coeff)) {
+            nodes[i].head = NodeHead(exp, COMPACT_COEFF, 0);
+            nodes[i].coeff = coeff->coeff;
+        } else if (IsSingle(coeff, COMPACT_FIELD_MAX)) {
+            nodes[i].head = NodeHead(exp, COMPACT_SINGLE,
+                                     (uint64_t) coeff->arr[0].exp);
+            nodes[i].coeff = coeff->arr[0].p.coeff;
+        } else {
+            CompactNode *monos = *free_nodes;
+            *free_nodes += coeff->size;
+            nodes[i].head = NodeHead(exp, COMPACT_ARRAY, coeff->size);
+            nodes[i].monos = monos;
+            FillNodes(coeff, monos, free_nodes);
+        }
+    }
+}
+
+CompactPoly CompactFromPoly(const Poly *p) {
+    assert(!PolyHasBigCoeffs(p));
+    if (PolyIsCoeff(p))
+        return (CompactPoly) {.value = (uint64_t) p->coeff, .tagged = 0};
+
+    if (IsSingle(p, INT32_MAX))
+        return (CompactPoly) {
+                .value = (uint64_t) p->arr[0].p.coeff,
+                .tagged = (uintptr_t) p->arr[0].exp << 2 | COMPACT_TAG_SINGLE};
+
+    assert(p->size <= COMPACT_FIELD_MAX);
+    size_t count = NodesCount(p);
+    CompactNode *nodes = SafeRealloc(NULL, count * sizeof(CompactNode));
+    CompactNode *free_nodes = nodes + p->size;
+    FillNodes(p, nodes, &free_nodes);
+    assert(free_nodes == nodes + count);
+
+    return (CompactPoly) {.value = p->size,
+                          .tagged = (uintptr_t) nodes | COMPACT_TAG_ARRAY};
+}
+
+/**
+ * Tworzy wielomian @f$c x_0^n@f$.
+ * @param[in] c : współczynnik
+ * @param[in] n : wykładnik
+ * @return wielomian
+ */
+static Poly PolySingle(poly_coeff_t c, poly_exp_t n) {
+    Poly coeff = PolyFromCoeff(c);
+    Mono m = MonoFromPoly(&coeff, n);
+    PolyBuilder builder = NewPolyBuilder(1);
+    PolyBuilderAdd(&builder, &m);
+    return PolyBuilderFinish(&builder);
+}
+
+/**
+ * Odtwarza wielomian z tablicy węzłów.
+ * @param[in] count : liczba węzłów
+ * @param[in] nodes : tablica węzłów
+ * @return wielomian
+ */
+static Poly PolyFromNodes(size_t count, const CompactNode nodes[]) {
+    PolyBuilder builder = NewPolyBuilder(count);
+
+    for (size_t i = 0; i < count; i++) {
+        const CompactNode *node = &nodes[i];
+        Poly coeff;
+        switch (NodeKind(node)) {
+            case COMPACT_COEFF:
+                coeff = PolyFromCoeff(node->coeff);
+                break;
+            case COMPACT_SINGLE:
+                coeff = PolySingle(node->coeff, (poly_exp_t) NodeField(node));
+                break;
+            default:
+                coeff = PolyFromNodes(NodeField(node), node->monos);
+                break;
+        }
+        Mono m = MonoFromPoly(&coeff, NodeExp(node));
+        PolyBuilderAdd(&builder, &m);
+    }
+
+    return PolyBuilderFinish(&builder);
+}
+
+Poly PolyFromCompact(const CompactPoly *c) {
+    switch (c->tagged & COMPACT_TAG_MASK) {
+        case COMPACT_TAG_SINGLE:
+            return PolySingle((poly_coeff_t) c->value,
+                              (poly_exp_t) (c->tagged >> 2));
+        case COMPACT_TAG_ARRAY:
+            return PolyFromNodes(c->value, (const CompactNode *)
+                    (c->tagged & ~(uintptr_t) COMPACT_TAG_MASK));
+        default:
+            return PolyFromCoeff((poly_coeff_t) c->value);
+    }
+}
+
+void CompactDestroy(CompactPoly *c) {
+    if ((c->tagged & COMPACT_TAG_MASK) == COMPACT_TAG_ARRAY)
+        free((void *) (c->tagged & ~(uintptr_t) COMPACT_TAG_MASK));
+    *c = (CompactPoly) {.value = 0, .tagged = 0};
+}
+
+/**
+ * Zwraca liczbę węzłów tablicy węzłów wraz z węzłami współczynników.
+ * @param[in] count : liczba węzłów
+ * @param[in] nodes : tablica węzłów
+ * @return liczba węzłów
+ */
+static size_t NodesTotal(size_t count, const CompactNode nodes[]) {
+    size_t total = count;
+    for (size_t i = 0; i < count; i++)
+        if (NodeKind(&nodes[i]) == COMPACT_ARRAY)
+            total += NodesTotal(NodeField(&nodes[i]), nodes[i].monos);
+    return total;
+}
+
+size_t CompactBytes(const CompactPoly *c) {
+    if ((c->tagged & COMPACT_TAG_MASK) != COMPACT_TAG_ARRAY)
+        return 0;
+    return NodesTotal(c->value, (const CompactNode *)
+            (c->tagged & ~(uintptr_t) COMPACT_TAG_MASK)) * sizeof(CompactNode);
+}
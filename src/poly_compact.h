@@ -0,0 +1,100 @@
+/** @file
+  Biblioteka udostępniająca zwartą postać wielomianów rzadkich wielu
+  zmiennych, przeznaczoną do przechowywania wielomianów, na których
+  nie są wykonywane działania (np. głębiej na stosie kalkulatora).
+
+  Wielomian w postaci zwartej zajmuje 16 bajtów, tyle co struktura Poly,
+  i przechowuje bezpośrednio współczynnik, jednomian postaci
+  @f$c x_0^n@f$ albo wskaźnik ze znacznikiem na jeden blok pamięci
+  zawierający wszystkie pozostałe jednomiany. Każdy jednomian w bloku
+  to 16-bajtowy węzeł łączący wykładnik z współczynnikiem albo ze
+  wskaźnikiem na jednomiany współczynnika. Jednomian, którego
+  współczynnikiem jest wielomian postaci @f$c x_{i+1}^m@f$, zapisywany
+  jest w jednym węźle, bez osobnej tablicy.
+
+  @author Szymon Łukasik <sl428760@mimuw.students.edu.pl>
+  @date 2021
+*/
+
+#ifndef __POLY_COMPACT_H__
+#define __POLY_COMPACT_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "poly.h"
+
+/**
+ * To jest struktura przechowująca jednomian w postaci zwartej.
+ * Pole @p head zawiera na młodszych 32 bitach wykładnik jednomianu,
+ * na dwóch kolejnych rodzaj współczynnika, a na pozostałych 30 bitach
+ * liczbę jednomianów współczynnika lub wykładnik jego jedynego jednomianu.
+ */
+typedef struct CompactNode {
+    uint64_t head; ///< wykładnik, rodzaj i rozmiar współczynnika
+    union {
+        poly_coeff_t coeff; ///< współczynnik liczbowy
+        const struct CompactNode *monos; ///< jednomiany współczynnika
+    };
+} CompactNode;
+
+/**
+ * To jest struktura przechowująca wielomian w postaci zwartej.
+ * Współczynnik ma tę samą reprezentację co w strukturze Poly
+ * (`tagged == 0`). W pozostałych przypadkach najmłodszy bit pola
+ * @p tagged jest ustawiony, dzięki czemu wielomian w postaci zwartej
+ * można odróżnić od wielomianu w zwykłej postaci zajmującego to samo
+ * miejsce w pamięci (patrz CompactIsCompact).
+ */
+typedef struct CompactPoly {
+    /** Współczynnik, liczba jednomianów lub współczynnik jedynego
+     * jednomianu. */
+    uint64_t value;
+    /** Zero, wskaźnik na jednomiany ze znacznikiem lub wykładnik
+     * jedynego jednomianu ze znacznikiem. */
+    uintptr_t tagged;
+} CompactPoly;
+
+/**
+ * Zapisuje wielomian w postaci zwartej. Nie modyfikuje wielomianu @p p.
+ * @param[in] p : wielomian bez dużych współczynników (patrz
+ *                PolyHasBigCoeffs)
+ * @return wielomian @p p w postaci zwartej
+ */
+CompactPoly CompactFromPoly(const Poly *p);
+
+/**
+ * Odtwarza wielomian z postaci zwartej.
+ * @param[in] c : wielomian w postaci zwartej
+ * @return wielomian
+ */
+Poly PolyFromCompact(const CompactPoly *c);
+
+/**
+ * Usuwa z pamięci wielomian w postaci zwartej.
+ * @param[in] c : wielomian w postaci zwartej
+ */
+void CompactDestroy(CompactPoly *c);
+
+/**
+ * Zwraca liczbę bajtów bloku jednomianów wielomianu w postaci zwartej.
+ * @param[in] c : wielomian w postaci zwartej
+ * @return rozmiar bloku w bajtach (0, gdy wielomian nie ma bloku)
+ */
+size_t CompactBytes(const CompactPoly *c);
+
+/**
+ * Sprawdza, czy 16 bajtów pamięci zawierających wielomian w zwykłej
+ * lub zwartej postaci zawiera wielomian w postaci zwartej.
+ * Współczynniki w obu postaciach są identyczne - dla nich zwraca fałsz.
+ * @param[in] c : wielomian w jednej z postaci
+ * @return Czy wielomian nie jest współczynnikiem w postaci zwartej?
+ */
+static inline bool CompactIsCompact(const CompactPoly *c) {
+    return (c->tagged & 1) != 0;
+}
+
+static_assert(sizeof(CompactNode) == 16, "węzeł musi zajmować 16 bajtów");
+static_assert(sizeof(CompactPoly) == sizeof(Poly),
+              "postać zwarta musi zajmować tyle miejsca co Poly");
+
+#endif // __POLY_COMPACT_H__
@@ -0,0 +1,497 @@
+/** @file
+  Implementacja biblioteki udostępniającej mnożenie gęstych wielomianów
+  jednej zmiennej.
+
+  @author Szymon Łukasik <sl428760@mimuw.students.edu.pl>
+  @date 2021
+*/
+
+#include <string.h>
+
+#include "safe_alloc.h"
+#include "poly_dense.h"
+
+/** Najmniejsza długość krótszego czynnika, od której wielomiany mnożone
+ * są algorytmem Karatsuby (wyznaczona testem wydajnościowym dense). */
+#define DENSE_KARATSUBA_MIN 32
+
+/** Koszt jednego motylka transformaty NTT (wszystkich trzech transformat
+ * dla trzech liczb pierwszych) w jednostkach mnożenia wprost (wyznaczony
+ * testem wydajnościowym dense). */
+#define DENSE_NTT_WEIGHT 20
+
+/** Koszt mnożenia wprost pary współczynników modulo @f$m@f$ w jednostkach
+ * mnożenia wprost modulo @f$2^{64}@f$ (wyznaczony testem wydajnościowym
+ * mod). */
+#define DENSE_MOD_WEIGHT 2
+
+/** Liczba liczb pierwszych, modulo które liczona jest transformata. */
+#define NTT_PRIMES_COUNT 3
+
+/**
+ * To jest struktura opisująca liczbę pierwszą postaci @f$c 2^k + 1@f$,
+ * modulo którą liczona jest transformata.
+ */
+typedef struct NttPrime {
+    uint64_t mod; ///< liczba pierwsza mniejsza niż @f$2^{62}@f$
+    uint64_t generator; ///< generator grupy multiplikatywnej
+} NttPrime;
+
+/** Liczby pierwsze transformaty: @f$29 \cdot 2^{57} + 1@f$,
+ * @f$69 \cdot 2^{55} + 1@f$ i @f$27 \cdot 2^{56} + 1@f$. Ich iloczyn
+ * przekracza @f$2^{183}@f$, a każda dopuszcza transformaty długości
+ * @f$2^{55}@f$. */
+static const NttPrime NTT_PRIMES[NTT_PRIMES_COUNT] = {
+        {.mod = UINT64_C(4179340454199820289), .generator = 3},
+        {.mod = UINT64_C(2485986994308513793), .generator = 5},
+        {.mod = UINT64_C(1945555039024054273), .generator = 5},
+};
+
+void DenseMulSchoolbook(size_t p_count, const uint64_t p[], size_t q_count,
+                        const uint64_t q[], uint64_t res[]) {
+    memset(res, 0, (p_count + q_count - 1) * sizeof(uint64_t));
+    for (size_t i = 0; i < p_count; i++) {
+        uint64_t coeff = p[i];
+        if (coeff == 0)
+            continue;
+        uint64_t *row = res + i;
+        for (size_t j = 0; j < q_count; j++)
+            row[j] += coeff * q[j];
+    }
+}
+
+/**
+ * Zwraca rozmiar tablicy pomocniczej KaratsubaBalanced.
+ * @param[in] count : długość czynników
+ * @return rozmiar tablicy pomocniczej
+ */
+static size_t KaratsubaScratch(size_t count) {
+    size_t size = 0;
+    while (count >= DENSE_KARATSUBA_MIN) {
+        count -= count / 2;
+        size += 4 * count - 1;
+    }
+    return size;
+}
+
+/**
+ * Mnoży algorytmem Karatsuby gęste wielomiany o równych długościach.
+ * @param[in] count : długość tablic @p p i @p q
+ * @param[in] p : współczynniki wielomianu @f$p@f$
+ * @param[in] q : współczynniki wielomianu @f$q@f$
+ * @param[out] res : tablica długości 2 @p count - 1 na współczynniki
+ *                   @f$p * q@f$
+ * @param[in] scratch : tablica pomocnicza o rozmiarze
+ *                      KaratsubaScratch(@p count)
+ */
+static void KaratsubaBalanced(size_t count, const uint64_t p[],
+                              const uint64_t q[], uint64_t res[],
+                              uint64_t scratch[]) {
+    if (count < DENSE_KARATSUBA_MIN) {
+        DenseMulSchoolbook(count, p, count, q, res);
+        return;
+    }
+
+    /* p = p_low + x^low p_high, q = q_low + x^low q_high. Iloczyny
+     * młodszych i starszych połówek zapisujemy od razu na swoich
+     * miejscach wyniku. */
+    size_t low = count / 2, high = count - low;
+    KaratsubaBalanced(low, p, q, res, scratch);
+    res[2 * low - 1] = 0;
+    KaratsubaBalanced(high, p + low, q + low, res + 2 * low, scratch);
+
+    uint64_t *p_sum = scratch, *q_sum = scratch + high;
+    uint64_t *middle = scratch + 2 * high;
+    for (size_t i = 0; i < high; i++) {
+        p_sum[i] = p[low + i] + (i < low ? p[i] : 0);
+        q_sum[i] = q[low + i] + (i < low ? q[i] : 0);
+    }
+    KaratsubaBalanced(high, p_sum, q_sum, middle, scratch + 4 * high - 1);
+
+    // (p_low + p_high)(q_low + q_high) - p_low q_low - p_high q_high
+    for (size_t i = 0; i < 2 * low - 1; i++)
+        middle[i] -= res[i];
+    for (size_t i = 0; i < 2 * high - 1; i++)
+        middle[i] -= res[2 * low + i];
+    for (size_t i = 0; i < 2 * high - 1; i++)
+        res[low + i] += middle[i];
+}
+
+void DenseMulKaratsuba(size_t p_count, const uint64_t p[], size_t q_count,
+                       const uint64_t q[], uint64_t res[]) {
+    if (p_count < q_count) {
+        DenseMulKaratsuba(q_count, q, p_count, p, res);
+        return;
+    }
+    if (q_count < DENSE_KARATSUBA_MIN) {
+        DenseMulSchoolbook(p_count, p, q_count, q, res);
+        return;
+    }
+
+    // Dłuższy czynnik mnożymy fragmentami długości krótszego.
+    memset(res, 0, (p_count + q_count - 1) * sizeof(uint64_t));
+    uint64_t *product = SafeRealloc(NULL, (2 * q_count - 1
+            + KaratsubaScratch(q_count)) * sizeof(uint64_t));
+    for (size_t offset = 0; offset < p_count; offset += q_count) {
+        size_t count = p_count - offset < q_count ? p_count - offset
+                                                  : q_count;
+        if (count == q_count)
+            KaratsubaBalanced(q_count, p + offset, q, product,
+                              product + 2 * q_count - 1);
+        else
+            DenseMulKaratsuba(count, p + offset, q_count, q, product);
+
+        for (size_t i = 0; i < count + q_count - 1; i++)
+            res[offset + i] += product[i];
+    }
+    free(product);
+}
+
+/**
+ * Wyznacza odwrotność niezerowej reszty modulo liczba pierwsza
+ * (z małego twierdzenia Fermata).
+ * @param[in] ring : stałe arytmetyki, moduł pierwszy
+ * @param[in] a : niezerowa reszta
+ * @return @f$a^{-1} \bmod m@f$
+ */
+static uint64_t PrimeInverse(const ModRing *ring, uint64_t a) {
+    return ModPow(ring, a, ring->mod - 2);
+}
+
+/**
+ * Wypełnia tablicę potęg pierwiastków z jedności potrzebnych kolejnym
+ * etapom transformaty. Etap łączący bloki długości @p half korzysta
+ * z potęg @f$w^0, \ldots, w^{half-1}@f$ pierwiastka @f$w@f$ stopnia
+ * 2 @p half, zapisanych w sąsiednich miejscach tablicy od indeksu
+ * @p half jako czynniki przygotowane funkcją ModFactor.
+ * @param[in] ring : stałe arytmetyki, moduł nieparzysty
+ * @param[in] root : pierwiastek stopnia @p size
+ * @param[in] size : długość transformaty, potęga dwójki
+ * @param[out] roots : tablica długości @p size
+ */
+static void RootPowers(const ModRing *ring, uint64_t root, size_t size,
+                       uint64_t roots[]) {
+    /* Dla nieparzystego modułu ModMulBy dwóch czynników w postaci
+     * Montgomery'ego daje iloczyn w tej samej postaci. */
+    root = ModFactor(ring, root);
+    for (size_t half = size / 2; half >= 1; half /= 2) {
+        uint64_t power = ModFactor(ring, 1);
+        for (size_t j = 0; j < half; j++) {
+            roots[half + j] = power;
+            power = ModMulBy(ring, root, power);
+        }
+        root = ModMulBy(ring, root, root);
+    }
+}
+
+/**
+ * Wykonuje transformatę w przód (decymacja w częstotliwości). Wynik jest
+ * w kolejności odwróconych bitów indeksów.
+ * @param[in] ring : stałe arytmetyki
+ * @param[in] size : długość tablicy, potęga dwójki
+ * @param[in, out] a : tablica reszt
+ * @param[in] roots : potęgi pierwiastka stopnia @p size z jedności
+ *                    wyznaczone przez RootPowers
+ */
+static void NttForward(const ModRing *ring, size_t size, uint64_t a[],
+                       const uint64_t roots[]) {
+    /* Lokalna kopia stałych - zapisy do tablicy a nie mogą ich zmienić,
+     * więc kompilator trzyma je w rejestrach. */
+    const ModRing local = *ring;
+    for (size_t half = size / 2; half >= 1; half /= 2) {
+        const uint64_t *twiddles = roots + half;
+        for (size_t i = 0; i < size; i += 2 * half) {
+            uint64_t *low = a + i, *high = a + i + half;
+            for (size_t j = 0; j < half; j++) {
+                uint64_t u = low[j], v = high[j];
+                low[j] = ModAdd(&local, u, v);
+                high[j] = ModMulBy(&local, twiddles[j], ModSub(&local, u, v));
+            }
+        }
+    }
+}
+
+/**
+ * Wykonuje transformatę odwrotną (decymacja w czasie) bez dzielenia przez
+ * długość. Dane wejściowe są w kolejności odwróconych bitów indeksów.
+ * @param[in] ring : stałe arytmetyki
+ * @param[in] size : długość tablicy, potęga dwójki
+ * @param[in, out] a : tablica reszt
+ * @param[in] roots : potęgi odwrotności pierwiastka stopnia @p size
+ *                    z jedności wyznaczone przez RootPowers
+ */
+static void NttInverse(const ModRing *ring, size_t size, uint64_t a[],
+                       const uint64_t roots[]) {
+    /* Lokalna kopia stałych - zapisy do tablicy a nie mogą ich zmienić,
+     * więc kompilator trzyma je w rejestrach. */
+    const ModRing local = *ring;
+    for (size_t half = 1; half < size; half *= 2) {
+        const uint64_t *twiddles = roots + half;
+        for (size_t i = 0; i < size; i += 2 * half) {
+            uint64_t *low = a + i, *high = a + i + half;
+            for (size_t j = 0; j < half; j++) {
+                uint64_t u = low[j];
+                uint64_t v = ModMulBy(&local, twiddles[j], high[j]);
+                low[j] = ModAdd(&local, u, v);
+                high[j] = ModSub(&local, u, v);
+            }
+        }
+    }
+}
+
+/**
+ * Zapisuje reszty współczynników, dopełniając tablicę zerami.
+ * @param[in] ring : stałe arytmetyki
+ * @param[in] count : liczba współczynników
+ * @param[in] coeffs : współczynniki
+ * @param[in] size : długość tablicy @p res
+ * @param[out] res : tablica na reszty współczynników
+ */
+static void NttLoad(const ModRing *ring, size_t count,
+                    const uint64_t coeffs[], size_t size, uint64_t res[]) {
+    for (size_t i = 0; i < count; i++)
+        res[i] = ModReduce(ring, coeffs[i]);
+    memset(res + count, 0, (size - count) * sizeof(uint64_t));
+}
+
+/**
+ * Liczy iloczyn wielomianów modulo liczba pierwsza transformaty.
+ * @param[in] prime : liczba pierwsza
+ * @param[in] p_count : długość tablicy @p p
+ * @param[in] p : współczynniki wielomianu @f$p@f$
+ * @param[in] q_count : długość tablicy @p q
+ * @param[in] q : współczynniki wielomianu @f$q@f$
+ * @param[in] size : długość transformaty, potęga dwójki nie mniejsza niż
+ *                   długość iloczynu
+ * @param[out] res : tablica długości @p size na współczynniki iloczynu
+ *                   modulo @p prime
+ * @param[in] scratch : tablica pomocnicza długości 2 @p size
+ */
+static void NttConvolve(const NttPrime *prime, size_t p_count,
+                        const uint64_t p[], size_t q_count, const uint64_t q[],
+                        size_t size, uint64_t res[], uint64_t scratch[]) {
+    ModRing ring = NewModRing(prime->mod);
+    uint64_t *other = scratch, *roots = scratch + size;
+
+    uint64_t root = ModPow(&ring, prime->generator, (prime->mod - 1) / size);
+    RootPowers(&ring, root, size, roots);
+
+    NttLoad(&ring, p_count, p, size, res);
+    NttLoad(&ring, q_count, q, size, other);
+    NttForward(&ring, size, res, roots);
+    NttForward(&ring, size, other, roots);
+
+    /* Mnożąc iloczyny punktowe przez odwrotność długości transformaty
+     * od razu, unikamy osobnego przebiegu po wyniku. */
+    uint64_t size_inv = ModFactor(&ring, PrimeInverse(&ring, size));
+    for (size_t i = 0; i < size; i++)
+        res[i] = ModMulBy(&ring, size_inv, ModMul(&ring, res[i], other[i]));
+
+    // Odwrotność pierwiastka to jego potęga o wykładniku size - 1.
+    RootPowers(&ring, ModPow(&ring, root, size - 1), size, roots);
+    NttInverse(&ring, size, res, roots);
+}
+
+/**
+ * Liczy iloczyn wielomianów modulo wszystkie liczby pierwsze transformaty.
+ * @param[in] p_count : długość tablicy @p p
+ * @param[in] p : współczynniki wielomianu @f$p@f$
+ * @param[in] q_count : długość tablicy @p q
+ * @param[in] q : współczynniki wielomianu @f$q@f$
+ * @param[out] size : długość transformaty
+ * @return tablica długości NTT_PRIMES_COUNT @p size - kolejne bloki
+ *         długości @p size to współczynniki iloczynu modulo kolejne
+ *         liczby pierwsze
+ */
+static uint64_t *NttResidues(size_t p_count, const uint64_t p[],
+                             size_t q_count, const uint64_t q[],
+                             size_t *size) {
+    size_t count = p_count + q_count - 1;
+    *size = 1;
+    while (*size < count)
+        *size *= 2;
+
+    uint64_t *residues = SafeRealloc(NULL, (NTT_PRIMES_COUNT + 2) * *size
+                                           * sizeof(uint64_t));
+    uint64_t *scratch = residues + NTT_PRIMES_COUNT * *size;
+    for (size_t k = 0; k < NTT_PRIMES_COUNT; k++)
+        NttConvolve(&NTT_PRIMES[k], p_count, p, q_count, q, *size,
+                    residues + k * *size, scratch);
+    return residues;
+}
+
+/**
+ * To jest struktura przechowująca stałe algorytmu Garnera, który odtwarza
+ * liczbę @f$x < m_1 m_2 m_3@f$ z jej reszt modulo liczby pierwsze
+ * transformaty jako @f$x = v_1 + v_2 m_1 + v_3 m_1 m_2@f$, gdzie
+ * @f$0 \le v_i < m_i@f$. Stałe przygotowane są funkcją ModFactor.
+ */
+typedef struct Garner {
+    ModRing ring2; ///< stałe arytmetyki modulo @f$m_2@f$
+    ModRing ring3; ///< stałe arytmetyki modulo @f$m_3@f$
+    uint64_t m1_inv2; ///< czynnik @f$m_1^{-1} \bmod m_2@f$
+    uint64_t m1_3; ///< czynnik @f$m_1 \bmod m_3@f$
+    uint64_t m12_inv3; ///< czynnik @f$(m_1 m_2)^{-1} \bmod m_3@f$
+} Garner;
+
+/**
+ * Wyznacza stałe algorytmu Garnera.
+ * @return stałe algorytmu
+ */
+static Garner NewGarner(void) {
+    Garner g;
+    uint64_t m1 = NTT_PRIMES[0].mod, m2 = NTT_PRIMES[1].mod;
+    g.ring2 = NewModRing(m2);
+    g.ring3 = NewModRing(NTT_PRIMES[2].mod);
+    uint64_t m1_3 = ModReduce(&g.ring3, m1);
+    g.m1_inv2 = ModFactor(&g.ring2, PrimeInverse(&g.ring2,
+                                                 ModReduce(&g.ring2, m1)));
+    g.m1_3 = ModFactor(&g.ring3, m1_3);
+    g.m12_inv3 = ModFactor(&g.ring3, PrimeInverse(&g.ring3, ModMul(
+            &g.ring3, m1_3, ModReduce(&g.ring3, m2))));
+    return g;
+}
+
+/**
+ * Wyznacza cyfry @f$v_2, v_3@f$ liczby o resztach @p r1, @p r2, @p r3
+ * (cyfra @f$v_1@f$ to @p r1).
+ * @param[in] g : stałe algorytmu Garnera
+ * @param[in] r1 : reszta modulo @f$m_1@f$
+ * @param[in] r2 : reszta modulo @f$m_2@f$
+ * @param[in] r3 : reszta modulo @f$m_3@f$
+ * @param[out] v2 : cyfra @f$v_2@f$
+ * @param[out] v3 : cyfra @f$v_3@f$
+ */
+static inline void GarnerDigits(const Garner *g, uint64_t r1, uint64_t r2,
+                                uint64_t r3, uint64_t *v2, uint64_t *v3) {
+    *v2 = ModMulBy(&g->ring2, g->m1_inv2,
+                   ModSub(&g->ring2, r2, ModReduce(&g->ring2, r1)));
+    /* Redukcja Montgomery'ego w ModMulBy poprawnie mnoży przez czynnik
+     * dowolną liczbę 64-bitową, więc v2 nie trzeba redukować modulo m3. */
+    uint64_t v12 = ModAdd(&g->ring3, ModMulBy(&g->ring3, g->m1_3, *v2),
+                          ModReduce(&g->ring3, r1));
+    *v3 = ModMulBy(&g->ring3, g->m12_inv3, ModSub(&g->ring3, r3, v12));
+}
+
+void DenseMulNtt(size_t p_count, const uint64_t p[], size_t q_count,
+                 const uint64_t q[], uint64_t res[]) {
+    size_t count = p_count + q_count - 1, size;
+    uint64_t *residues = NttResidues(p_count, p, q_count, q, &size);
+
+    /* Współczynniki iloczynu są nieujemne i mniejsze niż m1 m2 m3, więc
+     * algorytm Garnera odtwarza ich dokładne wartości, a wynik to ich
+     * reszty modulo 2^64. */
+    Garner g = NewGarner();
+    uint64_t m1 = NTT_PRIMES[0].mod, m2 = NTT_PRIMES[1].mod;
+    const uint64_t *r1 = residues, *r2 = residues + size;
+    const uint64_t *r3 = residues + 2 * size;
+    for (size_t i = 0; i < count; i++) {
+        uint64_t v2, v3;
+        GarnerDigits(&g, r1[i], r2[i], r3[i], &v2, &v3);
+        res[i] = r1[i] + v2 * m1 + v3 * (m1 * m2);
+    }
+    free(residues);
+}
+
+/**
+ * Szacuje koszt mnożenia algorytmem Karatsuby jako liczbę mnożeń
+ * wprost wykonywanych na najniższym poziomie rekurencji.
+ * @param[in] p_count : długość dłuższego czynnika
+ * @param[in] q_count : długość krótszego czynnika
+ * @return szacowany koszt
+ */
+static size_t KaratsubaCost(size_t p_count, size_t q_count) {
+    size_t chunks = (p_count + q_count - 1) / q_count, cost = chunks;
+    while (q_count >= DENSE_KARATSUBA_MIN) {
+        q_count -= q_count / 2;
+        cost *= 3;
+    }
+    return cost * q_count * q_count;
+}
+
+/**
+ * Szacuje koszt mnożenia transformatą NTT w jednostkach mnożenia wprost.
+ * @param[in] p_count : długość pierwszego czynnika
+ * @param[in] q_count : długość drugiego czynnika
+ * @return szacowany koszt
+ */
+static size_t NttCost(size_t p_count, size_t q_count) {
+    size_t size = 1, levels = 0;
+    while (size < p_count + q_count - 1) {
+        size *= 2;
+        levels++;
+    }
+    return DENSE_NTT_WEIGHT * size * levels;
+}
+
+size_t DenseMulCost(size_t p_count, size_t q_count) {
+    if (p_count < q_count)
+        return DenseMulCost(q_count, p_count);
+    if (q_count < DENSE_KARATSUBA_MIN)
+        return p_count * q_count;
+
+    size_t karatsuba = KaratsubaCost(p_count, q_count);
+    size_t ntt = NttCost(p_count, q_count);
+    return karatsuba < ntt ? karatsuba : ntt;
+}
+
+void DenseMul(size_t p_count, const uint64_t p[], size_t q_count,
+              const uint64_t q[], uint64_t res[]) {
+    size_t longer = p_count > q_count ? p_count : q_count;
+    size_t shorter = p_count < q_count ? p_count : q_count;
+    if (shorter < DENSE_KARATSUBA_MIN)
+        DenseMulSchoolbook(p_count, p, q_count, q, res);
+    else if (KaratsubaCost(longer, shorter) <= NttCost(longer, shorter))
+        DenseMulKaratsuba(p_count, p, q_count, q, res);
+    else
+        DenseMulNtt(p_count, p, q_count, q, res);
+}
+
+void DenseMulNttMod(size_t p_count, const uint64_t p[], size_t q_count,
+                    const uint64_t q[], const ModRing *ring, uint64_t res[]) {
+    size_t count = p_count + q_count - 1, size;
+    uint64_t *residues = NttResidues(p_count, p, q_count, q, &size);
+
+    /* Algorytm Garnera odtwarza dokładne wartości współczynników iloczynu
+     * x = v1 + v2 m1 + v3 m1 m2, a ich reszty modulo m wyznaczamy
+     * z reszt cyfr i stałych m1, m1 m2. */
+    Garner g = NewGarner();
+    uint64_t m1 = ModReduce(ring, NTT_PRIMES[0].mod);
+    uint64_t m12 = ModMul(ring, m1, ModReduce(ring, NTT_PRIMES[1].mod));
+    const uint64_t *r1 = residues, *r2 = residues + size;
+    const uint64_t *r3 = residues + 2 * size;
+    for (size_t i = 0; i < count; i++) {
+        uint64_t v2, v3;
+        GarnerDigits(&g, r1[i], r2[i], r3[i], &v2, &v3);
+        res[i] = ModAdd(ring, ModReduce(ring, r1[i]),
+                        ModAdd(ring, ModMul(ring, ModReduce(ring, v2), m1),
+                               ModMul(ring, ModReduce(ring, v3), m12)));
+    }
+    free(residues);
+}
+
+void DenseMulSchoolbookMod(size_t p_count, const uint64_t p[],
+                           size_t q_count, const uint64_t q[],
+                           const ModRing *ring, uint64_t res[]) {
+    memset(res, 0, (p_count + q_count - 1) * sizeof(uint64_t));
+    for (size_t i = 0; i < p_count; i++) {
+        uint64_t factor = ModFactor(ring, p[i]);
+        for (size_t j = 0; j < q_count; j++)
+            res[i + j] = ModAdd(ring, res[i + j],
+                                ModMulBy(ring, factor, q[j]));
+    }
+}
+
+size_t DenseMulModCost(size_t p_count, size_t q_count) {
+    size_t schoolbook = DENSE_MOD_WEIGHT * p_count * q_count;
+    size_t ntt = NttCost(p_count, q_count);
+    return schoolbook < ntt ? schoolbook : ntt;
+}
+
+void DenseMulMod(size_t p_count, const uint64_t p[], size_t q_count,
+                 const uint64_t q[], const ModRing *ring, uint64_t res[]) {
+    if (DENSE_MOD_WEIGHT * p_count * q_count <= NttCost(p_count, q_count))
+        DenseMulSchoolbookMod(p_count, p, q_count, q, ring, res);
+    else
+        DenseMulNttMod(p_count, p, q_count, q, ring, res);
+}
@@ -0,0 +1,135 @@
+/** @file
+  Biblioteka udostępniająca mnożenie gęstych wielomianów jednej zmiennej
+  zapisanych jako tablice współczynników.
+
+  Współczynnik o indeksie @f$i@f$ tablicy to współczynnik przy
+  @f$x^i@f$. Iloczyny liczone są modulo @f$2^{64}@f$, tak jak działania
+  na typie poly_coeff_t w pozostałej części biblioteki. Małe iloczyny
+  liczone są wprost, średnie algorytmem Karatsuby, a duże szybką
+  transformatą teoretyczno-liczbową (NTT) modulo trzy liczby pierwsze,
+  z której wynik odtwarzany jest chińskim twierdzeniem o resztach.
+  Odmiany z przyrostkiem Mod liczą iloczyny modulo liczba mniejsza niż
+  @f$2^{62}@f$ (patrz poly_mod.h).
+
+  @author Szymon Łukasik <sl428760@mimuw.students.edu.pl>
+  @date 2021
+*/
+
+#ifndef __POLY_DENSE_H__
+#define __POLY_DENSE_H__
+
+#include <stdint.h>
+#include <stdlib.h>
+#include "poly_mod.h"
+
+/**
+ * Mnoży gęste wielomiany algorytmem o najmniejszym szacowanym koszcie.
+ * @param[in] p_count : długość tablicy @p p, dodatnia
+ * @param[in] p : współczynniki wielomianu @f$p@f$
+ * @param[in] q_count : długość tablicy @p q, dodatnia
+ * @param[in] q : współczynniki wielomianu @f$q@f$
+ * @param[out] res : tablica długości @p p_count + @p q_count - 1
+ *                   na współczynniki @f$p * q@f$
+ */
+void DenseMul(size_t p_count, const uint64_t p[], size_t q_count,
+              const uint64_t q[], uint64_t res[]);
+
+/**
+ * Szacuje koszt mnożenia gęstych wielomianów funkcją DenseMul
+ * w jednostkach jednego mnożenia wprost (wraz z dodawaniem) pary
+ * współczynników. Zakłada, że tablica współczynników iloczynu mieści
+ * się w pamięci.
+ * @param[in] p_count : długość pierwszego czynnika, dodatnia
+ * @param[in] q_count : długość drugiego czynnika, dodatnia
+ * @return szacowany koszt
+ */
+size_t DenseMulCost(size_t p_count, size_t q_count);
+
+/**
+ * Mnoży gęste wielomiany wprost, w czasie @f$O(nm)@f$.
+ * @param[in] p_count : długość tablicy @p p, dodatnia
+ * @param[in] p : współczynniki wielomianu @f$p@f$
+ * @param[in] q_count : długość tablicy @p q, dodatnia
+ * @param[in] q : współczynniki wielomianu @f$q@f$
+ * @param[out] res : tablica długości @p p_count + @p q_count - 1
+ */
+void DenseMulSchoolbook(size_t p_count, const uint64_t p[], size_t q_count,
+                        const uint64_t q[], uint64_t res[]);
+
+/**
+ * Mnoży gęste wielomiany algorytmem Karatsuby. Dłuższy czynnik dzielony
+ * jest na fragmenty długości krótszego.
+ * @param[in] p_count : długość tablicy @p p, dodatnia
+ * @param[in] p : współczynniki wielomianu @f$p@f$
+ * @param[in] q_count : długość tablicy @p q, dodatnia
+ * @param[in] q : współczynniki wielomianu @f$q@f$
+ * @param[out] res : tablica długości @p p_count + @p q_count - 1
+ */
+void DenseMulKaratsuba(size_t p_count, const uint64_t p[], size_t q_count,
+                       const uint64_t q[], uint64_t res[]);
+
+/**
+ * Mnoży gęste wielomiany transformatą teoretyczno-liczbową modulo trzy
+ * liczby pierwsze mniejsze niż @f$2^{62}@f$. Wynik jest dokładny, gdy
+ * krótszy czynnik ma mniej niż @f$2^{55}@f$ współczynników.
+ * @param[in] p_count : długość tablicy @p p, dodatnia
+ * @param[in] p : współczynniki wielomianu @f$p@f$
+ * @param[in] q_count : długość tablicy @p q, dodatnia
+ * @param[in] q : współczynniki wielomianu @f$q@f$
+ * @param[out] res : tablica długości @p p_count + @p q_count - 1
+ */
+void DenseMulNtt(size_t p_count, const uint64_t p[], size_t q_count,
+                 const uint64_t q[], uint64_t res[]);
+
+/**
+ * Mnoży gęste wielomiany modulo @f$m@f$ algorytmem o najmniejszym
+ * szacowanym koszcie - wprost lub transformatą NTT.
+ * @param[in] p_count : długość tablicy @p p, dodatnia
+ * @param[in] p : współczynniki wielomianu @f$p@f$, mniejsze niż @f$m@f$
+ * @param[in] q_count : długość tablicy @p q, dodatnia
+ * @param[in] q : współczynniki wielomianu @f$q@f$, mniejsze niż @f$m@f$
+ * @param[in] ring : stałe arytmetyki modulo @f$m@f$
+ * @param[out] res : tablica długości @p p_count + @p q_count - 1
+ *                   na współczynniki @f$p * q \bmod m@f$
+ */
+void DenseMulMod(size_t p_count, const uint64_t p[], size_t q_count,
+                 const uint64_t q[], const ModRing *ring, uint64_t res[]);
+
+/**
+ * Szacuje koszt mnożenia gęstych wielomianów funkcją DenseMulMod
+ * w tych samych jednostkach co DenseMulCost.
+ * @param[in] p_count : długość pierwszego czynnika, dodatnia
+ * @param[in] q_count : długość drugiego czynnika, dodatnia
+ * @return szacowany koszt
+ */
+size_t DenseMulModCost(size_t p_count, size_t q_count);
+
+/**
+ * Mnoży gęste wielomiany wprost modulo @f$m@f$.
+ * @param[in] p_count : długość tablicy @p p, dodatnia
+ * @param[in] p : współczynniki wielomianu @f$p@f$, mniejsze niż @f$m@f$
+ * @param[in] q_count : długość tablicy @p q, dodatnia
+ * @param[in] q : współczynniki wielomianu @f$q@f$, mniejsze niż @f$m@f$
+ * @param[in] ring : stałe arytmetyki modulo @f$m@f$
+ * @param[out] res : tablica długości @p p_count + @p q_count - 1
+ */
+void DenseMulSchoolbookMod(size_t p_count, const uint64_t p[],
+                           size_t q_count, const uint64_t q[],
+                           const ModRing *ring, uint64_t res[]);
+
+/**
+ * Mnoży gęste wielomiany modulo @f$m@f$ transformatą NTT. Transformata
+ * wyznacza dokładne współczynniki iloczynu, które dopiero potem są
+ * redukowane modulo @f$m@f$, dlatego moduł nie musi mieć żadnej
+ * szczególnej postaci.
+ * @param[in] p_count : długość tablicy @p p, dodatnia
+ * @param[in] p : współczynniki wielomianu @f$p@f$, mniejsze niż @f$m@f$
+ * @param[in] q_count : długość tablicy @p q, dodatnia
+ * @param[in] q : współczynniki wielomianu @f$q@f$, mniejsze niż @f$m@f$
+ * @param[in] ring : stałe arytmetyki modulo @f$m@f$
+ * @param[out] res : tablica długości @p p_count + @p q_count - 1
+ */
+void DenseMulNttMod(size_t p_count, const uint64_t p[], size_t q_count,
+                    const uint64_t q[], const ModRing *ring, uint64_t res[]);
+
+#endif // __POLY_DENSE_H__
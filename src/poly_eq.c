@@ -0,0 +1,425 @@
+/** @file
+  Implementacja biblioteki udostępniającej probabilistyczne porównywanie
+  wielomianów.
+
+  @author Szymon Łukasik <sl428760@mimuw.students.edu.pl>
+  @date 2021
+*/
+
+#include <assert.h>
+#include <time.h>
+
+#include "big_int.h"
+#include "poly_eq.h"
+#include "poly_mod.h"
+#include "safe_alloc.h"
+
+/** Liczba bitów dolnego ograniczenia losowanych liczb pierwszych. */
+#define PRIME_BITS 60
+
+/** Ograniczenie górne stosunku @f$2^{60}@f$ do liczby liczb pierwszych
+ * z przedziału @f$[2^{60}, 2^{61})@f$ (liczb tych jest około
+ * @f$2^{60} / 42@f$). Liczba mająca @f$b@f$ bitów ma co najwyżej
+ * @f$\lceil b / 60 \rceil@f$ dzielników pierwszych z tego przedziału,
+ * więc wylosowana liczba pierwsza dzieli ją z prawdopodobieństwem
+ * co najwyżej @f$\lceil b / 60 \rceil \cdot 43 / 2^{60}@f$. */
+#define PRIME_DENSITY 43
+
+/** Początkowy rozmiar tablicy haszującej wartości poddrzew. */
+#define MEMO_INITIAL_SIZE 64
+
+/** To jest struktura przechowująca wartość poddrzewa. */
+typedef struct MemoEntry {
+    const Mono *arr; ///< tablica jednomianów poddrzewa lub NULL
+    size_t level; ///< numer zmiennej głównej poddrzewa
+    uint64_t value; ///< wartość poddrzewa
+    uint64_t deg; ///< stopień poddrzewa
+} MemoEntry;
+
+/** To jest struktura przechowująca stan jednego porównania. */
+typedef struct EqRound {
+    ModRing ring; ///< arytmetyka modulo wylosowana liczba pierwsza
+    uint64_t *points; ///< wartości zmiennych kolejnych poziomów
+    size_t points_count; ///< liczba wylosowanych wartości zmiennych
+    size_t points_capacity; ///< pojemność tablicy @p points
+    MemoEntry *memo; ///< tablica haszująca wartości poddrzew lub NULL
+    size_t memo_count; ///< liczba wpisów tablicy haszującej
+    size_t memo_size; ///< rozmiar tablicy haszującej, potęga dwójki lub 0
+    uint64_t coeff_mask; ///< alternatywa bitowa modułów małych współczynników
+    size_t big_bits; ///< największa liczba bitów dużego współczynnika
+} EqRound;
+
+/** Stan generatora liczb losowych. */
+static uint64_t eq_state;
+
+/** Czy ziarno generatora zostało już ustalone? */
+static bool eq_seeded = false;
+
+/** Wylosowane dotąd liczby pierwsze. Losowanie liczby pierwszej kosztuje
+ * kilkaset testów Millera-Rabina, dlatego liczby losowane są raz, a każde
+ * porównanie wielomianów korzysta z kolejnych liczb z tej tablicy,
+ * losując jedynie nowe punkty. */
+static uint64_t *eq_primes = NULL;
+
+/** Liczba wylosowanych liczb pierwszych. */
+static size_t eq_primes_count = 0;
+
+void PolyEqSeed(uint64_t seed) {
+    eq_state = seed;
+    eq_seeded = true;
+    free(eq_primes);
+    eq_primes = NULL;
+    eq_primes_count = 0;
+}
+
+/**
+ * Zwraca kolejną liczbę losową (generator SplitMix64).
+ * @return liczba losowa
+ */
+static uint64_t EqRandom(void) {
+    if (!eq_seeded)
+        PolyEqSeed((uint64_t) time(NULL) ^ ((uint64_t) clock() << 32)
+                   ^ (uint64_t) (uintptr_t) &eq_state);
+    uint64_t x = (eq_state += UINT64_C(0x9E3779B97F4A7C15));
+    x = (x ^ (x >> 30)) * UINT64_C(0xBF58476D1CE4E5B9);
+    x = (x ^ (x >> 27)) * UINT64_C(0x94D049BB133111EB);
+    return x ^ (x >> 31);
+}
+
+/**
+ * Mnoży liczby modulo @p mod.
+ * @param[in] a : czynnik mniejszy niż @p mod
+ * @param[in] b : czynnik mniejszy niż @p mod
+ * @param[in] mod : moduł
+ * @return @f$a b \bmod mod@f$
+ */
+static inline uint64_t MulMod(uint64_t a, uint64_t b, uint64_t mod) {
+    return (uint64_t) ((unsigned __int128) a * b % mod);
+}
+
+/**
+ * Sprawdza, czy nieparzysta liczba większa niż 37 jest pierwsza. Test
+ * Millera-Rabina z dwunastoma pierwszymi liczbami pierwszymi jako
+ * podstawami nie myli się dla liczb mniejszych niż @f$2^{64}@f$.
+ * @param[in] n : liczba
+ * @return Czy liczba jest pierwsza?
+ */
+static bool IsPrime(uint64_t n) {
+    static const uint64_t bases[] = {2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 31,
+                                     37};
+    uint64_t d = n - 1;
+    unsigned s = 0;
+    while (d % 2 == 0) {
+        d /= 2;
+        s++;
+    }
+
+    for (size_t i = 0; i < sizeof(bases) / sizeof(bases[0]); i++) {
+        uint64_t x = 1, base = bases[i];
+        for (uint64_t e = d; e > 0; e /= 2) {
+            if (e & 1)
+                x = MulMod(x, base, n);
+            base = MulMod(base, base, n);
+        }
+        if (x == 1 || x == n - 1)
+            continue;
+
+        bool composite = true;
+        for (unsigned r = 1; r < s && composite; r++) {
+            x = MulMod(x, x, n);
+            composite = x != n - 1;
+        }
+        if (composite)
+            return false;
+    }
+    return true;
+}
+
+/**
+ * Losuje liczbę pierwszą z przedziału @f$[2^{60}, 2^{61})@f$.
+ * @return liczba pierwsza
+ */
+static uint64_t RandomPrime(void) {
+    while (true) {
+        uint64_t n = (EqRandom() >> (64 - PRIME_BITS))
+                     | (UINT64_C(1) << PRIME_BITS) | 1;
+        if (IsPrime(n))
+            return n;
+    }
+}
+
+/**
+ * Zwraca liczbę pierwszą o danym numerze, losując brakujące liczby.
+ * Różne numery dają różne liczby.
+ * @param[in] index : numer liczby
+ * @return liczba pierwsza z przedziału @f$[2^{60}, 2^{61})@f$
+ */
+static uint64_t EqPrime(size_t index) {
+    while (eq_primes_count <= index) {
+        uint64_t prime = RandomPrime();
+        bool fresh = true;
+        for (size_t i = 0; i < eq_primes_count; i++)
+            fresh &= eq_primes[i] != prime;
+        if (!fresh)
+            continue;
+        // Pojemność tablicy jest zawsze równa liczbie jej elementów.
+        eq_primes = SafeRealloc(eq_primes, (eq_primes_count + 1)
+                                           * sizeof(uint64_t));
+        eq_primes[eq_primes_count++] = prime;
+    }
+    return eq_primes[index];
+}
+
+/**
+ * Zwraca wartość zmiennej danego poziomu, losując ją przy pierwszym
+ * użyciu.
+ * @param[in, out] round : porównanie
+ * @param[in] level : numer zmiennej
+ * @return wartość zmiennej
+ */
+static uint64_t RoundPoint(EqRound *round, size_t level) {
+    while (round->points_count <= level) {
+        if (round->points_count == round->points_capacity) {
+            round->points_capacity = 2 * round->points_capacity + 1;
+            round->points = SafeRealloc(round->points, round->points_capacity
+                                                       * sizeof(uint64_t));
+        }
+        round->points[round->points_count++] = EqRandom() % round->ring.mod;
+    }
+    return round->points[level];
+}
+
+/**
+ * Zwraca miejsce tablicy haszującej, od którego zaczyna się szukanie
+ * poddrzewa.
+ * @param[in] round : porównanie
+ * @param[in] arr : tablica jednomianów poddrzewa
+ * @param[in] level : numer zmiennej głównej poddrzewa
+ * @return indeks miejsca
+ */
+static inline size_t MemoSlot(const EqRound *round, const Mono *arr,
+                              size_t level) {
+    uint64_t key = ((uint64_t) (uintptr_t) arr ^ level)
+                   * UINT64_C(0x9E3779B97F4A7C15);
+    return (size_t) (key >> 32) & (round->memo_size - 1);
+}
+
+/**
+ * Szuka wartości poddrzewa w tablicy haszującej.
+ * @param[in] round : porównanie
+ * @param[in] arr : tablica jednomianów poddrzewa
+ * @param[in] level : numer zmiennej głównej poddrzewa
+ * @return wskaźnik na wpis lub NULL, gdy poddrzewa nie ma w tablicy
+ */
+static const MemoEntry *MemoFind(const EqRound *round, const Mono *arr,
+                                 size_t level) {
+    if (round->memo_size == 0)
+        return NULL;
+    for (size_t slot = MemoSlot(round, arr, level);
+         round->memo[slot].arr != NULL;
+         slot = (slot + 1) & (round->memo_size - 1))
+        if (round->memo[slot].arr == arr && round->memo[slot].level == level)
+            return &round->memo[slot];
+    return NULL;
+}
+
+/**
+ * Dodaje wartość poddrzewa do tablicy haszującej, alokując ją przy
+ * pierwszym użyciu.
+ * @param[in, out] round : porównanie
+ * @param[in] entry : wpis
+ */
+static void MemoAdd(EqRound *round, MemoEntry entry) {
+    // Utrzymujemy zapełnienie tablicy poniżej połowy.
+    if (2 * (round->memo_count + 1) > round->memo_size) {
+        MemoEntry *old = round->memo;
+        size_t old_size = round->memo_size;
+        round->memo_size = old_size == 0 ? MEMO_INITIAL_SIZE : 2 * old_size;
+        round->memo = SafeCalloc(round->memo_size, sizeof(MemoEntry));
+        round->memo_count = 0;
+        for (size_t i = 0; i < old_size; i++)
+            if (old[i].arr != NULL)
+                MemoAdd(round, old[i]);
+        free(old);
+    }
+
+    size_t slot = MemoSlot(round, entry.arr, entry.level);
+    while (round->memo[slot].arr != NULL)
+        slot = (slot + 1) & (round->memo_size - 1);
+    round->memo[slot] = entry;
+    round->memo_count++;
+}
+
+/**
+ * Zwraca współczynnik modulo liczba pierwsza porównania i odnotowuje jego
+ * rozmiar.
+ * @param[in, out] round : porównanie
+ * @param[in] p : współczynnik
+ * @return reszta przystająca do współczynnika
+ */
+static inline uint64_t RoundCoeff(EqRound *round, const Poly *p) {
+    const ModRing *ring = &round->ring;
+    if (PolyIsBig(p)) {
+        size_t bits = BigIntBits(p->big);
+        if (bits > round->big_bits)
+            round->big_bits = bits;
+        return BigIntModWord(p->big, ring->mod);
+    }
+
+    /* Najstarszy bit alternatywy modułów to najstarszy bit największego
+     * z nich, więc rozmiar współczynników liczymy raz, na końcu. */
+    uint64_t abs = p->coeff < 0 ? 0 - (uint64_t) p->coeff
+                                : (uint64_t) p->coeff;
+    round->coeff_mask |= abs;
+    if (abs < ring->mod)
+        return p->coeff < 0 ? ring->mod - abs : abs;
+    return ModFromSigned(ring, p->coeff);
+}
+
+/**
+ * Zwraca największą liczbę bitów modułu współczynnika wyliczonego
+ * w porównaniu.
+ * @param[in] round : porównanie
+ * @return liczba bitów
+ */
+static size_t RoundCoeffBits(const EqRound *round) {
+    size_t bits = round->coeff_mask == 0
+                  ? 0 : 64 - (size_t) __builtin_clzll(round->coeff_mask);
+    return bits > round->big_bits ? bits : round->big_bits;
+}
+
+/**
+ * Wylicza wartość poddrzewa schematem Hornera modulo liczba pierwsza
+ * porównania. Współczynniki będące liczbami wylicza bez wywołania
+ * rekurencyjnego. Zapamiętuje tylko wartości poddrzew o współdzielonych
+ * tablicach jednomianów - do pozostałych porównanie nie wraca.
+ * @param[in, out] round : porównanie
+ * @param[in] p : poddrzewo, które nie jest współczynnikiem
+ * @param[in] level : numer zmiennej głównej poddrzewa
+ * @param[out] deg : stopień poddrzewa, ograniczony do @f$2^{63}@f$
+ * @return wartość poddrzewa
+ */
+static uint64_t RoundEval(EqRound *round, const Poly *p, size_t level,
+                          uint64_t *deg) {
+    const ModRing *ring = &round->ring;
+    bool shared = PolyIsShared(p);
+    if (shared) {
+        const MemoEntry *entry = MemoFind(round, p->arr, level);
+        if (entry != NULL) {
+            *deg = entry->deg;
+            return entry->value;
+        }
+    }
+
+    uint64_t x = RoundPoint(round, level), acc = 0, max_deg = 0;
+    /* Mnożenie przez potęgę punktu o tym samym wykładniku powtarza się,
+     * więc przygotowujemy ją raz dla każdej kolejnej różnej odległości
+     * między wykładnikami. */
+    poly_exp_t power_gap = 1;
+    uint64_t power = ModFactor(ring, x);
+    for (size_t i = p->size; i-- > 0;) {
+        if (i + 1 < p->size) {
+            poly_exp_t gap = p->arr[i + 1].exp - p->arr[i].exp;
+            if (gap != power_gap) {
+                power_gap = gap;
+                power = ModFactor(ring, ModPow(ring, x, (uint64_t) gap));
+            }
+            acc = ModMulBy(ring, power, acc);
+        }
+
+        const Poly *child = &p->arr[i].p;
+        uint64_t child_deg = 0;
+        acc = ModAdd(ring, acc, PolyIsCoeff(child)
+                                ? RoundCoeff(round, child)
+                                : RoundEval(round, child, level + 1,
+                                            &child_deg));
+        if (child_deg + (uint64_t) p->arr[i].exp > max_deg)
+            max_deg = child_deg + (uint64_t) p->arr[i].exp;
+    }
+    if (p->arr[0].exp > 0)
+        acc = ModMul(ring, acc, ModPow(ring, x, (uint64_t) p->arr[0].exp));
+
+    // Stopień wielomianu głębokiego na wiele poziomów nie mieści się w int.
+    *deg = max_deg < (UINT64_C(1) << 63) ? max_deg : UINT64_C(1) << 63;
+    if (shared)
+        MemoAdd(round, (MemoEntry) {.arr = p->arr, .level = level,
+                                    .value = acc, .deg = *deg});
+    return acc;
+}
+
+/**
+ * Wylicza wartość wielomianu modulo liczba pierwsza porównania.
+ * @param[in, out] round : porównanie
+ * @param[in] p : wielomian
+ * @param[out] deg : stopień wielomianu, ograniczony do @f$2^{63}@f$
+ * @return wartość wielomianu
+ */
+static uint64_t RoundEvalPoly(EqRound *round, const Poly *p, uint64_t *deg) {
+    if (PolyIsCoeff(p)) {
+        *deg = 0;
+        return RoundCoeff(round, p);
+    }
+    return RoundEval(round, p, 0, deg);
+}
+
+/**
+ * Porównuje wartości wielomianów w nowym losowym punkcie modulo liczba
+ * pierwsza o danym numerze.
+ * @param[in] p : wielomian @f$p@f$
+ * @param[in] q : wielomian @f$q@f$
+ * @param[in] index : numer liczby pierwszej (patrz EqPrime)
+ * @param[out] deg : większy ze stopni wielomianów
+ * @param[out] coeff_bits : największa liczba bitów modułu współczynnika
+ *                          obu wielomianów
+ * @return Czy wartości są równe?
+ */
+static bool RoundIsEq(const Poly *p, const Poly *q, size_t index,
+                      uint64_t *deg, size_t *coeff_bits) {
+    EqRound round = {.ring = NewModRing(EqPrime(index))};
+    uint64_t p_deg, q_deg;
+    bool res = RoundEvalPoly(&round, p, &p_deg)
+               == RoundEvalPoly(&round, q, &q_deg);
+    *deg = p_deg > q_deg ? p_deg : q_deg;
+    *coeff_bits = RoundCoeffBits(&round);
+    free(round.points);
+    free(round.memo);
+    return res;
+}
+
+bool PolyIsEqRandom(const Poly *p, const Poly *q, unsigned error_bits) {
+    assert(error_bits > 0);
+    if (!PolyIsCoeff(p) && !PolyIsCoeff(q) && p->arr == q->arr)
+        return true;
+    // Wielomiany o różnych opisach są różne (patrz PolyIsEq).
+    if (PolyHash(p) != PolyHash(q) || PolyTerms(p) != PolyTerms(q)
+        || PolyDeg(p) != PolyDeg(q))
+        return false;
+
+    uint64_t deg;
+    size_t coeff_bits;
+    if (!RoundIsEq(p, q, 0, &deg, &coeff_bits))
+        return false;
+
+    /* Każde porównanie myli się, gdy liczba pierwsza dzieli niezerowy
+     * współczynnik różnicy wielomianów, mający co najwyżej coeff_bits + 1
+     * bitów, albo gdy punkt jest pierwiastkiem różnicy modulo ta liczba.
+     * Prawdopodobieństwo błędu wynosi więc co najwyżej bound / 2^PRIME_BITS
+     * i porównanie daje tyle bitów pewności, ile wynosi PRIME_BITS minus
+     * liczba bitów bound. Gdy bound przekracza 2^(PRIME_BITS - 1),
+     * porównania losowe nie dają pewności i porównujemy dokładnie. */
+    uint64_t divisors = (uint64_t) coeff_bits / PRIME_BITS + 1;
+    uint64_t limit = UINT64_C(1) << (PRIME_BITS - 1);
+    if (deg >= limit || divisors >= limit / PRIME_DENSITY)
+        return PolyIsEq(p, q);
+    uint64_t bound = deg + divisors * PRIME_DENSITY;
+    unsigned bound_bits = 64 - (unsigned) __builtin_clzll(bound - 1);
+    if (bound_bits >= PRIME_BITS)
+        return PolyIsEq(p, q);
+    unsigned bits = PRIME_BITS - bound_bits;
+
+    size_t index = 1;
+    for (unsigned done = bits; done < error_bits; done += bits)
+        if (!RoundIsEq(p, q, index++, &deg, &coeff_bits))
+            return false;
+    return true;
+}
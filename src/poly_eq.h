@@ -0,0 +1,62 @@
+/** @file
+  Biblioteka udostępniająca probabilistyczne porównywanie wielomianów.
+
+  Wielomiany porównywane są przez wyliczenie ich wartości w losowym
+  punkcie modulo losowa liczba pierwsza z przedziału
+  @f$[2^{60}, 2^{61})@f$. Różne wartości dowodzą, że wielomiany są różne.
+  Równe wartości różnych wielomianów stopnia co najwyżej @f$D@f$
+  o współczynnikach mających co najwyżej @f$b@f$ bitów zdarzają się
+  z prawdopodobieństwem co najwyżej
+  @f$(D + 43 \lceil (b + 1) / 60 \rceil) / 2^{60}@f$. Składnik @f$D@f$
+  pochodzi z lematu Schwartza-Zippela. Drugi składnik ogranicza szansę,
+  że liczba pierwsza dzieli niezerowy współczynnik różnicy wielomianów:
+  współczynnik ten ma co najwyżej @f$\lceil (b + 1) / 60 \rceil@f$
+  dzielników pierwszych z przedziału, a liczb pierwszych jest w nim
+  ponad @f$2^{60} / 43@f$. Porównanie powtarzane jest z nowymi
+  liczbami, aż prawdopodobieństwo błędu spadnie poniżej zadanego progu.
+  Gdy ograniczenie pojedynczego porównania przekracza @f$1/2@f$,
+  wielomiany porównywane są dokładnie. Wartości poddrzew współdzielących
+  tablicę jednomianów liczone są raz w każdym porównaniu.
+
+  Wyliczenie wartości wymaga mnożenia modulo w każdym jednomianie obu
+  wielomianów, a PolyIsEq porównuje tablice wykładników i współczynniki
+  bez arytmetyki. Porównanie losowe opłaca się więc tylko dla wielomianów
+  o współdzielonych poddrzewach, których rozwinięcie jest wielokrotnie
+  większe niż liczba różnych tablic jednomianów - dla pozostałych jest
+  kilka razy wolniejsze niż PolyIsEq.
+
+  @author Szymon Łukasik <sl428760@mimuw.students.edu.pl>
+  @date 2021
+*/
+
+#ifndef __POLY_EQ_H__
+#define __POLY_EQ_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "poly.h"
+
+/**
+ * Sprawdza probabilistycznie równość dwóch wielomianów. Wynik fałsz jest
+ * zawsze poprawny, a wynik prawda jest błędny z prawdopodobieństwem
+ * co najwyżej @f$2^{-error\_bits}@f$. Gdy stopień wielomianów lub rozmiar
+ * ich współczynników nie pozwala osiągnąć tego progu (patrz opis pliku),
+ * porównuje je funkcją PolyIsEq. Wielomiany o różnych skrótach, liczbach
+ * jednomianów lub stopniach (patrz PolyHash, PolyTerms i PolyDeg)
+ * odrzuca w czasie stałym.
+ * @param[in] p : wielomian @f$p@f$
+ * @param[in] q : wielomian @f$q@f$
+ * @param[in] error_bits : minus logarytm dwójkowy dopuszczalnego
+ *                         prawdopodobieństwa błędu, dodatni
+ * @return Czy wielomiany są (prawdopodobnie) równe?
+ */
+bool PolyIsEqRandom(const Poly *p, const Poly *q, unsigned error_bits);
+
+/**
+ * Ustawia ziarno generatora liczb losowych funkcji PolyIsEqRandom.
+ * Bez wywołania tej funkcji ziarno wybierane jest na podstawie czasu.
+ * @param[in] seed : ziarno
+ */
+void PolyEqSeed(uint64_t seed);
+
+#endif // __POLY_EQ_H__
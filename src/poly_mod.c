@@ -0,0 +1,49 @@
+/** @file
+  Implementacja biblioteki udostępniającej arytmetykę modulo liczba
+  mniejsza niż @f$2^{62}@f$.
+
+  @author Szymon Łukasik <sl428760@mimuw.students.edu.pl>
+  @date 2021
+*/
+
+#include <assert.h>
+
+#include "poly_mod.h"
+
+ModRing NewModRing(uint64_t mod) {
+    assert(mod >= 2 && mod < MOD_MAX);
+    unsigned shift = 64 - (unsigned) __builtin_clzll(mod);
+
+    // Odwrotność modulo 2^64 metodą Newtona - każdy krok podwaja liczbę
+    // poprawnych bitów, a mod jest swoją odwrotnością modulo 2^3.
+    uint64_t inv = 0;
+    if (mod % 2 == 1) {
+        inv = mod;
+        for (int i = 0; i < 5; i++)
+            inv *= 2 - mod * inv;
+    }
+
+    return (ModRing) {
+            .mod = mod,
+            .mu = (uint64_t) (((unsigned __int128) 1 << (2 * shift)) / mod),
+            .mu64 = UINT64_MAX / mod,
+            .inv = inv,
+            .r64 = (uint64_t) (((unsigned __int128) 1 << 64) % mod),
+            .shift = shift};
+}
+
+uint64_t ModFromSigned(const ModRing *ring, int64_t value) {
+    if (value >= 0)
+        return ModReduce(ring, (uint64_t) value);
+    return ModSub(ring, 0, ModReduce(ring, 0 - (uint64_t) value));
+}
+
+uint64_t ModPow(const ModRing *ring, uint64_t base, uint64_t exp) {
+    uint64_t res = ModCorrect(ring, 1);
+    for (; exp > 0; exp /= 2) {
+        if (exp & 1)
+            res = ModMul(ring, res, base);
+        base = ModMul(ring, base, base);
+    }
+    return res;
+}
@@ -0,0 +1,162 @@
+/** @file
+  Biblioteka udostępniająca arytmetykę modulo liczba mniejsza niż
+  @f$2^{62}@f$, z której korzysta modularny tryb współczynników
+  wielomianów (patrz PolySetModulus).
+
+  Liczby zapisywane są zwyczajnie, jako reszty z przedziału @f$[0, m)@f$,
+  dlatego porównywanie, wypisywanie i sprawdzanie, czy liczba jest zerem,
+  nie wymagają żadnej konwersji. Mnożenie korzysta z redukcji Barretta,
+  a wielokrotne mnożenie przez ten sam czynnik modulo liczba nieparzysta -
+  z redukcji Montgomery'ego, w której postać Montgomery'ego ma tylko ten
+  czynnik (patrz ModFactor). Żadna z redukcji nie zawiera skoków
+  warunkowych.
+
+  @author Szymon Łukasik <sl428760@mimuw.students.edu.pl>
+  @date 2021
+*/
+
+#ifndef __POLY_MOD_H__
+#define __POLY_MOD_H__
+
+#include <stdint.h>
+
+/** Ograniczenie górne (wyłączne) modułu. Dzięki niemu suma dwóch reszt
+ * mieści się w typie poly_coeff_t, a redukcje - w 64 bitach. */
+#define MOD_MAX (UINT64_C(1) << 62)
+
+/** To jest struktura przechowująca stałe arytmetyki modulo @f$m@f$. */
+typedef struct ModRing {
+    uint64_t mod; ///< moduł @f$m@f$, od 2 do MOD_MAX - 1
+    uint64_t mu; ///< stała Barretta @f$\lfloor 2^{2s} / m \rfloor@f$
+    uint64_t mu64; ///< stała @f$\lfloor (2^{64} - 1) / m \rfloor@f$
+    uint64_t inv; ///< @f$m^{-1} \bmod 2^{64}@f$ dla nieparzystego @f$m@f$, 0 wpp.
+    uint64_t r64; ///< @f$2^{64} \bmod m@f$
+    unsigned shift; ///< liczba bitów modułu @f$s@f$
+} ModRing;
+
+/**
+ * Wyznacza stałe arytmetyki modulo @p mod.
+ * @param[in] mod : moduł, od 2 do MOD_MAX - 1
+ * @return stałe arytmetyki
+ */
+ModRing NewModRing(uint64_t mod);
+
+/**
+ * Odejmuje moduł od liczby, jeśli nie jest ona od niego mniejsza.
+ * @param[in] ring : stałe arytmetyki
+ * @param[in] a : liczba mniejsza niż @f$2m@f$
+ * @return @f$a \bmod m@f$
+ */
+static inline uint64_t ModCorrect(const ModRing *ring, uint64_t a) {
+    return a - (ring->mod & (0 - (uint64_t) (a >= ring->mod)));
+}
+
+/**
+ * Wyznacza resztę z dzielenia dowolnej liczby 64-bitowej przez moduł.
+ * Iloraz przybliżany jest z dołu z błędem co najwyżej 2.
+ * @param[in] ring : stałe arytmetyki
+ * @param[in] a : liczba
+ * @return @f$a \bmod m@f$
+ */
+static inline uint64_t ModReduce(const ModRing *ring, uint64_t a) {
+    uint64_t q = (uint64_t) (((unsigned __int128) a * ring->mu64) >> 64);
+    return ModCorrect(ring, ModCorrect(ring, a - q * ring->mod));
+}
+
+/**
+ * Dodaje reszty modulo @f$m@f$.
+ * @param[in] ring : stałe arytmetyki
+ * @param[in] a : składnik mniejszy niż @f$m@f$
+ * @param[in] b : składnik mniejszy niż @f$m@f$
+ * @return @f$(a + b) \bmod m@f$
+ */
+static inline uint64_t ModAdd(const ModRing *ring, uint64_t a, uint64_t b) {
+    return ModCorrect(ring, a + b);
+}
+
+/**
+ * Odejmuje reszty modulo @f$m@f$.
+ * @param[in] ring : stałe arytmetyki
+ * @param[in] a : odjemna mniejsza niż @f$m@f$
+ * @param[in] b : odjemnik mniejszy niż @f$m@f$
+ * @return @f$(a - b) \bmod m@f$
+ */
+static inline uint64_t ModSub(const ModRing *ring, uint64_t a, uint64_t b) {
+    return a - b + (ring->mod & (0 - (uint64_t) (a < b)));
+}
+
+/**
+ * Mnoży reszty modulo @f$m@f$ (redukcja Barretta). Iloczyn
+ * @f$x < 2^{2s}@f$ dzielony jest przez @f$m@f$ w przybliżeniu jako
+ * @f$\lfloor \lfloor x / 2^{s-1} \rfloor \mu / 2^{s+1} \rfloor@f$,
+ * co zaniża iloraz co najwyżej o 2.
+ * @param[in] ring : stałe arytmetyki
+ * @param[in] a : czynnik mniejszy niż @f$m@f$
+ * @param[in] b : czynnik mniejszy niż @f$m@f$
+ * @return @f$a b \bmod m@f$
+ */
+static inline uint64_t ModMul(const ModRing *ring, uint64_t a, uint64_t b) {
+    unsigned __int128 x = (unsigned __int128) a * b;
+    // Przesunięcia 128-bitowe składamy z 64-bitowych, bo 2 <= s <= 62.
+    unsigned s = ring->shift;
+    uint64_t high = ((uint64_t) (x >> 64) << (65 - s))
+                    | ((uint64_t) x >> (s - 1));
+    unsigned __int128 y = (unsigned __int128) high * ring->mu;
+    uint64_t q = ((uint64_t) (y >> 64) << (63 - s))
+                 | ((uint64_t) y >> (s + 1));
+    uint64_t r = (uint64_t) x - q * ring->mod;
+    return ModCorrect(ring, ModCorrect(ring, r));
+}
+
+/**
+ * Przygotowuje czynnik do wielokrotnego mnożenia funkcją ModMulBy.
+ * Dla nieparzystego modułu wyznacza postać Montgomery'ego
+ * @f$a 2^{64} \bmod m@f$, a dla parzystego zwraca @p a.
+ * @param[in] ring : stałe arytmetyki
+ * @param[in] a : czynnik mniejszy niż @f$m@f$
+ * @return przygotowany czynnik
+ */
+static inline uint64_t ModFactor(const ModRing *ring, uint64_t a) {
+    return ring->inv != 0 ? ModMul(ring, a, ring->r64) : a;
+}
+
+/**
+ * Mnoży resztę przez czynnik przygotowany funkcją ModFactor. Dla
+ * nieparzystego modułu redukcja Montgomery'ego iloczynu
+ * @f$a 2^{64} b@f$ daje od razu @f$a b \bmod m@f$, a dla parzystego
+ * mnoży funkcją ModMul.
+ * @param[in] ring : stałe arytmetyki
+ * @param[in] factor : czynnik @f$a@f$ przygotowany funkcją ModFactor
+ * @param[in] b : czynnik mniejszy niż @f$m@f$
+ * @return @f$a b \bmod m@f$
+ */
+static inline uint64_t ModMulBy(const ModRing *ring, uint64_t factor,
+                                uint64_t b) {
+    if (ring->inv == 0)
+        return ModMul(ring, factor, b);
+    unsigned __int128 x = (unsigned __int128) factor * b;
+    // Młodsze słowa x i u * m są równe, więc odejmujemy tylko starsze.
+    uint64_t u = (uint64_t) x * ring->inv;
+    uint64_t high = (uint64_t) (x >> 64);
+    uint64_t sub = (uint64_t) (((unsigned __int128) u * ring->mod) >> 64);
+    return high - sub + (ring->mod & (0 - (uint64_t) (high < sub)));
+}
+
+/**
+ * Podnosi resztę do potęgi modulo @f$m@f$.
+ * @param[in] ring : stałe arytmetyki
+ * @param[in] base : podstawa mniejsza niż @f$m@f$
+ * @param[in] exp : wykładnik
+ * @return @f$base^{exp} \bmod m@f$
+ */
+uint64_t ModPow(const ModRing *ring, uint64_t base, uint64_t exp);
+
+/**
+ * Wyznacza resztę z dzielenia liczby ze znakiem przez moduł.
+ * @param[in] ring : stałe arytmetyki
+ * @param[in] value : liczba
+ * @return reszta z przedziału @f$[0, m)@f$ przystająca do @p value
+ */
+uint64_t ModFromSigned(const ModRing *ring, int64_t value);
+
+#endif // __POLY_MOD_H__
@@ -0,0 +1,653 @@
+/** @file
+  Implementacja biblioteki udostępniającej mnożenie wielomianów przez
+  podstawienie Kroneckera.
+
+  @author Szymon Łukasik <sl428760@mimuw.students.edu.pl>
+  @date 2021
+*/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "safe_alloc.h"
+#include "poly_packed.h"
+#include "poly_dense.h"
+#include "poly_mod.h"
+
+/** Największa liczba zmiennych wielomianów mnożonych przez podstawienie
+ * Kroneckera. */
+#define KRONECKER_MAX_VARS 16
+
+/** Najmniejsza liczba iloczynów jednomianów, od której PolyMulKronecker
+ * mnoży wielomiany przez podstawienie Kroneckera. */
+#define KRONECKER_MIN_PRODUCTS 64
+
+/** Największa długość iloczynu mnożonego jako gęsty wielomian jednej
+ * zmiennej. */
+#define KRONECKER_DENSE_MAX (1 << 20)
+
+/** Koszt dodania iloczynu jednomianów do tablicy haszującej
+ * w jednostkach DenseMulCost (wyznaczony testem wydajnościowym dense). */
+#define KRONECKER_HASH_WEIGHT 16
+
+/** Koszt dodania iloczynu jednomianów do gęstej tablicy współczynników
+ * w jednostkach DenseMulCost (wyznaczony testem wydajnościowym dense). */
+#define KRONECKER_SCATTER_WEIGHT 2
+
+/** To jest struktura przechowująca jednomian w reprezentacji rozproszonej. */
+typedef struct PackedTerm {
+    uint64_t key; ///< klucz - wykładnik zmiennej po podstawieniu
+    poly_coeff_t coeff; ///< niezerowy współczynnik
+} PackedTerm;
+
+/** To jest struktura przechowująca wielomian w reprezentacji rozproszonej. */
+typedef struct PackedPoly {
+    size_t size; ///< liczba jednomianów
+    PackedTerm *terms; ///< jednomiany, ściśle rosnąco względem kluczy
+} PackedPoly;
+
+/**
+ * To jest struktura opisująca zapis wykładników jednomianu w kluczu.
+ * Klucz jednomianu @f$x_0^{e_0} \cdots x_{vars-1}^{e_{vars-1}}@f$ to
+ * @f$\sum_i e_i w_i@f$, gdzie @f$w_i@f$ jest wagą zmiennej @f$x_i@f$.
+ * Waga każdej zmiennej jest większa od największego klucza zapisanego
+ * na wykładnikach dalszych zmiennych, a ostatnia zmienna ma wagę 1.
+ */
+typedef struct KeyLayout {
+    size_t vars; ///< liczba zmiennych
+    uint64_t weights[KRONECKER_MAX_VARS]; ///< wagi zmiennych
+} KeyLayout;
+
+/**
+ * Zwraca wykładnik zmiennej @f$x_{var}@f$ zapisany w kluczu.
+ * @param[in] key : klucz jednomianu
+ * @param[in] layout : zapis kluczy
+ * @param[in] var : numer zmiennej
+ * @return wykładnik
+ */
+static inline poly_exp_t KeyExp(uint64_t key, const KeyLayout *layout,
+                                 size_t var) {
+    if (var > 0)
+        key %= layout->weights[var - 1];
+    return (poly_exp_t) (key / layout->weights[var]);
+}
+
+/**
+ * To jest struktura opisująca wielomian z punktu widzenia reprezentacji
+ * rozproszonej.
+ */
+typedef struct PackedShape {
+    size_t vars; ///< liczba zmiennych, od których zależy wielomian
+    size_t terms; ///< liczba jednomianów po wymnożeniu wszystkich poziomów
+    poly_exp_t degs[KRONECKER_MAX_VARS]; ///< stopnie względem zmiennych
+    uint64_t max_coeff; ///< największa wartość bezwzględna współczynnika
+} PackedShape;
+
+/**
+ * Wyznacza liczbę zmiennych, liczbę jednomianów i stopnie względem
+ * zmiennych wielomianu będącego współczynnikiem na poziomie zmiennej
+ * @f$x_{var}@f$. Przerywa, gdy wielomian zależy od zmiennej o numerze
+ * KRONECKER_MAX_VARS lub większym. Zastępuje wywołania PolyDegBy dla
+ * kolejnych zmiennych jednym przejściem po wielomianie. Przerywa też,
+ * gdy wielomian ma współczynnik spoza typu poly_coeff_t (patrz
+ * PolySetExact).
+ * @param[in] p : wielomian
+ * @param[in] var : numer zmiennej
+ * @param[in, out] shape : opis wielomianu, aktualizowany
+ * @return Czy wielomian zależy tylko od pierwszych KRONECKER_MAX_VARS
+ *         zmiennych i nie ma dużych współczynników?
+ */
+static bool CollectShape(const Poly *p, size_t var, PackedShape *shape) {
+    if (PolyIsCoeff(p)) {
+        if (PolyIsBig(p))
+            return false;
+        if (!PolyIsZero(p))
+            shape->terms++;
+        uint64_t abs = p->coeff < 0 ? 0 - (uint64_t) p->coeff
+                                    : (uint64_t) p->coeff;
+        if (shape->max_coeff < abs)
+            shape->max_coeff = abs;
+        return true;
+    }
+    if (var == KRONECKER_MAX_VARS)
+        return false;
+
+    if (shape->vars < var + 1)
+        shape->vars = var + 1;
+    poly_exp_t deg = PolyExps(p)[p->size - 1];
+    if (shape->degs[var] < deg)
+        shape->degs[var] = deg;
+
+    for (size_t i = 0; i < p->size; i++)
+        if (!CollectShape(&p->arr[i].p, var + 1, shape))
+            return false;
+
+    return true;
+}
+
+/**
+ * Sprawdza, czy iloczyn wielomianów można policzyć w reprezentacji
+ * rozproszonej w bieżącym trybie współczynników. W trybie dokładnym
+ * (patrz PolySetExact) współczynniki iloczynu oraz wszystkie ich sumy
+ * częściowe muszą mieścić się w typie poly_coeff_t - każdy współczynnik
+ * iloczynu jest sumą co najwyżej tylu iloczynów współczynników, ile
+ * jednomianów ma krótszy z czynników. W pozostałych trybach działania
+ * na współczynnikach są dokładne z założenia.
+ * @param[in] p_shape : opis wielomianu @f$p@f$
+ * @param[in] q_shape : opis wielomianu @f$q@f$
+ * @return Czy współczynniki iloczynu nie wymagają sprawdzania przepełnień?
+ */
+static bool CoeffsFit(const PackedShape *p_shape, const PackedShape *q_shape) {
+    if (!PolyGetExact())
+        return true;
+
+    size_t terms = p_shape->terms < q_shape->terms ? p_shape->terms
+                                                   : q_shape->terms;
+    uint64_t bound;
+    return !__builtin_mul_overflow(p_shape->max_coeff, q_shape->max_coeff,
+                                   &bound)
+           && !__builtin_mul_overflow(bound, (uint64_t) terms, &bound)
+           && bound <= (uint64_t) INT64_MAX;
+}
+
+/**
+ * Dopisuje jednomiany wielomianu będącego współczynnikiem na poziomie
+ * zmiennej @f$x_{var}@f$ na koniec tablicy jednomianów wielomianu @p res.
+ * @param[in] p : wielomian
+ * @param[in] var : numer zmiennej
+ * @param[in] prefix : klucz z wykładnikami zmiennych
+ *                     @f$x_0, \ldots, x_{var-1}@f$
+ * @param[in] layout : zapis kluczy
+ * @param[in, out] res : wielomian w reprezentacji rozproszonej
+ */
+static void Flatten(const Poly *p, size_t var, uint64_t prefix,
+                    const KeyLayout *layout, PackedPoly *res) {
+    if (PolyIsCoeff(p)) {
+        if (!PolyIsZero(p))
+            res->terms[res->size++] = (PackedTerm) {.key = prefix,
+                                                     .coeff = p->coeff};
+        return;
+    }
+
+    uint64_t weight = layout->weights[var];
+    for (size_t i = 0; i < p->size; i++)
+        Flatten(&p->arr[i].p, var + 1,
+                prefix + (uint64_t) p->arr[i].exp * weight, layout, res);
+}
+
+/**
+ * Alokuje tablice wielomianu w reprezentacji rozproszonej.
+ * @param[in] capacity : liczba jednomianów, na które alokowane są tablice
+ * @return pusty wielomian
+ */
+static PackedPoly NewPackedPoly(size_t capacity) {
+    PackedPoly res = {.size = 0, .terms = NULL};
+    if (capacity > 0)
+        res.terms = SafeRealloc(NULL, capacity * sizeof(PackedTerm));
+    return res;
+}
+
+/**
+ * Zapisuje jednomiany wielomianu w tablicy kluczy o zadanym zapisie.
+ * @param[in] p : wielomian
+ * @param[in] shape : opis wielomianu wyznaczony przez CollectShape
+ * @param[in] layout : zapis kluczy
+ * @return wielomian @p p w reprezentacji rozproszonej
+ */
+static PackedPoly FlattenPoly(const Poly *p, const PackedShape *shape,
+                              const KeyLayout *layout) {
+    PackedPoly res = NewPackedPoly(shape->terms);
+    Flatten(p, 0, 0, layout, &res);
+    assert(res.size == shape->terms);
+    return res;
+}
+
+/**
+ * Tworzy wielomian będący współczynnikiem na poziomie zmiennej
+ * @f$x_{var}@f$ z jednomianów o kluczach różniących się tylko
+ * wykładnikami zmiennych @f$x_{var}, x_{var+1}, \ldots@f$.
+ * @param[in] count : liczba jednomianów
+ * @param[in] terms : jednomiany posortowane rosnąco względem kluczy
+ * @param[in] layout : zapis kluczy
+ * @param[in] var : numer zmiennej
+ * @return wielomian
+ */
+static Poly PolyFromTerms(size_t count, const PackedTerm terms[],
+                          const KeyLayout *layout, size_t var) {
+    if (var == layout->vars) {
+        assert(count == 1);
+        return PolyFromCoeff(terms[0].coeff);
+    }
+
+    size_t groups = 0;
+    for (size_t i = 0; i < count; i++)
+        if (i == 0 || KeyExp(terms[i].key, layout, var)
+                      != KeyExp(terms[i - 1].key, layout, var))
+            groups++;
+
+    PolyBuilder builder = NewPolyBuilder(groups);
+    for (size_t i = 0; i < count;) {
+        poly_exp_t exp = KeyExp(terms[i].key, layout, var);
+        size_t j = i + 1;
+        while (j < count && KeyExp(terms[j].key, layout, var) == exp)
+            j++;
+
+        Poly coeff = PolyFromTerms(j - i, terms + i, layout, var + 1);
+        Mono m = MonoFromPoly(&coeff, exp);
+        PolyBuilderAdd(&builder, &m);
+        i = j;
+    }
+
+    return PolyBuilderFinish(&builder);
+}
+
+/** Początkowy rozmiar tablicy haszującej iloczynu na każdy jednomian
+ * czynników. */
+#define PACKED_HASH_INITIAL 2
+
+/** Liczba bitów cyfry sortowania pozycyjnego. */
+#define RADIX_BITS 8
+
+/** Liczba możliwych wartości cyfry sortowania pozycyjnego. */
+#define RADIX_BUCKETS (1 << RADIX_BITS)
+
+/** Liczba cyfr klucza sortowania pozycyjnego. */
+#define RADIX_DIGITS (64 / RADIX_BITS)
+
+/**
+ * To jest struktura reprezentująca tablicę haszującą z adresowaniem
+ * otwartym, sumującą współczynniki jednomianów o równych kluczach.
+ */
+typedef struct TermsTable {
+    size_t size; ///< rozmiar tablicy, potęga dwójki
+    size_t count; ///< liczba zajętych miejsc
+    PackedTerm *terms; ///< jednomiany
+    bool *used; ///< czy miejsce jest zajęte
+    const ModRing *ring; ///< arytmetyka współczynników (patrz CoeffRing)
+} TermsTable;
+
+/**
+ * Wyznacza arytmetykę współczynników ustawioną funkcją PolySetModulus.
+ * @param[out] ring : stałe arytmetyki, ustawiane w trybie modularnym
+ * @return @p ring w trybie modularnym, a w przeciwnym przypadku NULL
+ *         (działania modulo @f$2^{64}@f$)
+ */
+static const ModRing *CoeffRing(ModRing *ring) {
+    poly_coeff_t mod = PolyGetModulus();
+    if (mod == 0)
+        return NULL;
+    *ring = NewModRing((uint64_t) mod);
+    return ring;
+}
+
+/**
+ * Dodaje współczynniki.
+ * @param[in] ring : arytmetyka współczynników (patrz CoeffRing)
+ * @param[in] a : współczynnik
+ * @param[in] b : współczynnik
+ * @return @f$a + b@f$
+ */
+static inline uint64_t CoeffAdd(const ModRing *ring, uint64_t a, uint64_t b) {
+    return ring == NULL ? a + b : ModAdd(ring, a, b);
+}
+
+/**
+ * Mnoży współczynniki.
+ * @param[in] ring : arytmetyka współczynników (patrz CoeffRing)
+ * @param[in] a : współczynnik
+ * @param[in] b : współczynnik
+ * @return @f$a b@f$
+ */
+static inline uint64_t CoeffMul(const ModRing *ring, uint64_t a, uint64_t b) {
+    return ring == NULL ? a * b : ModMul(ring, a, b);
+}
+
+/**
+ * Tworzy pustą tablicę haszującą.
+ * @param[in] size : rozmiar tablicy, potęga dwójki
+ * @param[in] ring : arytmetyka współczynników (patrz CoeffRing)
+ * @return tablica haszująca
+ */
+static TermsTable NewTermsTable(size_t size, const ModRing *ring) {
+    return (TermsTable) {.size = size, .count = 0,
+                         .terms = SafeRealloc(NULL, size * sizeof(PackedTerm)),
+                         .used = SafeCalloc(size, sizeof(bool)),
+                         .ring = ring};
+}
+
+/**
+ * Zwraca miejsce tablicy haszującej, od którego zaczyna się szukanie
+ * klucza.
+ * @param[in] table : tablica haszująca
+ * @param[in] key : klucz
+ * @return indeks miejsca
+ */
+static inline size_t TermsTableSlot(const TermsTable *table, uint64_t key) {
+    return (size_t) ((key * UINT64_C(0x9E3779B97F4A7C15)) >> 32)
+           & (table->size - 1);
+}
+
+static void TermsTableAdd(TermsTable *table, uint64_t key,
+                          poly_coeff_t coeff);
+
+/**
+ * Dwukrotnie powiększa tablicę haszującą.
+ * @param[in, out] table : tablica haszująca
+ */
+static void TermsTableGrow(TermsTable *table) {
+    TermsTable old = *table;
+    *table = NewTermsTable(2 * old.size, old.ring);
+    for (size_t i = 0; i < old.size; i++)
+        if (old.used[i])
+            TermsTableAdd(table, old.terms[i].key, old.terms[i].coeff);
+    free(old.terms);
+    free(old.used);
+}
+
+/**
+ * Dodaje jednomian do tablicy haszującej, sumując go z jednomianem
+ * o tym samym kluczu, jeśli taki już jest w tablicy.
+ * @param[in, out] table : tablica haszująca
+ * @param[in] key : klucz jednomianu
+ * @param[in] coeff : współczynnik jednomianu
+ */
+static void TermsTableAdd(TermsTable *table, uint64_t key,
+                          poly_coeff_t coeff) {
+    size_t slot = TermsTableSlot(table, key);
+    while (table->used[slot]) {
+        if (table->terms[slot].key == key) {
+            table->terms[slot].coeff = (poly_coeff_t) CoeffAdd(
+                    table->ring, (uint64_t) table->terms[slot].coeff,
+                    (uint64_t) coeff);
+            return;
+        }
+        slot = (slot + 1) & (table->size - 1);
+    }
+
+    // Utrzymujemy zapełnienie tablicy poniżej połowy.
+    if (2 * (table->count + 1) > table->size) {
+        TermsTableGrow(table);
+        TermsTableAdd(table, key, coeff);
+        return;
+    }
+    table->used[slot] = true;
+    table->terms[slot] = (PackedTerm) {.key = key, .coeff = coeff};
+    table->count++;
+}
+
+/**
+ * Sortuje jednomiany pozycyjnie (LSD radix sort) rosnąco względem kluczy,
+ * pomijając cyfry, które we wszystkich kluczach są równe.
+ * @param[in] count : liczba jednomianów
+ * @param[in, out] terms : tablica jednomianów
+ */
+static void TermsSort(size_t count, PackedTerm terms[]) {
+    if (count < 2)
+        return;
+
+    size_t histogram[RADIX_DIGITS][RADIX_BUCKETS] = {{0}};
+    for (size_t i = 0; i < count; i++)
+        for (size_t d = 0; d < RADIX_DIGITS; d++)
+            histogram[d][(terms[i].key >> (d * RADIX_BITS))
+                         & (RADIX_BUCKETS - 1)]++;
+
+    PackedTerm *buffer = SafeRealloc(NULL, count * sizeof(PackedTerm));
+    PackedTerm *src = terms, *dst = buffer;
+    for (size_t d = 0; d < RADIX_DIGITS; d++) {
+        size_t *offsets = histogram[d];
+        if (offsets[(src[0].key >> (d * RADIX_BITS)) & (RADIX_BUCKETS - 1)]
+            == count)
+            continue;
+
+        size_t sum = 0;
+        for (size_t b = 0; b < RADIX_BUCKETS; b++) {
+            size_t bucket = offsets[b];
+            offsets[b] = sum;
+            sum += bucket;
+        }
+        for (size_t i = 0; i < count; i++)
+            dst[offsets[(src[i].key >> (d * RADIX_BITS))
+                        & (RADIX_BUCKETS - 1)]++] = src[i];
+
+        PackedTerm *tmp = src;
+        src = dst;
+        dst = tmp;
+    }
+
+    if (src != terms)
+        memcpy(terms, src, count * sizeof(PackedTerm));
+    free(buffer);
+}
+
+/**
+ * Mnoży wielomiany w reprezentacji rozproszonej. Iloczyny wszystkich par
+ * jednomianów sumowane są w tablicy haszującej indeksowanej kluczami,
+ * a niezerowe wyniki sortowane pozycyjnie.
+ * @param[in] p : wielomian @f$p@f$
+ * @param[in] q : wielomian @f$q@f$
+ * @param[in] ring : arytmetyka współczynników (patrz CoeffRing)
+ * @return @f$p * q@f$
+ */
+static PackedPoly PackedMulHash(const PackedPoly *p, const PackedPoly *q,
+                                const ModRing *ring) {
+    PackedPoly res = NewPackedPoly(0);
+    if (p->size == 0 || q->size == 0)
+        return res;
+
+    size_t size = 1;
+    while (size < PACKED_HASH_INITIAL * (p->size + q->size))
+        size *= 2;
+    TermsTable table = NewTermsTable(size, ring);
+
+    // Klucz iloczynu jednomianów to suma ich kluczy.
+    for (size_t i = 0; i < p->size; i++)
+        for (size_t j = 0; j < q->size; j++)
+            TermsTableAdd(&table, p->terms[i].key + q->terms[j].key,
+                          (poly_coeff_t) CoeffMul(
+                                  ring, (uint64_t) p->terms[i].coeff,
+                                  (uint64_t) q->terms[j].coeff));
+
+    // Zbieramy niezerowe jednomiany na początek tablicy i sortujemy je.
+    size_t count = 0;
+    for (size_t i = 0; i < table.size; i++)
+        if (table.used[i] && table.terms[i].coeff != 0)
+            table.terms[count++] = table.terms[i];
+    free(table.used);
+    TermsSort(count, table.terms);
+
+    if (count == 0) {
+        free(table.terms);
+        return res;
+    }
+    res.size = count;
+    res.terms = SafeRealloc(table.terms, count * sizeof(PackedTerm));
+    return res;
+}
+
+/**
+ * Usuwa z pamięci wielomian w reprezentacji rozproszonej.
+ * @param[in] p : wielomian w reprezentacji rozproszonej
+ */
+static void PackedDestroy(PackedPoly *p) {
+    free(p->terms);
+    *p = (PackedPoly) {.size = 0, .terms = NULL};
+}
+
+/**
+ * Tworzy wielomian w reprezentacji rozproszonej z niezerowych
+ * współczynników gęstej tablicy indeksowanej kluczami i zwalnia tablicę.
+ * @param[in] count : długość tablicy
+ * @param[in] coeffs : tablica współczynników
+ * @return wielomian w reprezentacji rozproszonej
+ */
+static PackedPoly PackedFromDense(size_t count, uint64_t coeffs[]) {
+    size_t nonzero = 0;
+    for (size_t key = 0; key < count; key++)
+        if (coeffs[key] != 0)
+            nonzero++;
+
+    PackedPoly res = NewPackedPoly(nonzero);
+    for (size_t key = 0; key < count; key++)
+        if (coeffs[key] != 0)
+            res.terms[res.size++] = (PackedTerm) {
+                    .key = key, .coeff = (poly_coeff_t) coeffs[key]};
+    free(coeffs);
+
+    return res;
+}
+
+/**
+ * Mnoży wielomiany w reprezentacji rozproszonej, sumując iloczyny
+ * wszystkich par jednomianów w gęstej tablicy współczynników indeksowanej
+ * kluczami. Wynik nie wymaga sortowania.
+ * @param[in] p : niezerowy wielomian @f$p@f$
+ * @param[in] q : niezerowy wielomian @f$q@f$
+ * @param[in] count : długość tablicy, większa niż suma największych
+ *                    kluczy obu wielomianów
+ * @param[in] ring : arytmetyka współczynników (patrz CoeffRing)
+ * @return @f$p * q@f$
+ */
+static PackedPoly PackedMulScatter(const PackedPoly *p, const PackedPoly *q,
+                                   size_t count, const ModRing *ring) {
+    uint64_t *coeffs = SafeCalloc(count, sizeof(uint64_t));
+    for (size_t i = 0; i < p->size; i++) {
+        uint64_t *row = coeffs + p->terms[i].key;
+        uint64_t coeff = (uint64_t) p->terms[i].coeff;
+        if (ring == NULL) {
+            for (size_t j = 0; j < q->size; j++)
+                row[q->terms[j].key] += coeff * (uint64_t) q->terms[j].coeff;
+        } else {
+            uint64_t factor = ModFactor(ring, coeff);
+            for (size_t j = 0; j < q->size; j++) {
+                uint64_t *target = &row[q->terms[j].key];
+                *target = ModAdd(ring, *target, ModMulBy(
+                        ring, factor, (uint64_t) q->terms[j].coeff));
+            }
+        }
+    }
+    return PackedFromDense(count, coeffs);
+}
+
+/**
+ * Zapisuje wielomian w reprezentacji rozproszonej jako gęstą tablicę
+ * współczynników indeksowaną kluczami.
+ * @param[in] p : niezerowy wielomian w reprezentacji rozproszonej
+ * @return tablica długości większej o jeden niż największy klucz
+ */
+static uint64_t *PackedToDense(const PackedPoly *p) {
+    size_t count = p->terms[p->size - 1].key + 1;
+    uint64_t *coeffs = SafeCalloc(count, sizeof(uint64_t));
+    for (size_t i = 0; i < p->size; i++)
+        coeffs[p->terms[i].key] = (uint64_t) p->terms[i].coeff;
+    return coeffs;
+}
+
+/**
+ * Mnoży wielomiany w reprezentacji rozproszonej jak gęste wielomiany
+ * jednej zmiennej (patrz DenseMul i DenseMulMod), traktując klucze jako
+ * wykładniki. Wynik nie wymaga sortowania.
+ * @param[in] p : niezerowy wielomian @f$p@f$
+ * @param[in] q : niezerowy wielomian @f$q@f$
+ * @param[in] ring : arytmetyka współczynników (patrz CoeffRing)
+ * @return @f$p * q@f$
+ */
+static PackedPoly PackedMulDense(const PackedPoly *p, const PackedPoly *q,
+                                 const ModRing *ring) {
+    size_t p_count = p->terms[p->size - 1].key + 1;
+    size_t q_count = q->terms[q->size - 1].key + 1;
+    size_t count = p_count + q_count - 1;
+
+    uint64_t *p_coeffs = PackedToDense(p), *q_coeffs = PackedToDense(q);
+    uint64_t *coeffs = SafeRealloc(NULL, count * sizeof(uint64_t));
+    if (ring == NULL)
+        DenseMul(p_count, p_coeffs, q_count, q_coeffs, coeffs);
+    else
+        DenseMulMod(p_count, p_coeffs, q_count, q_coeffs, ring, coeffs);
+    free(p_coeffs);
+    free(q_coeffs);
+
+    return PackedFromDense(count, coeffs);
+}
+
+/**
+ * Wyznacza wagi podstawienia Kroneckera dla iloczynu dwóch wielomianów.
+ * Zmienna @f$x_i@f$ zastępowana jest przez @f$y^{w_i}@f$, gdzie
+ * @f$w_i = \prod_{j > i} D_j@f$, a @f$D_j@f$ jest o jeden większe niż suma
+ * stopni czynników względem zmiennej @f$x_j@f$. Różne jednomiany iloczynu
+ * mają więc różne wykładniki @f$y@f$, mniejsze niż @f$\prod_j D_j@f$.
+ * @param[in] p_shape : opis wielomianu @f$p@f$
+ * @param[in] q_shape : opis wielomianu @f$q@f$
+ * @param[out] layout : zapis kluczy
+ * @return Czy klucze iloczynu mieszczą się w 64 bitach, a jego wykładniki
+ *         w typie poly_exp_t?
+ */
+static bool KroneckerLayout(const PackedShape *p_shape,
+                            const PackedShape *q_shape, KeyLayout *layout) {
+    layout->vars = p_shape->vars > q_shape->vars ? p_shape->vars
+                                                 : q_shape->vars;
+    uint64_t weight = 1;
+    for (size_t i = layout->vars; i-- > 0;) {
+        uint64_t deg = (uint64_t) p_shape->degs[i]
+                       + (uint64_t) q_shape->degs[i];
+        if (deg > INT32_MAX || weight > UINT64_MAX / (deg + 1))
+            return false;
+        layout->weights[i] = weight;
+        weight *= deg + 1;
+    }
+
+    return true;
+}
+
+bool PolyMulKronecker(const Poly *p, const Poly *q, Poly *res) {
+    if (PolyIsCoeff(p) || PolyIsCoeff(q))
+        return false;
+
+    PackedShape p_shape = {0}, q_shape = {0};
+    if (!CollectShape(p, 0, &p_shape) || !CollectShape(q, 0, &q_shape))
+        return false;
+
+    size_t products = p_shape.terms * q_shape.terms;
+    KeyLayout layout;
+    if (products < KRONECKER_MIN_PRODUCTS
+        || !KroneckerLayout(&p_shape, &q_shape, &layout)
+        || !CoeffsFit(&p_shape, &q_shape))
+        return false;
+
+    PackedPoly p_flat = FlattenPoly(p, &p_shape, &layout);
+    PackedPoly q_flat = FlattenPoly(q, &q_shape, &layout);
+    /* Gdy iloczyn mieści się w gęstej tablicy, sumujemy w niej iloczyny
+     * jednomianów lub mnożymy wielomiany jak gęste, zależnie od tego,
+     * co jest tańsze. W przeciwnym przypadku sumujemy iloczyny w tablicy
+     * haszującej. */
+    size_t p_count = p_flat.terms[p_flat.size - 1].key + 1;
+    size_t q_count = q_flat.terms[q_flat.size - 1].key + 1;
+    size_t length = p_count + q_count - 1;
+    ModRing storage;
+    const ModRing *ring = CoeffRing(&storage);
+    PackedPoly product;
+    if (length > KRONECKER_DENSE_MAX) {
+        product = PackedMulHash(&p_flat, &q_flat, ring);
+    } else {
+        size_t scatter_cost = KRONECKER_SCATTER_WEIGHT * products + length;
+        size_t dense_cost = (ring == NULL ? DenseMulCost(p_count, q_count)
+                                          : DenseMulModCost(p_count, q_count))
+                            + length;
+        size_t hash_cost = KRONECKER_HASH_WEIGHT * products;
+        if (hash_cost < scatter_cost && hash_cost < dense_cost)
+            product = PackedMulHash(&p_flat, &q_flat, ring);
+        else if (scatter_cost <= dense_cost)
+            product = PackedMulScatter(&p_flat, &q_flat, length, ring);
+        else
+            product = PackedMulDense(&p_flat, &q_flat, ring);
+    }
+
+    if (product.size == 0)
+        *res = PolyZero();
+    else
+        *res = PolyFromTerms(product.size, product.terms, &layout, 0);
+
+    PackedDestroy(&p_flat);
+    PackedDestroy(&q_flat);
+    PackedDestroy(&product);
+    return true;
+}
@@ -0,0 +1,44 @@
+/** @file
+  Biblioteka udostępniająca mnożenie wielomianów o niewielkiej liczbie
+  zmiennych przez podstawienie Kroneckera.
+
+  Wielomian zapisywany jest na czas mnożenia jako płaska tablica
+  jednomianów posortowana rosnąco względem kluczy. Klucz jednomianu to
+  wykładnik zmiennej @f$y@f$, którą zastąpione zostały wszystkie
+  zmienne, więc porządek kluczy odpowiada porządkowi jednomianów
+  w rekurencyjnej strukturze Poly, a iloczyn jednomianów ma klucz równy
+  sumie kluczy.
+
+  @author Szymon Łukasik <sl428760@mimuw.students.edu.pl>
+  @date 2021
+*/
+
+#ifndef __POLY_PACKED_H__
+#define __POLY_PACKED_H__
+
+#include <stdbool.h>
+#include "poly.h"
+
+/**
+ * Mnoży dwa wielomiany przez podstawienie Kroneckera, jeśli jest to
+ * możliwe i opłacalne. Zmienne @f$x_0, \ldots, x_{k-1}@f$ zastępowane są
+ * potęgami jednej zmiennej @f$y@f$ tak, by różne jednomiany iloczynu miały
+ * różne wykładniki @f$y@f$, a iloczyn wielomianów jednej zmiennej liczony
+ * jest sposobem o najmniejszym szacowanym koszcie: sumowaniem iloczynów
+ * jednomianów w tablicy współczynników lub w tablicy haszującej albo jak
+ * iloczyn gęstych wielomianów (patrz DenseMul).
+ * Podstawienie jest możliwe, gdy wielomiany zależą od co najwyżej
+ * 16 zmiennych, wykładniki @f$y@f$ mieszczą się w 64 bitach, a wykładniki
+ * iloczynu w typie poly_exp_t. W trybie dokładnym (patrz PolySetExact)
+ * współczynniki iloczynu muszą też na pewno mieścić się w typie
+ * poly_coeff_t - w przeciwnym przypadku przepełnienia sprawdza mnożenie
+ * rekurencyjne.
+ * @param[in] p : wielomian @f$p@f$
+ * @param[in] q : wielomian @f$q@f$
+ * @param[out] res : wskaźnik na wynik @f$p * q@f$, ustawiany tylko
+ *                   w przypadku powodzenia
+ * @return Czy iloczyn został obliczony przez podstawienie Kroneckera?
+ */
+bool PolyMulKronecker(const Poly *p, const Poly *q, Poly *res);
+
+#endif // __POLY_PACKED_H__
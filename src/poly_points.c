@@ -0,0 +1,307 @@
+/** @file
+  Implementacja biblioteki udostępniającej wyliczanie wartości wielomianu
+  jednej zmiennej w wielu punktach naraz.
+
+  @author Szymon Łukasik <sl428760@mimuw.students.edu.pl>
+  @date 2021
+*/
+
+#include "poly_points.h"
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#include <immintrin.h>
+/** Czy kompilator pozwala zbudować jądro korzystające z rozszerzenia AVX2. */
+#define POINTS_AVX2 1
+#else
+/** Czy kompilator pozwala zbudować jądro korzystające z rozszerzenia AVX2. */
+#define POINTS_AVX2 0
+#endif
+
+/** Liczba punktów grupy liczonej w akumulatorach skalarnych. Niezależne
+ * akumulatory ukrywają opóźnienie mnożenia w schemacie Hornera. */
+#define SCALAR_GROUP 4
+
+/** Liczba punktów grupy liczonej modulo liczba mniejsza niż @f$2^{62}@f$.
+ * Mnożenie modulo ma kilkakrotnie dłuższe opóźnienie niż zwykłe, dlatego
+ * grupa jest większa. */
+#define MOD_GROUP 8
+
+/** Liczba wektorów grupy liczonej w torach wektorów AVX2. */
+#define AVX2_VECTORS 4
+
+/** Liczba punktów grupy liczonej w torach wektorów AVX2. */
+#define AVX2_GROUP (4 * AVX2_VECTORS)
+
+/** Czy funkcja PointsEval ma liczyć w torach wektorów, o ile procesor
+ * obsługuje rozszerzenie AVX2 (patrz PointsSetSimd). */
+static bool points_simd = POINTS_AVX2;
+
+/**
+ * Podnosi punkty grupy do potęgi modulo @f$2^{64}@f$, przechodząc bity
+ * wykładnika od najstarszego.
+ * @param[in] x : punkty grupy
+ * @param[in] exp : wykładnik, dodatni
+ * @param[out] res : potęgi punktów
+ */
+static inline void GroupPower(const uint64_t x[], poly_exp_t exp,
+                              uint64_t res[]) {
+    for (size_t l = 0; l < SCALAR_GROUP; l++)
+        res[l] = x[l];
+    for (int bit = 30 - __builtin_clz((unsigned) exp); bit >= 0; bit--)
+        for (size_t l = 0; l < SCALAR_GROUP; l++) {
+            res[l] *= res[l];
+            if ((exp >> bit) & 1)
+                res[l] *= x[l];
+        }
+}
+
+/**
+ * Wylicza wartości wielomianu w co najwyżej SCALAR_GROUP punktach
+ * schematem Hornera, przechodząc od najwyższego wykładnika i mnożąc
+ * akumulatory przez @f$x^{e_{k+1} - e_k}@f$. Potęga wyliczana jest
+ * ponownie tylko wtedy, gdy zmienia się różnica wykładników.
+ * @param[in] terms : liczba jednomianów, dodatnia
+ * @param[in] coeffs : współczynniki
+ * @param[in] exps : wykładniki
+ * @param[in] count : liczba punktów, od 1 do SCALAR_GROUP
+ * @param[in] xs : punkty
+ * @param[out] res : wartości wielomianu
+ */
+static void EvalGroup(size_t terms, const uint64_t coeffs[],
+                      const poly_exp_t exps[], size_t count,
+                      const uint64_t xs[], uint64_t res[]) {
+    uint64_t x[SCALAR_GROUP] = {0}, acc[SCALAR_GROUP], step[SCALAR_GROUP];
+    for (size_t l = 0; l < count; l++)
+        x[l] = xs[l];
+    for (size_t l = 0; l < SCALAR_GROUP; l++) {
+        acc[l] = coeffs[terms - 1];
+        step[l] = x[l];
+    }
+
+    poly_exp_t step_exp = 1;
+    for (size_t k = terms - 1; k-- > 0;) {
+        poly_exp_t gap = exps[k + 1] - exps[k];
+        if (gap != step_exp) {
+            GroupPower(x, gap, step);
+            step_exp = gap;
+        }
+        for (size_t l = 0; l < SCALAR_GROUP; l++)
+            acc[l] = acc[l] * step[l] + coeffs[k];
+    }
+
+    if (exps[0] > 0) {
+        GroupPower(x, exps[0], step);
+        for (size_t l = 0; l < SCALAR_GROUP; l++)
+            acc[l] *= step[l];
+    }
+    for (size_t l = 0; l < count; l++)
+        res[l] = acc[l];
+}
+
+#if POINTS_AVX2
+
+/**
+ * Mnoży tory wektorów modulo @f$2^{64}@f$. AVX2 mnoży jedynie młodsze
+ * połowy torów, dlatego iloczyn składamy z trzech iloczynów połówek:
+ * @f$ab = a_l b_l + 2^{32}(a_h b_l + a_l b_h) \bmod 2^{64}@f$.
+ * Starsze połowy drugiego czynnika podawane są osobno, bo w schemacie
+ * Hornera jest on ten sam dla wielu mnożeń.
+ * @param[in] a : czynniki
+ * @param[in] b : czynniki
+ * @param[in] b_high : starsze połowy torów @p b przesunięte na młodsze
+ * @return iloczyny torów
+ */
+__attribute__((target("avx2")))
+static inline __m256i Mul64(__m256i a, __m256i b, __m256i b_high) {
+    __m256i cross = _mm256_add_epi64(
+            _mm256_mul_epu32(_mm256_srli_epi64(a, 32), b),
+            _mm256_mul_epu32(a, b_high));
+    return _mm256_add_epi64(_mm256_mul_epu32(a, b),
+                            _mm256_slli_epi64(cross, 32));
+}
+
+/**
+ * Mnoży tory wektorów modulo @f$2^{64}@f$ (patrz Mul64).
+ * @param[in] a : czynniki
+ * @param[in] b : czynniki
+ * @return iloczyny torów
+ */
+__attribute__((target("avx2")))
+static inline __m256i Mul64Any(__m256i a, __m256i b) {
+    return Mul64(a, b, _mm256_srli_epi64(b, 32));
+}
+
+/**
+ * Podnosi punkty grupy w torach wektorów do potęgi (patrz GroupPower).
+ * @param[in] x : punkty grupy
+ * @param[in] exp : wykładnik, dodatni
+ * @param[out] res : potęgi punktów
+ */
+__attribute__((target("avx2")))
+static inline void GroupPowerAvx2(const __m256i x[], poly_exp_t exp,
+                                  __m256i res[]) {
+    for (size_t v = 0; v < AVX2_VECTORS; v++)
+        res[v] = x[v];
+    for (int bit = 30 - __builtin_clz((unsigned) exp); bit >= 0; bit--)
+        for (size_t v = 0; v < AVX2_VECTORS; v++) {
+            res[v] = Mul64Any(res[v], res[v]);
+            if ((exp >> bit) & 1)
+                res[v] = Mul64Any(res[v], x[v]);
+        }
+}
+
+/**
+ * Wylicza wartości wielomianu w AVX2_GROUP punktach w torach wektorów
+ * (patrz EvalGroup).
+ * @param[in] terms : liczba jednomianów, dodatnia
+ * @param[in] coeffs : współczynniki
+ * @param[in] exps : wykładniki
+ * @param[in] xs : AVX2_GROUP punktów
+ * @param[out] res : wartości wielomianu
+ */
+__attribute__((target("avx2")))
+static void EvalGroupAvx2(size_t terms, const uint64_t coeffs[],
+                          const poly_exp_t exps[], const uint64_t xs[],
+                          uint64_t res[]) {
+    __m256i x[AVX2_VECTORS], acc[AVX2_VECTORS], step[AVX2_VECTORS];
+    __m256i step_high[AVX2_VECTORS];
+    for (size_t v = 0; v < AVX2_VECTORS; v++) {
+        x[v] = _mm256_loadu_si256((const __m256i *) (xs + 4 * v));
+        acc[v] = _mm256_set1_epi64x((long long) coeffs[terms - 1]);
+        step[v] = x[v];
+        step_high[v] = _mm256_srli_epi64(x[v], 32);
+    }
+
+    poly_exp_t step_exp = 1;
+    for (size_t k = terms - 1; k-- > 0;) {
+        poly_exp_t gap = exps[k + 1] - exps[k];
+        if (gap != step_exp) {
+            GroupPowerAvx2(x, gap, step);
+            for (size_t v = 0; v < AVX2_VECTORS; v++)
+                step_high[v] = _mm256_srli_epi64(step[v], 32);
+            step_exp = gap;
+        }
+        __m256i c = _mm256_set1_epi64x((long long) coeffs[k]);
+        for (size_t v = 0; v < AVX2_VECTORS; v++)
+            acc[v] = _mm256_add_epi64(Mul64(acc[v], step[v], step_high[v]),
+                                      c);
+    }
+
+    if (exps[0] > 0) {
+        GroupPowerAvx2(x, exps[0], step);
+        for (size_t v = 0; v < AVX2_VECTORS; v++)
+            acc[v] = Mul64Any(acc[v], step[v]);
+    }
+    for (size_t v = 0; v < AVX2_VECTORS; v++)
+        _mm256_storeu_si256((__m256i *) (res + 4 * v), acc[v]);
+}
+
+#endif
+
+bool PointsSetSimd(bool enabled) {
+    points_simd = POINTS_AVX2 && enabled;
+#if POINTS_AVX2
+    return points_simd && __builtin_cpu_supports("avx2");
+#else
+    return false;
+#endif
+}
+
+void PointsEval(size_t terms, const uint64_t coeffs[], const poly_exp_t exps[],
+                size_t count, const uint64_t xs[], uint64_t res[]) {
+    if (terms == 0) {
+        for (size_t i = 0; i < count; i++)
+            res[i] = 0;
+        return;
+    }
+
+    size_t i = 0;
+#if POINTS_AVX2
+    if (points_simd && __builtin_cpu_supports("avx2"))
+        for (; i + AVX2_GROUP <= count; i += AVX2_GROUP)
+            EvalGroupAvx2(terms, coeffs, exps, xs + i, res + i);
+#endif
+    for (; i < count; i += SCALAR_GROUP) {
+        size_t group = count - i < SCALAR_GROUP ? count - i : SCALAR_GROUP;
+        EvalGroup(terms, coeffs, exps, group, xs + i, res + i);
+    }
+}
+
+/**
+ * Podnosi punkty grupy do potęgi modulo @p ring->mod (patrz GroupPower)
+ * i przygotowuje potęgi do mnożenia funkcją ModMulBy.
+ * @param[in] ring : arytmetyka modulo
+ * @param[in] x : punkty grupy
+ * @param[in] exp : wykładnik, dodatni
+ * @param[out] res : potęgi punktów przygotowane funkcją ModFactor
+ */
+static inline void GroupPowerMod(const ModRing *ring, const uint64_t x[],
+                                 poly_exp_t exp, uint64_t res[]) {
+    for (size_t l = 0; l < MOD_GROUP; l++) {
+        uint64_t power = x[l];
+        for (int bit = 30 - __builtin_clz((unsigned) exp); bit >= 0; bit--) {
+            power = ModMul(ring, power, power);
+            if ((exp >> bit) & 1)
+                power = ModMul(ring, power, x[l]);
+        }
+        res[l] = ModFactor(ring, power);
+    }
+}
+
+/**
+ * Wylicza wartości wielomianu w co najwyżej MOD_GROUP punktach modulo
+ * @p ring->mod (patrz EvalGroup). Potęgi punktów są czynnikami wielu
+ * mnożeń, dlatego mnożymy przez nie funkcją ModMulBy.
+ * @param[in] ring : arytmetyka modulo
+ * @param[in] terms : liczba jednomianów, dodatnia
+ * @param[in] coeffs : współczynniki
+ * @param[in] exps : wykładniki
+ * @param[in] count : liczba punktów, od 1 do MOD_GROUP
+ * @param[in] xs : punkty
+ * @param[out] res : wartości wielomianu
+ */
+static void EvalGroupMod(const ModRing *ring, size_t terms,
+                         const uint64_t coeffs[], const poly_exp_t exps[],
+                         size_t count, const uint64_t xs[], uint64_t res[]) {
+    uint64_t x[MOD_GROUP] = {0}, acc[MOD_GROUP], step[MOD_GROUP];
+    for (size_t l = 0; l < count; l++)
+        x[l] = xs[l];
+    for (size_t l = 0; l < MOD_GROUP; l++) {
+        acc[l] = coeffs[terms - 1];
+        step[l] = ModFactor(ring, x[l]);
+    }
+
+    poly_exp_t step_exp = 1;
+    for (size_t k = terms - 1; k-- > 0;) {
+        poly_exp_t gap = exps[k + 1] - exps[k];
+        if (gap != step_exp) {
+            GroupPowerMod(ring, x, gap, step);
+            step_exp = gap;
+        }
+        for (size_t l = 0; l < MOD_GROUP; l++)
+            acc[l] = ModAdd(ring, ModMulBy(ring, step[l], acc[l]), coeffs[k]);
+    }
+
+    if (exps[0] > 0) {
+        GroupPowerMod(ring, x, exps[0], step);
+        for (size_t l = 0; l < MOD_GROUP; l++)
+            acc[l] = ModMulBy(ring, step[l], acc[l]);
+    }
+    for (size_t l = 0; l < count; l++)
+        res[l] = acc[l];
+}
+
+void PointsEvalMod(const ModRing *ring, size_t terms, const uint64_t coeffs[],
+                   const poly_exp_t exps[], size_t count, const uint64_t xs[],
+                   uint64_t res[]) {
+    if (terms == 0) {
+        for (size_t i = 0; i < count; i++)
+            res[i] = 0;
+        return;
+    }
+
+    for (size_t i = 0; i < count; i += MOD_GROUP) {
+        size_t group = count - i < MOD_GROUP ? count - i : MOD_GROUP;
+        EvalGroupMod(ring, terms, coeffs, exps, group, xs + i, res + i);
+    }
+}
@@ -0,0 +1,65 @@
+/** @file
+  Biblioteka udostępniająca wyliczanie wartości wielomianu jednej zmiennej
+  w wielu punktach naraz.
+
+  Wielomian zapisany jest jako tablica współczynników i tablica ściśle
+  rosnących wykładników jego jednomianów. Wartości liczone są schematem
+  Hornera jednocześnie dla grupy punktów, tak że każdy jednomian
+  odczytywany jest raz na całą grupę. Na procesorach z rozszerzeniem AVX2
+  punkty grupy liczone są w 64-bitowych torach wektorów, a w pozostałych
+  przypadkach w kilku niezależnych akumulatorach skalarnych. Działania
+  wykonywane są modulo @f$2^{64}@f$, tak jak działania na typie
+  poly_coeff_t w pozostałej części biblioteki, a w odmianie z przyrostkiem
+  Mod modulo liczba mniejsza niż @f$2^{62}@f$ (patrz poly_mod.h).
+
+  @author Szymon Łukasik <sl428760@mimuw.students.edu.pl>
+  @date 2021
+*/
+
+#ifndef __POLY_POINTS_H__
+#define __POLY_POINTS_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include "poly.h"
+#include "poly_mod.h"
+
+/**
+ * Wylicza wartości wielomianu @f$\sum c_k x^{e_k}@f$ w punktach.
+ * @param[in] terms : liczba jednomianów
+ * @param[in] coeffs : współczynniki @f$c_k@f$
+ * @param[in] exps : ściśle rosnące, nieujemne wykładniki @f$e_k@f$
+ * @param[in] count : liczba punktów
+ * @param[in] xs : punkty
+ * @param[out] res : tablica długości @p count na wartości wielomianu
+ *                   w kolejnych punktach
+ */
+void PointsEval(size_t terms, const uint64_t coeffs[], const poly_exp_t exps[],
+                size_t count, const uint64_t xs[], uint64_t res[]);
+
+/**
+ * Wylicza wartości wielomianu w punktach modulo @p ring->mod
+ * (patrz PointsEval). Zakłada, że współczynniki i punkty są resztami.
+ * Działania modulo liczone są w akumulatorach skalarnych.
+ * @param[in] ring : arytmetyka modulo
+ * @param[in] terms : liczba jednomianów
+ * @param[in] coeffs : współczynniki @f$c_k@f$
+ * @param[in] exps : ściśle rosnące, nieujemne wykładniki @f$e_k@f$
+ * @param[in] count : liczba punktów
+ * @param[in] xs : punkty
+ * @param[out] res : tablica długości @p count na wartości wielomianu
+ */
+void PointsEvalMod(const ModRing *ring, size_t terms, const uint64_t coeffs[],
+                   const poly_exp_t exps[], size_t count, const uint64_t xs[],
+                   uint64_t res[]);
+
+/**
+ * Włącza lub wyłącza liczenie w torach wektorów w funkcji PointsEval.
+ * Domyślnie jest ono włączone, o ile procesor obsługuje rozszerzenie AVX2.
+ * @param[in] enabled : czy liczyć w torach wektorów
+ * @return Czy funkcja PointsEval będzie liczyć w torach wektorów?
+ */
+bool PointsSetSimd(bool enabled);
+
+#endif // __POLY_POINTS_H__
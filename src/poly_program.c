@@ -0,0 +1,550 @@
+/** @file
+  Implementacja biblioteki udostępniającej kompilację wielomianu do programu
+  wyliczającego jego wartość oraz wykonywanie takiego programu.
+
+  @author Szymon Łukasik <sl428760@mimuw.students.edu.pl>
+  @date 2021
+*/
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "big_int.h"
+#include "poly_program.h"
+#include "safe_alloc.h"
+
+/** Liczba wyliczeń wykonywanych jednocześnie przez interpreter. */
+#define PROG_LANES 8
+
+/** Liczba bitów rejestru wirtualnego opisujących jego rodzaj. */
+#define VREG_KIND_SHIFT 30
+
+/** Maska numeru rejestru wirtualnego w obrębie jego rodzaju. */
+#define VREG_INDEX_MASK ((UINT32_C(1) << VREG_KIND_SHIFT) - 1)
+
+/** Początkowy rozmiar tablicy haszującej kompilatora. */
+#define CACHE_INITIAL_SIZE 64
+
+/** Rodzaje rejestrów wirtualnych. Dopiero po kompilacji wiadomo, ile jest
+ * zmiennych i stałych, więc rejestry numerowane są osobno w każdym
+ * rodzaju. */
+typedef enum VregKind {
+    VREG_VAR, ///< zmienna
+    VREG_CONST, ///< stała
+    VREG_TEMP ///< wynik instrukcji o tym samym numerze
+} VregKind;
+
+/** Rodzaje wpisów tablicy haszującej kompilatora. */
+typedef enum CacheKind {
+    CACHE_EMPTY, ///< wolne miejsce
+    CACHE_CONST, ///< stała o wartości @p key
+    CACHE_POWER, ///< potęga o wykładniku @p key zmiennej @p level
+    CACHE_SUBTREE, ///< poddrzewo o skrócie @p key na poziomie @p level
+    CACHE_ARRAY ///< poddrzewo o tablicy jednomianów pod adresem @p key
+} CacheKind;
+
+/** To jest struktura przechowująca wpis tablicy haszującej kompilatora. */
+typedef struct CacheEntry {
+    uint64_t key; ///< klucz wpisu, którego znaczenie zależy od rodzaju
+    uint64_t hash; ///< skrót poddrzewa wpisów CACHE_ARRAY
+    const Poly *p; ///< poddrzewo wpisów CACHE_SUBTREE
+    uint32_t kind; ///< rodzaj wpisu (patrz CacheKind)
+    uint32_t level; ///< numer zmiennej
+    uint32_t reg; ///< rejestr wirtualny z wartością
+} CacheEntry;
+
+/** To jest struktura przechowująca stan kompilatora. */
+typedef struct Compiler {
+    ProgInstr *code; ///< instrukcje działające na rejestrach wirtualnych
+    size_t size; ///< liczba instrukcji
+    size_t capacity; ///< pojemność tablicy @p code
+    uint64_t *consts; ///< wartości stałych
+    size_t consts_count; ///< liczba stałych
+    size_t consts_capacity; ///< pojemność tablicy @p consts
+    CacheEntry *cache; ///< tablica haszująca
+    size_t cache_count; ///< liczba wpisów tablicy haszującej
+    size_t cache_size; ///< rozmiar tablicy haszującej, potęga dwójki
+    size_t vars; ///< liczba zmiennych, od których zależy wielomian
+    const ModRing *ring; ///< arytmetyka modulo lub NULL dla @f$2^{64}@f$
+} Compiler;
+
+/**
+ * Tworzy rejestr wirtualny.
+ * @param[in] kind : rodzaj rejestru
+ * @param[in] index : numer rejestru w obrębie rodzaju
+ * @return rejestr wirtualny
+ */
+static inline uint32_t Vreg(VregKind kind, size_t index) {
+    assert(index <= VREG_INDEX_MASK);
+    return ((uint32_t) kind << VREG_KIND_SHIFT) | (uint32_t) index;
+}
+
+/**
+ * Zwraca rodzaj rejestru wirtualnego.
+ * @param[in] reg : rejestr wirtualny
+ * @return rodzaj rejestru
+ */
+static inline VregKind VregKindOf(uint32_t reg) {
+    return (VregKind) (reg >> VREG_KIND_SHIFT);
+}
+
+/**
+ * Zwraca numer rejestru wirtualnego w obrębie jego rodzaju.
+ * @param[in] reg : rejestr wirtualny
+ * @return numer rejestru
+ */
+static inline size_t VregIndex(uint32_t reg) {
+    return reg & VREG_INDEX_MASK;
+}
+
+/**
+ * Miesza bity liczby (funkcja końcowa generatora SplitMix64).
+ * @param[in] x : liczba
+ * @return wymieszana liczba
+ */
+static inline uint64_t HashMix(uint64_t x) {
+    x ^= x >> 30;
+    x *= UINT64_C(0xBF58476D1CE4E5B9);
+    x ^= x >> 27;
+    x *= UINT64_C(0x94D049BB133111EB);
+    return x ^ (x >> 31);
+}
+
+/**
+ * Zwraca miejsce tablicy haszującej, od którego zaczyna się szukanie wpisu.
+ * @param[in] comp : kompilator
+ * @param[in] kind : rodzaj wpisu
+ * @param[in] key : klucz wpisu
+ * @param[in] level : numer zmiennej
+ * @return indeks miejsca
+ */
+static inline size_t CacheSlot(const Compiler *comp, CacheKind kind,
+                               uint64_t key, uint32_t level) {
+    return (size_t) HashMix(key ^ ((uint64_t) kind << 32 | level))
+           & (comp->cache_size - 1);
+}
+
+/**
+ * Szuka wpisu w tablicy haszującej. Wpisy CACHE_SUBTREE porównywane są
+ * dodatkowo z poddrzewem @p p.
+ * @param[in] comp : kompilator
+ * @param[in] kind : rodzaj wpisu
+ * @param[in] key : klucz wpisu
+ * @param[in] level : numer zmiennej
+ * @param[in] p : poddrzewo wpisów CACHE_SUBTREE
+ * @return wpis lub NULL, jeśli go nie ma
+ */
+static const CacheEntry *CacheFind(const Compiler *comp, CacheKind kind,
+                                   uint64_t key, uint32_t level,
+                                   const Poly *p) {
+    size_t slot = CacheSlot(comp, kind, key, level);
+    while (comp->cache[slot].kind != CACHE_EMPTY) {
+        const CacheEntry *entry = &comp->cache[slot];
+        if (entry->kind == kind && entry->key == key && entry->level == level
+            && (kind != CACHE_SUBTREE || PolyIsEq(entry->p, p)))
+            return entry;
+        slot = (slot + 1) & (comp->cache_size - 1);
+    }
+    return NULL;
+}
+
+/**
+ * Dodaje wpis do tablicy haszującej, której nie ma w niej wpisu równego.
+ * @param[in, out] comp : kompilator
+ * @param[in] entry : wpis
+ */
+static void CacheAdd(Compiler *comp, CacheEntry entry) {
+    // Utrzymujemy zapełnienie tablicy poniżej połowy.
+    if (2 * (comp->cache_count + 1) > comp->cache_size) {
+        CacheEntry *old = comp->cache;
+        size_t old_size = comp->cache_size;
+        comp->cache_size *= 2;
+        comp->cache = SafeCalloc(comp->cache_size, sizeof(CacheEntry));
+        comp->cache_count = 0;
+        for (size_t i = 0; i < old_size; i++)
+            if (old[i].kind != CACHE_EMPTY)
+                CacheAdd(comp, old[i]);
+        free(old);
+    }
+
+    size_t slot = CacheSlot(comp, (CacheKind) entry.kind, entry.key,
+                            entry.level);
+    while (comp->cache[slot].kind != CACHE_EMPTY)
+        slot = (slot + 1) & (comp->cache_size - 1);
+    comp->cache[slot] = entry;
+    comp->cache_count++;
+}
+
+/**
+ * Zwraca wartość stałej, jeśli rejestr wirtualny jest stałą.
+ * @param[in] comp : kompilator
+ * @param[in] reg : rejestr wirtualny
+ * @param[out] value : wartość stałej
+ * @return Czy rejestr jest stałą?
+ */
+static inline bool ConstValue(const Compiler *comp, uint32_t reg,
+                              uint64_t *value) {
+    if (VregKindOf(reg) != VREG_CONST)
+        return false;
+    *value = comp->consts[VregIndex(reg)];
+    return true;
+}
+
+/**
+ * Zwraca rejestr stałej o danej wartości, tworząc go przy pierwszym użyciu.
+ * @param[in, out] comp : kompilator
+ * @param[in] value : wartość stałej
+ * @return rejestr wirtualny
+ */
+static uint32_t ConstReg(Compiler *comp, uint64_t value) {
+    const CacheEntry *entry = CacheFind(comp, CACHE_CONST, value, 0, NULL);
+    if (entry != NULL)
+        return entry->reg;
+
+    if (comp->consts_count == comp->consts_capacity) {
+        comp->consts_capacity = 2 * comp->consts_capacity + 1;
+        comp->consts = SafeRealloc(comp->consts, comp->consts_capacity
+                                                 * sizeof(uint64_t));
+    }
+    uint32_t reg = Vreg(VREG_CONST, comp->consts_count);
+    comp->consts[comp->consts_count++] = value;
+    CacheAdd(comp, (CacheEntry) {.kind = CACHE_CONST, .key = value,
+                                 .reg = reg});
+    return reg;
+}
+
+/**
+ * Dopisuje instrukcję do programu.
+ * @param[in, out] comp : kompilator
+ * @param[in] op : rodzaj instrukcji
+ * @param[in] a : rejestr pierwszego czynnika
+ * @param[in] b : rejestr drugiego czynnika
+ * @param[in] c : rejestr składnika lub 0
+ * @return rejestr wyniku instrukcji
+ */
+static uint32_t Emit(Compiler *comp, ProgOp op, uint32_t a, uint32_t b,
+                     uint32_t c) {
+    if (comp->size == comp->capacity) {
+        comp->capacity = 2 * comp->capacity + 1;
+        comp->code = SafeRealloc(comp->code, comp->capacity
+                                             * sizeof(ProgInstr));
+    }
+    uint32_t dst = Vreg(VREG_TEMP, comp->size);
+    comp->code[comp->size++] = (ProgInstr) {.op = op, .dst = dst, .a = a,
+                                            .b = b, .c = c};
+    return dst;
+}
+
+/**
+ * Dopisuje mnożenie do programu, pomijając mnożenie przez stałą 1.
+ * @param[in, out] comp : kompilator
+ * @param[in] a : rejestr pierwszego czynnika
+ * @param[in] b : rejestr drugiego czynnika
+ * @return rejestr iloczynu
+ */
+static uint32_t EmitMul(Compiler *comp, uint32_t a, uint32_t b) {
+    uint64_t value;
+    if (ConstValue(comp, a, &value) && value == 1)
+        return b;
+    if (ConstValue(comp, b, &value) && value == 1)
+        return a;
+    return Emit(comp, PROG_MUL, a, b, 0);
+}
+
+/**
+ * Zwraca rejestr potęgi zmiennej, dopisując przy pierwszym użyciu
+ * instrukcje, które ją wyliczają. Potęga parzysta jest kwadratem
+ * potęgi o połowę mniejszej, a nieparzysta iloczynem zmiennej i potęgi
+ * o jeden mniejszej, dzięki czemu potęgi tej samej zmiennej korzystają
+ * ze wspólnych pośrednich potęg.
+ * @param[in, out] comp : kompilator
+ * @param[in] level : numer zmiennej
+ * @param[in] exp : wykładnik, dodatni
+ * @return rejestr wirtualny
+ */
+static uint32_t PowerReg(Compiler *comp, uint32_t level, poly_exp_t exp) {
+    assert(exp > 0);
+    uint32_t var = Vreg(VREG_VAR, level);
+    if (exp == 1)
+        return var;
+
+    const CacheEntry *entry = CacheFind(comp, CACHE_POWER, (uint64_t) exp,
+                                        level, NULL);
+    if (entry != NULL)
+        return entry->reg;
+
+    uint32_t reg;
+    if (exp % 2 == 0) {
+        uint32_t half = PowerReg(comp, level, exp / 2);
+        reg = Emit(comp, PROG_MUL, half, half, 0);
+    }
+    else
+        reg = Emit(comp, PROG_MUL, PowerReg(comp, level, exp - 1), var, 0);
+    CacheAdd(comp, (CacheEntry) {.kind = CACHE_POWER, .key = (uint64_t) exp,
+                                 .level = level, .reg = reg});
+    return reg;
+}
+
+/**
+ * Zwraca współczynnik jako liczbę w arytmetyce programu.
+ * @param[in] comp : kompilator
+ * @param[in] p : współczynnik
+ * @return wartość współczynnika
+ */
+static uint64_t CoeffValue(const Compiler *comp, const Poly *p) {
+    uint64_t value = PolyIsBig(p) ? BigIntLowWord(p->big)
+                                  : (uint64_t) p->coeff;
+    return comp->ring == NULL ? value
+                              : ModFromSigned(comp->ring, (int64_t) value);
+}
+
+/**
+ * Kompiluje poddrzewo wielomianu, którego zmienną główną jest
+ * @f$x_{level}@f$. Poddrzewo o tej samej tablicy jednomianów lub równe
+ * poddrzewu już skompilowanemu na tym samym poziomie nie jest kompilowane
+ * ponownie.
+ * @param[in, out] comp : kompilator
+ * @param[in] p : poddrzewo
+ * @param[in] level : numer zmiennej
+ * @param[out] hash : skrót poddrzewa
+ * @return rejestr wirtualny z wartością poddrzewa
+ */
+static uint32_t CompileNode(Compiler *comp, const Poly *p, uint32_t level,
+                            uint64_t *hash) {
+    if (PolyIsCoeff(p)) {
+        uint64_t value = CoeffValue(comp, p);
+        *hash = HashMix(value);
+        return ConstReg(comp, value);
+    }
+
+    const CacheEntry *entry = CacheFind(comp, CACHE_ARRAY,
+                                        (uint64_t) (uintptr_t) p->arr, level,
+                                        NULL);
+    if (entry != NULL) {
+        *hash = entry->hash;
+        return entry->reg;
+    }
+    if (comp->vars < (size_t) level + 1)
+        comp->vars = (size_t) level + 1;
+
+    uint32_t *regs = SafeCalloc(p->size, sizeof(uint32_t));
+    uint64_t h = HashMix(p->size);
+    for (size_t i = 0; i < p->size; i++) {
+        uint64_t child;
+        regs[i] = CompileNode(comp, &p->arr[i].p, level + 1, &child);
+        h = HashMix(h ^ HashMix(child + (uint64_t) p->arr[i].exp));
+    }
+
+    uint32_t reg;
+    entry = CacheFind(comp, CACHE_SUBTREE, h, level, p);
+    if (entry != NULL)
+        reg = entry->reg;
+    else {
+        reg = regs[p->size - 1];
+        for (size_t i = p->size - 1; i-- > 0;)
+            reg = Emit(comp, PROG_MUL_ADD, reg, PowerReg(
+                    comp, level, p->arr[i + 1].exp - p->arr[i].exp), regs[i]);
+        if (p->arr[0].exp > 0)
+            reg = EmitMul(comp, reg, PowerReg(comp, level, p->arr[0].exp));
+        CacheAdd(comp, (CacheEntry) {.kind = CACHE_SUBTREE, .key = h,
+                                     .level = level, .p = p, .reg = reg});
+    }
+    CacheAdd(comp, (CacheEntry) {.kind = CACHE_ARRAY,
+                                 .key = (uint64_t) (uintptr_t) p->arr,
+                                 .hash = h, .level = level, .reg = reg});
+    free(regs);
+    *hash = h;
+    return reg;
+}
+
+/**
+ * Zamienia rejestry wirtualne instrukcji na rzeczywiste. Zmienne i stałe
+ * zajmują pierwsze rejestry, a wynik instrukcji trafia do rejestru
+ * zwolnionego przez wynik, którego nikt już potem nie czyta. Wynik
+ * instrukcji może trafić do rejestru jej argumentu, bo interpreter
+ * odczytuje argumenty przed zapisaniem wyniku.
+ * @param[in] comp : kompilator
+ * @param[in] result : rejestr wirtualny z wartością wielomianu
+ * @param[in, out] prog : program z ustalonymi @p vars i @p consts_count
+ */
+static void AllocateRegs(const Compiler *comp, uint32_t result,
+                         PolyProgram *prog) {
+    size_t fixed = prog->vars + prog->consts_count;
+    size_t *last_use = SafeCalloc(comp->size + 1, sizeof(size_t));
+    uint32_t *phys = SafeCalloc(comp->size + 1, sizeof(uint32_t));
+    uint32_t *free_regs = SafeCalloc(comp->size + 1, sizeof(uint32_t));
+    size_t free_count = 0, temps = 0;
+
+    for (size_t i = 0; i < comp->size; i++) {
+        const ProgInstr *instr = &comp->code[i];
+        uint32_t args[3] = {instr->a, instr->b, instr->c};
+        size_t argc = instr->op == PROG_MUL_ADD ? 3 : 2;
+        for (size_t k = 0; k < argc; k++)
+            if (VregKindOf(args[k]) == VREG_TEMP)
+                last_use[VregIndex(args[k])] = i;
+    }
+    if (VregKindOf(result) == VREG_TEMP)
+        last_use[VregIndex(result)] = SIZE_MAX;
+
+    prog->code = SafeCalloc(comp->size + 1, sizeof(ProgInstr));
+    prog->size = comp->size;
+    for (size_t i = 0; i < comp->size; i++) {
+        const ProgInstr *instr = &comp->code[i];
+        uint32_t args[3] = {instr->a, instr->b, instr->c}, mapped[3] = {0};
+        size_t argc = instr->op == PROG_MUL_ADD ? 3 : 2;
+        for (size_t k = 0; k < argc; k++) {
+            size_t index = VregIndex(args[k]);
+            switch (VregKindOf(args[k])) {
+                case VREG_VAR:
+                    mapped[k] = (uint32_t) index;
+                    break;
+                case VREG_CONST:
+                    mapped[k] = (uint32_t) (prog->vars + index);
+                    break;
+                case VREG_TEMP:
+                    mapped[k] = phys[index];
+                    break;
+            }
+        }
+
+        // Zwalniamy rejestry wyników czytanych po raz ostatni.
+        for (size_t k = 0; k < argc; k++)
+            if (VregKindOf(args[k]) == VREG_TEMP
+                && last_use[VregIndex(args[k])] == i
+                && (k == 0 || args[k] != args[0])
+                && (k < 2 || args[k] != args[1]))
+                free_regs[free_count++] = mapped[k];
+
+        phys[i] = free_count > 0 ? free_regs[--free_count]
+                                 : (uint32_t) (fixed + temps++);
+        prog->code[i] = (ProgInstr) {.op = instr->op, .dst = phys[i],
+                                     .a = mapped[0], .b = mapped[1],
+                                     .c = mapped[2]};
+    }
+
+    switch (VregKindOf(result)) {
+        case VREG_VAR:
+            prog->result = (uint32_t) VregIndex(result);
+            break;
+        case VREG_CONST:
+            prog->result = (uint32_t) (prog->vars + VregIndex(result));
+            break;
+        case VREG_TEMP:
+            prog->result = phys[VregIndex(result)];
+            break;
+    }
+    prog->regs = fixed + temps;
+
+    free(last_use);
+    free(phys);
+    free(free_regs);
+}
+
+PolyProgram ProgramCompile(const Poly *p) {
+    PolyProgram prog = {.ring = {.mod = 0}};
+    if (PolyGetModulus() != 0)
+        prog.ring = NewModRing((uint64_t) PolyGetModulus());
+
+    Compiler comp = {.cache = SafeCalloc(CACHE_INITIAL_SIZE,
+                                         sizeof(CacheEntry)),
+                     .cache_size = CACHE_INITIAL_SIZE,
+                     .ring = prog.ring.mod == 0 ? NULL : &prog.ring};
+    uint64_t hash;
+    uint32_t result = CompileNode(&comp, p, 0, &hash);
+
+    prog.vars = comp.vars;
+    prog.consts_count = comp.consts_count;
+    prog.consts = comp.consts;
+    AllocateRegs(&comp, result, &prog);
+
+    free(comp.code);
+    free(comp.cache);
+    return prog;
+}
+
+void ProgramDestroy(PolyProgram *prog) {
+    free(prog->consts);
+    free(prog->code);
+    *prog = (PolyProgram) {.ring = {.mod = 0}};
+}
+
+/**
+ * Wykonuje instrukcje programu modulo @f$2^{64}@f$ dla PROG_LANES wyliczeń.
+ * @param[in] prog : program
+ * @param[in, out] regs : rejestry, każdy z wartościami wszystkich wyliczeń
+ */
+static void RunLanes(const PolyProgram *prog, uint64_t (*regs)[PROG_LANES]) {
+    for (size_t i = 0; i < prog->size; i++) {
+        const ProgInstr *instr = &prog->code[i];
+        uint64_t a[PROG_LANES], b[PROG_LANES];
+        for (size_t l = 0; l < PROG_LANES; l++) {
+            a[l] = regs[instr->a][l];
+            b[l] = regs[instr->b][l];
+        }
+        if (instr->op == PROG_MUL_ADD)
+            for (size_t l = 0; l < PROG_LANES; l++)
+                regs[instr->dst][l] = a[l] * b[l] + regs[instr->c][l];
+        else
+            for (size_t l = 0; l < PROG_LANES; l++)
+                regs[instr->dst][l] = a[l] * b[l];
+    }
+}
+
+/**
+ * Wykonuje instrukcje programu modulo @p prog->ring.mod dla PROG_LANES
+ * wyliczeń.
+ * @param[in] prog : program
+ * @param[in, out] regs : rejestry, każdy z wartościami wszystkich wyliczeń
+ */
+static void RunLanesMod(const PolyProgram *prog,
+                        uint64_t (*regs)[PROG_LANES]) {
+    const ModRing *ring = &prog->ring;
+    for (size_t i = 0; i < prog->size; i++) {
+        const ProgInstr *instr = &prog->code[i];
+        uint64_t a[PROG_LANES], b[PROG_LANES];
+        for (size_t l = 0; l < PROG_LANES; l++) {
+            a[l] = regs[instr->a][l];
+            b[l] = regs[instr->b][l];
+        }
+        if (instr->op == PROG_MUL_ADD)
+            for (size_t l = 0; l < PROG_LANES; l++)
+                regs[instr->dst][l] = ModAdd(ring, ModMul(ring, a[l], b[l]),
+                                             regs[instr->c][l]);
+        else
+            for (size_t l = 0; l < PROG_LANES; l++)
+                regs[instr->dst][l] = ModMul(ring, a[l], b[l]);
+    }
+}
+
+void ProgramEval(const PolyProgram *prog, size_t count, size_t n,
+                 const poly_coeff_t values[], poly_coeff_t res[]) {
+    if (count == 0)
+        return;
+
+    uint64_t (*regs)[PROG_LANES] = SafeCalloc(prog->regs,
+                                              sizeof(uint64_t[PROG_LANES]));
+    // Instrukcje nie zapisują rejestrów stałych, więc wypełniamy je raz.
+    for (size_t k = 0; k < prog->consts_count; k++)
+        for (size_t l = 0; l < PROG_LANES; l++)
+            regs[prog->vars + k][l] = prog->consts[k];
+
+    for (size_t start = 0; start < count; start += PROG_LANES) {
+        size_t lanes = count - start < PROG_LANES ? count - start : PROG_LANES;
+        for (size_t v = 0; v < prog->vars; v++)
+            for (size_t l = 0; l < PROG_LANES; l++) {
+                poly_coeff_t x = l < lanes && v < n
+                                 ? values[(start + l) * n + v] : 0;
+                regs[v][l] = prog->ring.mod == 0
+                             ? (uint64_t) x : ModFromSigned(&prog->ring, x);
+            }
+
+        if (prog->ring.mod == 0)
+            RunLanes(prog, regs);
+        else
+            RunLanesMod(prog, regs);
+        for (size_t l = 0; l < lanes; l++)
+            res[start + l] = (poly_coeff_t) regs[prog->result][l];
+    }
+    free(regs);
+}
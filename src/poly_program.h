@@ -0,0 +1,89 @@
+/** @file
+  Biblioteka udostępniająca kompilację wielomianu do programu
+  wyliczającego jego wartość oraz wykonywanie takiego programu.
+
+  Program to ciąg instrukcji bez skoków działających na rejestrach.
+  Pierwsze rejestry przechowują wartości zmiennych @f$x_0, x_1, \ldots@f$,
+  kolejne - stałe programu, a pozostałe - wyniki pośrednie. Program
+  wylicza wartość wielomianu schematem Hornera na każdym poziomie.
+  Potęgi każdej zmiennej potrzebne w schemacie Hornera liczone są raz
+  na cały program, a każda potęga z potęg już policzonych. Powtarzające
+  się poddrzewa wielomianu (równe współczynniki przy tej samej zmiennej)
+  liczone są raz. Po kompilacji rejestry wyników pośrednich są ponownie
+  używane, gdy ich wartości nie są już potrzebne.
+
+  Interpreter wykonuje każdą instrukcję jednocześnie dla kilku
+  wyliczeń, dzięki czemu koszt odczytania instrukcji rozkłada się
+  na wiele wartości, a niezależne działania kolejnych wyliczeń
+  wykonują się równolegle w procesorze.
+
+  @author Szymon Łukasik <sl428760@mimuw.students.edu.pl>
+  @date 2021
+*/
+
+#ifndef __POLY_PROGRAM_H__
+#define __POLY_PROGRAM_H__
+
+#include <stdint.h>
+#include <stdlib.h>
+#include "poly.h"
+#include "poly_mod.h"
+
+/** Rodzaje instrukcji programu. */
+typedef enum ProgOp {
+    PROG_MUL, ///< @f$r_{dst} = r_a r_b@f$
+    PROG_MUL_ADD ///< @f$r_{dst} = r_a r_b + r_c@f$
+} ProgOp;
+
+/** To jest struktura przechowująca instrukcję programu. */
+typedef struct ProgInstr {
+    uint32_t op; ///< rodzaj instrukcji (patrz ProgOp)
+    uint32_t dst; ///< rejestr wyniku
+    uint32_t a; ///< rejestr pierwszego czynnika
+    uint32_t b; ///< rejestr drugiego czynnika
+    uint32_t c; ///< rejestr składnika instrukcji PROG_MUL_ADD
+} ProgInstr;
+
+/** To jest struktura przechowująca program wyliczający wartość
+ * wielomianu. */
+typedef struct PolyProgram {
+    size_t vars; ///< liczba zmiennych, od których zależy wielomian
+    size_t consts_count; ///< liczba stałych
+    uint64_t *consts; ///< wartości rejestrów od @p vars do @p vars + @p consts_count - 1
+    size_t regs; ///< liczba wszystkich rejestrów
+    size_t size; ///< liczba instrukcji
+    ProgInstr *code; ///< instrukcje
+    uint32_t result; ///< rejestr, w którym znajduje się wartość wielomianu
+    ModRing ring; ///< arytmetyka programu, moduł 0 oznacza @f$2^{64}@f$
+} PolyProgram;
+
+/**
+ * Kompiluje wielomian do programu wyliczającego jego wartość
+ * w bieżącym trybie współczynników (patrz PolySetModulus). W trybie
+ * dokładnym (patrz PolySetExact) program liczy modulo @f$2^{64}@f$.
+ * @param[in] p : wielomian
+ * @return program
+ */
+PolyProgram ProgramCompile(const Poly *p);
+
+/**
+ * Usuwa program z pamięci.
+ * @param[in] prog : program
+ */
+void ProgramDestroy(PolyProgram *prog);
+
+/**
+ * Wykonuje program dla @p count wyliczeń. Wyliczenie o numerze @f$j@f$
+ * podstawia pod zmienne @f$x_0, \ldots, x_{n-1}@f$ liczby
+ * @f$values[jn], \ldots, values[jn + n - 1]@f$, a pod pozostałe zmienne
+ * zera. Wynik liczony jest w arytmetyce, w której program skompilowano.
+ * @param[in] prog : program
+ * @param[in] count : liczba wyliczeń
+ * @param[in] n : liczba liczb podstawianych w każdym wyliczeniu
+ * @param[in] values : tablica długości @p count * @p n
+ * @param[out] res : tablica długości @p count na wartości wielomianu
+ */
+void ProgramEval(const PolyProgram *prog, size_t count, size_t n,
+                 const poly_coeff_t values[], poly_coeff_t res[]);
+
+#endif // __POLY_PROGRAM_H__
@@ -14,58 +14,150 @@ PolyStack NewPolyStack() {
     stack.data = NULL;
     stack.size = 0;
     stack.capacity = 0;
+    stack.ops = 0;
+    stack.low = 0;
+    stack.settled = 0;
     return stack;
 }
 
+/**
+ * Zapisuje element stosu w postaci zwartej, o ile jest on wielomianem
+ * w zwykłej postaci, który nie jest współczynnikiem i żadna jego tablica
+ * jednomianów nie jest współdzielona - postać zwarta nie zachowuje
+ * współdzielenia, więc zajęłaby wtedy więcej pamięci.
+ * Wielomiany z dużymi współczynnikami (patrz PolySetExact) pozostają
+ * w zwykłej postaci, bo postać zwarta przechowuje tylko współczynniki
+ * typu poly_coeff_t.
+ * @param[in, out] entry : element stosu
+ */
+static void EntryCompact(PolyStackEntry *entry) {
+    if (CompactIsCompact(&entry->compact) || PolyIsCoeff(&entry->poly)
+        || PolyHasSharedArrays(&entry->poly)
+        || PolyHasBigCoeffs(&entry->poly))
+        return;
+
+    CompactPoly compact = CompactFromPoly(&entry->poly);
+    PolyDestroy(&entry->poly);
+    entry->compact = compact;
+}
+
+/**
+ * Odtwarza element stosu zapisany w postaci zwartej.
+ * @param[in, out] entry : element stosu
+ */
+static void EntryExpand(PolyStackEntry *entry) {
+    if (!CompactIsCompact(&entry->compact))
+        return;
+
+    Poly poly = PolyFromCompact(&entry->compact);
+    CompactDestroy(&entry->compact);
+    entry->poly = poly;
+}
+
+/**
+ * Odnotowuje operację na stosie. Co POLY_STACK_COMPACT_DELAY operacji
+ * zapisuje w postaci zwartej wielomiany, które od poprzedniego zapisywania
+ * leżały głębiej niż POLY_STACK_EXPANDED wielomianów od wierzchołka.
+ * Ponieważ rozmiar stosu nie spadł w tym czasie poniżej @p stack->low,
+ * są to wielomiany o indeksach mniejszych niż
+ * @p stack->low - POLY_STACK_EXPANDED.
+ * @param[in, out] stack : stos wielomianów
+ */
+static void StackNoteOperation(PolyStack *stack) {
+    if (stack->size < stack->low)
+        stack->low = stack->size;
+    if (++stack->ops < POLY_STACK_COMPACT_DELAY)
+        return;
+
+    size_t end = stack->low > POLY_STACK_EXPANDED
+                 ? stack->low - POLY_STACK_EXPANDED : 0;
+    for (size_t i = stack->settled; i < end; i++)
+        EntryCompact(&stack->data[i]);
+    if (end > stack->settled)
+        stack->settled = end;
+
+    stack->ops = 0;
+    stack->low = stack->size;
+}
+
 void PolyStackPush(PolyStack *stack, Poly poly) {
     if (stack->size == stack->capacity) {
         if (stack->capacity == 0)
             stack->capacity = 1;
         else
             stack->capacity *= 2;
-        stack->data = (Poly *) SafeRealloc(stack->data,
-                                           stack->capacity * (sizeof(Poly)));
+        stack->data = (PolyStackEntry *)
+                SafeRealloc(stack->data,
+                            stack->capacity * (sizeof(PolyStackEntry)));
     }
-    stack->data[stack->size] = poly;
+    stack->data[stack->size].poly = poly;
     stack->size++;
+    StackNoteOperation(stack);
 }
 
 Poly PolyStackPop(PolyStack *stack) {
     assert(stack->size > 0);
-    Poly res = stack->data[stack->size - 1];
+    Poly res = stack->data[stack->size - 1].poly;
     stack->size--;
+    if (stack->size >= POLY_STACK_EXPANDED) {
+        size_t revealed = stack->size - POLY_STACK_EXPANDED;
+        EntryExpand(&stack->data[revealed]);
+        if (stack->settled > revealed)
+            stack->settled = revealed;
+    } else {
+        stack->settled = 0;
+    }
+    StackNoteOperation(stack);
     if (stack->size > 0 && stack->size <= (size_t) (stack->capacity / 4)) {
         stack->capacity = stack->size;
-        stack->data = (Poly *)
+        stack->data = (PolyStackEntry *)
                 SafeRealloc(stack->data,
-                            stack->size * (sizeof(Poly)));
+                            stack->size * (sizeof(PolyStackEntry)));
     }
     return res;
 }
 
 Poly *PolyStackTop(PolyStack stack) {
     assert(stack.size >= 1);
-    return &stack.data[stack.size - 1];
+    return &stack.data[stack.size - 1].poly;
 }
 
 Poly *PolysStackTop(PolyStack stack, size_t k) {
-    assert(stack.size >= k);
+    assert(stack.size >= k && k <= POLY_STACK_EXPANDED);
     Poly *polys = SafeCalloc(k, sizeof(Poly));
     for (size_t i = 1; i <= k; i++)
-        polys[k - i] = stack.data[stack.size - i];
+        polys[k - i] = stack.data[stack.size - i].poly;
     return polys;
 }
 
 Poly *PolysStackPop(PolyStack *stack, size_t k) {
-    Poly *polys = PolysStackTop(*stack, k);
-    while (k--)
-        PolyStackPop(stack);
+    assert(stack->size >= k);
+    Poly *polys = SafeCalloc(k, sizeof(Poly));
+    for (size_t i = 1; i <= k; i++)
+        polys[k - i] = PolyStackPop(stack);
     return polys;
 }
 
+void PolyStackMap(PolyStack *stack, Poly (*op)(const Poly *)) {
+    for (size_t i = 0; i < stack->size; i++) {
+        PolyStackEntry *entry = &stack->data[i];
+        bool compact = CompactIsCompact(&entry->compact);
+        EntryExpand(entry);
+        Poly mapped = op(&entry->poly);
+        PolyDestroy(&entry->poly);
+        entry->poly = mapped;
+        if (compact)
+            EntryCompact(entry);
+    }
+}
+
 void PolyStackDestroy(PolyStack stack) {
-    for (size_t i = 0; i < stack.size; i++)
-        PolyDestroy(&stack.data[i]);
+    for (size_t i = 0; i < stack.size; i++) {
+        if (CompactIsCompact(&stack.data[i].compact))
+            CompactDestroy(&stack.data[i].compact);
+        else
+            PolyDestroy(&stack.data[i].poly);
+    }
     free(stack.data);
 }
 
@@ -10,12 +10,41 @@
 
 #include <stdlib.h>
 #include "poly.h"
+#include "poly_compact.h"
+
+/**
+ * Liczba wielomianów z wierzchu stosu, które zawsze przechowywane są
+ * w zwykłej postaci. Głębiej leżące wielomiany mogą być przechowywane
+ * w postaci zwartej (patrz poly_compact.h) i są odtwarzane, gdy znajdą
+ * się bliżej wierzchołka.
+ */
+#define POLY_STACK_EXPANDED 2
+
+/**
+ * Liczba operacji na stosie, przez które wielomian musi leżeć głębiej
+ * niż POLY_STACK_EXPANDED wielomianów od wierzchołka, zanim zostanie
+ * zapisany w postaci zwartej. Dzięki temu wielomiany odkładane
+ * i zdejmowane na przemian nie są przebudowywane przy każdej operacji.
+ */
+#define POLY_STACK_COMPACT_DELAY 64
+
+/**
+ * To jest unia przechowująca element stosu - wielomian w zwykłej lub
+ * zwartej postaci. Postaci rozróżnia funkcja CompactIsCompact.
+ */
+typedef union PolyStackEntry {
+    Poly poly; ///< wielomian w zwykłej postaci
+    CompactPoly compact; ///< wielomian w postaci zwartej
+} PolyStackEntry;
 
 /** To jest struktura reprezentująca stos wielomianów. */
 typedef struct PolyStack {
-    Poly *data; ///< Tablica wielomianów znajdujących się na stosie
+    PolyStackEntry *data; ///< Tablica wielomianów znajdujących się na stosie
     size_t size; ///< Liczba obecnie znajdujących się na stosie wielomianów
     size_t capacity; ///< Liczba wielomianów dla których została zalokowana pamięć
+    size_t ops; ///< Liczba operacji od ostatniego zapisywania wielomianów w postaci zwartej
+    size_t low; ///< Najmniejszy rozmiar stosu od ostatniego zapisywania wielomianów w postaci zwartej
+    size_t settled; ///< Liczba wielomianów z dna stosu, których nie trzeba już zapisywać w postaci zwartej
 } PolyStack;
 
 /**
@@ -25,14 +54,20 @@ typedef struct PolyStack {
 PolyStack NewPolyStack();
 
 /**
- * Wstawia wielomian na wierzchołek stosu.
+ * Wstawia wielomian na wierzchołek stosu. Co POLY_STACK_COMPACT_DELAY
+ * operacji zapisuje w postaci zwartej wielomiany, które przez cały ten
+ * czas leżały głębiej niż POLY_STACK_EXPANDED wielomianów od wierzchołka,
+ * o ile żadna ich tablica jednomianów nie jest współdzielona.
  * @param[in, out]  stack : wskaźnik na stos wielomianów
  * @param[in]  poly : wielomian
  */
 void PolyStackPush(PolyStack *stack, Poly poly);
 
 /**
- * Usuwa wielomian z wierzchołka stosu oraz zwraca go.
+ * Usuwa wielomian z wierzchołka stosu oraz zwraca go. Odtwarza z postaci
+ * zwartej wielomian, który znalazł się wśród POLY_STACK_EXPANDED
+ * wielomianów z wierzchu stosu. Zapisuje wielomiany w postaci zwartej
+ * jak PolyStackPush.
  * @param[in, out]  stack : stos wielomianów z usuniętym wierzchołkiem
  * @return wielomian z wierzchołka stosu
  */
@@ -51,7 +86,8 @@ Poly *PolyStackTop(PolyStack stack);
  * Zwraca tablicę @p polys zawierającą @p k wielomianów z wierzchu stosu,
  * gdzie @p polys[k-1] to wielomian z wierzchołka,
  * @p polys[k-2] to wielomian pod wierzchołkiem, itd.
- * Zakłada, że stos zawiera co najmniej @p k wielomianów.
+ * Zakłada, że stos zawiera co najmniej @p k wielomianów oraz że @p k
+ * nie przekracza POLY_STACK_EXPANDED.
  * @param[in] stack : stos wielomianów zawierający co najmniej
  * @p k wielomianów.
  * @param[in] k : liczba wielomianów
@@ -72,6 +108,15 @@ Poly *PolysStackTop(PolyStack stack, size_t k);
  */
 Poly *PolysStackPop(PolyStack *stack, size_t k);
 
+/**
+ * Zastępuje każdy wielomian @f$p@f$ na stosie wielomianem @p op(@f$p@f$).
+ * Wielomiany w postaci zwartej są na czas działania odtwarzane, a wyniki
+ * zapisywane ponownie w postaci zwartej.
+ * @param[in, out] stack : stos wielomianów
+ * @param[in] op : przekształcenie, które nie zmienia argumentu
+ */
+void PolyStackMap(PolyStack *stack, Poly (*op)(const Poly *));
+
 /**
  * Zwalnia pamięć zaalokowaną przez stos.
  * @param[in]  stack : stos wielomianów
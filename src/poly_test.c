@@ -3,10 +3,20 @@
 #endif
 
 #include "poly.h"
+#include "poly_compact.h"
+#include "poly_packed.h"
+#include "poly_dense.h"
+#include "poly_mod.h"
+#include "poly_points.h"
+#include "poly_program.h"
+#include "poly_eq.h"
+#include "poly_stack.h"
 #include <assert.h>
+#include <stdint.h>
 #include <stdbool.h>
 #include <stdarg.h>
 #include <stdlib.h>
+#include <string.h>
 
 #define CHECK_PTR(p)  \
   do {                \
@@ -259,6 +269,9 @@ static bool SimpleDegByTest(void) {
     res &= TestDegBy(P(C(1), 1), 1, 0);
     res &= TestDegBy(POLY_P, 0, 3);
     res &= TestDegBy(POLY_P, 1, 3);
+    // Współczynnik o większym stopniu ma mniejszy stopień względem x_1.
+    res &= TestDegBy(P(P(P(C(1), 9), 1), 0, P(C(1), 3), 1), 1, 3);
+    res &= TestDegBy(P(P(P(C(1), 9), 1), 0, P(C(1), 3), 1), 2, 9);
     return res;
 }
 
@@ -310,6 +323,1034 @@ static bool OverflowTest(void) {
     return res;
 }
 
+static bool SimpleShareTest(void) {
+    bool res = true;
+    Poly p = POLY_P;
+    Poly q = PolyShare(&p);
+    res &= q.arr == p.arr;
+    res &= PolyIsEq(&p, &q);
+    Poly r = PolyNeg(&q);
+    PolyDestroy(&p);
+    // Po usunięciu oryginału kopia nadal jest poprawnym wielomianem.
+    Poly s = PolyAdd(&q, &r);
+    res &= PolyIsZero(&s);
+    res &= TestDeg(PolyShare(&q), 4);
+    PolyDestroy(&q);
+    PolyDestroy(&r);
+    return res;
+}
+
+static bool SimpleMulByCoeffTest(void) {
+    bool res = true;
+    Poly p = POLY_P;
+    Poly q = PolyMulByCoeff(&p, 2);
+    Poly r = PolyShare(&p);
+    PolyMulByCoeffInPlace(&r, 2);
+    res &= PolyIsEq(&q, &r);
+    // Zmiana w miejscu nie może zmienić współdzielonego oryginału.
+    res &= TestEq(PolyShare(&p), POLY_P, true);
+    PolyMulByCoeffInPlace(&r, INT64_MIN);
+    res &= PolyIsZero(&r);
+    res &= TestEq(PolyMulByCoeff(&p, 0), C(0), true);
+    PolyDestroy(&p);
+    PolyDestroy(&q);
+    PolyDestroy(&r);
+    return res;
+}
+
+static bool SimpleAddManyMonosTest(void) {
+    Mono *monos = calloc(1000, sizeof(Mono));
+    Poly sum = C(0);
+    for (size_t i = 0; i < 1000; i++) {
+        poly_exp_t exp = (poly_exp_t) (i * 7919 % 1000 / 3);
+        monos[i] = M(P(C(i + 1), 1), exp);
+        Poly term = P(P(C(i + 1), 1), exp);
+        Poly tmp = PolyAdd(&sum, &term);
+        PolyDestroy(&sum);
+        PolyDestroy(&term);
+        sum = tmp;
+    }
+    Poly p = PolyAddMonos(1000, monos);
+    free(monos);
+    return TestEq(p, sum, true);
+}
+
+static bool SimpleBuilderTest(void) {
+    bool res = true;
+    PolyBuilder builder = NewPolyBuilder(0);
+    Mono monos[] = {M(C(1), 1), M(C(2), 3), M(C(-1), 1), M(C(5), 0),
+                    M(P(C(1), 2), 3), M(C(0), 4)};
+    for (size_t i = 0; i < sizeof(monos) / sizeof(monos[0]); i++)
+        PolyBuilderAdd(&builder, &monos[i]);
+    res &= TestEq(PolyBuilderFinish(&builder),
+                  P(C(5), 0, P(C(2), 0, C(1), 2), 3), true);
+
+    Mono m = M(C(7), 0);
+    PolyBuilderAdd(&builder, &m);
+    res &= TestEq(PolyBuilderFinish(&builder), C(7), true);
+
+    m = M(C(1), 2);
+    PolyBuilderAdd(&builder, &m);
+    PolyBuilderDestroy(&builder);
+    return res;
+}
+
+static bool SimpleAddToTest(void) {
+    bool res = true;
+    Poly acc = C(1);
+    Poly p = C(2);
+    PolyAddTo(&acc, &p);
+    res &= TestEq(acc, C(3), true) && PolyIsZero(&p);
+
+    acc = P(C(1), 1);
+    p = C(2);
+    PolyAddTo(&acc, &p);
+    res &= TestEq(acc, P(C(2), 0, C(1), 1), true);
+
+    acc = C(-1);
+    p = P(C(1), 0, C(1), 1);
+    PolyAddTo(&acc, &p);
+    res &= TestEq(acc, P(C(1), 1), true) && PolyIsZero(&p);
+
+    acc = P(C(1), 0, C(2), 2);
+    p = P(C(1), 1, C(-2), 2, C(1), 5);
+    PolyAddTo(&acc, &p);
+    res &= TestEq(acc, P(C(1), 0, C(1), 1, C(1), 5), true);
+
+    acc = P(C(1), 1);
+    p = P(C(-1), 1);
+    PolyAddTo(&acc, &p);
+    res &= TestEq(acc, C(0), true);
+
+    // Współdzielone tablice nie mogą zostać zmienione.
+    Poly orig = POLY_P;
+    acc = PolyShare(&orig);
+    p = PolyShare(&orig);
+    PolyAddTo(&acc, &p);
+    Poly twice = PolyMulByCoeff(&orig, 2);
+    res &= TestEq(acc, twice, true);
+    res &= TestEq(orig, POLY_P, true);
+
+    acc = P(C(1), 0);
+    Poly q = P(C(1), 1);
+    PolyMulAddTo(&acc, &q, &q);
+    res &= TestEq(acc, P(C(1), 0, C(1), 2), true);
+    PolyDestroy(&q);
+    return res;
+}
+
+static bool ExpsMatch(const Poly *p) {
+    if (PolyIsCoeff(p))
+        return true;
+    const poly_exp_t *exps = PolyExps(p);
+    for (size_t i = 0; i < p->size; i++)
+        if (exps[i] != MonoGetExp(&p->arr[i]) || !ExpsMatch(&p->arr[i].p))
+            return false;
+    return true;
+}
+
+static bool TestExps(Poly p) {
+    bool res = ExpsMatch(&p);
+    PolyDestroy(&p);
+    return res;
+}
+
+static bool SimpleExpsTest(void) {
+    bool res = true;
+    Poly p = POLY_P;
+    Poly q = P(C(1), 1, P(C(2), 0, C(3), 4), 2, C(-1), 3);
+    res &= TestExps(PolyClone(&p));
+    res &= TestExps(PolyAdd(&p, &q));
+    res &= TestExps(PolySub(&p, &q));
+    res &= TestExps(PolyMul(&p, &q));
+    res &= TestExps(PolyNeg(&q));
+
+    Poly acc = PolyShare(&p);
+    Poly r = PolyClone(&q);
+    PolyAddTo(&acc, &r);
+    res &= ExpsMatch(&acc) && ExpsMatch(&p);
+    PolyMulByCoeffInPlace(&acc, 3);
+    res &= TestExps(acc);
+
+    Mono monos[] = {M(C(1), 5), M(P(C(1), 1), 2), M(C(2), 0), M(C(-1), 5)};
+    res &= TestExps(PolyAddMonos(4, monos));
+
+    PolyDestroy(&p);
+    PolyDestroy(&q);
+    return res;
+}
+
+static bool TestCompact(Poly p) {
+    CompactPoly c = CompactFromPoly(&p);
+    Poly q = PolyFromCompact(&c);
+    bool res = PolyIsEq(&p, &q) && ExpsMatch(&q)
+               && CompactIsCompact(&c) == !PolyIsCoeff(&p);
+    CompactDestroy(&c);
+    PolyDestroy(&p);
+    PolyDestroy(&q);
+    return res;
+}
+
+static bool SimpleCompactTest(void) {
+    bool res = true;
+    res &= TestCompact(C(0));
+    res &= TestCompact(C(-5));
+    res &= TestCompact(P(C(3), 7));
+    res &= TestCompact(P(P(C(2), 1), 0));
+    res &= TestCompact(P(P(C(2), 1 << 30), 1));
+    res &= TestCompact(P(P(P(C(1), 2), 3), 4));
+    res &= TestCompact(POLY_P);
+    res &= TestCompact(P(C(1), 0, P(C(-1), 0, C(2), 5), 1,
+                         P(P(C(4), 2), 1), 2147483647));
+
+    Poly p = P(C(1), 0, P(C(1), 1), 1);
+    CompactPoly c = CompactFromPoly(&p);
+    res &= CompactBytes(&c) == 2 * sizeof(CompactNode);
+    CompactDestroy(&c);
+    PolyDestroy(&p);
+    return res;
+}
+
+/* Wielomian trzech zmiennych (1 + x_0 + x_1 + x_2)^n. */
+static Poly PackedTestPoly(int n) {
+    Poly base = P(P(P(C(1), 0, C(1), 1), 0, C(1), 1), 0, C(1), 1);
+    Poly res = C(1);
+    for (int i = 0; i < n; i++) {
+        Poly tmp = PolyMul(&res, &base);
+        PolyDestroy(&res);
+        res = tmp;
+    }
+    PolyDestroy(&base);
+    return res;
+}
+
+static bool TestMulKronecker(Poly p, Poly q, Poly expected, bool kronecker) {
+    Poly res;
+    bool used = PolyMulKronecker(&p, &q, &res);
+    bool ok = used == kronecker && (!used || PolyIsEq(&res, &expected));
+    if (used)
+        PolyDestroy(&res);
+
+    Poly product = PolyMul(&p, &q);
+    ok &= PolyIsEq(&product, &expected);
+    PolyDestroy(&product);
+    PolyDestroy(&p);
+    PolyDestroy(&q);
+    PolyDestroy(&expected);
+    return ok;
+}
+
+/* Tworzy wielomian o jednomianach coeff * x^(i * step) dla i < n,
+ * a gdy triangle jest prawdą - kwadrat takiego wielomianu, którego
+ * współczynniki mnożone są przez min(k + 1, 2n - 1 - k). */
+static Poly SeriesPoly(int n, poly_exp_t step, const Poly *coeff,
+                       bool triangle) {
+    int count = triangle ? 2 * n - 1 : n;
+    PolyBuilder builder = NewPolyBuilder((size_t) count);
+    for (int k = 0; k < count; k++) {
+        int times = k + 1 < 2 * n - 1 - k ? k + 1 : 2 * n - 1 - k;
+        Poly c = C(triangle ? times : 1);
+        Poly term = PolyMul(coeff, &c);
+        Mono m = MonoFromPoly(&term, k * step);
+        PolyBuilderAdd(&builder, &m);
+    }
+    return PolyBuilderFinish(&builder);
+}
+
+static bool SimpleKroneckerTest(void) {
+    bool res = true;
+    Poly one = C(1);
+
+    // Gęsty i rzadki wielomian jednej zmiennej.
+    res &= TestMulKronecker(SeriesPoly(40, 1, &one, false),
+                            SeriesPoly(40, 1, &one, false),
+                            SeriesPoly(40, 1, &one, true), true);
+    res &= TestMulKronecker(SeriesPoly(40, 1000, &one, false),
+                            SeriesPoly(40, 1000, &one, false),
+                            SeriesPoly(40, 1000, &one, true), true);
+
+    // Wielomian dwóch zmiennych i iloczyn ze skracającymi się jednomianami.
+    Poly inner = SeriesPoly(10, 1, &one, false);
+    Poly inner_square = SeriesPoly(10, 1, &one, true);
+    res &= TestMulKronecker(SeriesPoly(10, 1, &inner, false),
+                            SeriesPoly(10, 1, &inner, false),
+                            SeriesPoly(10, 1, &inner_square, true), true);
+    Poly diff = P(P(C(-1), 1), 0, C(1), 1);
+    Poly sum = P(P(C(1), 1), 0, C(1), 1);
+    Poly base = PackedTestPoly(3);
+    Poly p = PolyMul(&base, &diff);
+    Poly q = PolyMul(&base, &sum);
+    Poly square = PackedTestPoly(6);
+    Poly squares = P(P(C(-1), 2), 0, C(1), 2);
+    Poly expected = PolyMul(&square, &squares);
+    res &= TestMulKronecker(p, q, expected, true);
+    PolyDestroy(&square);
+    PolyDestroy(&squares);
+
+    // Za mało iloczynów i przepełnienie wykładników iloczynu.
+    res &= TestMulKronecker(PolyClone(&diff), PolyClone(&sum),
+                            P(P(C(-1), 2), 0, C(1), 2), false);
+    Poly wide = SeriesPoly(8, 1 << 28, &one, false);
+    res &= !PolyMulKronecker(&wide, &wide, &expected);
+
+    // Zbyt wiele zmiennych i przepełnienie 64-bitowych kluczy.
+    Poly deep = C(1);
+    for (int i = 0; i < 17; i++)
+        deep = P(deep, 15);
+    Poly line = SeriesPoly(64, 1, &one, false);
+    expected = PolyMul(&deep, &line);
+    res &= TestMulKronecker(deep, PolyClone(&line), expected, false);
+    Poly chain = C(1);
+    for (int i = 0; i < 16; i++)
+        chain = P(chain, 15);
+    expected = PolyMul(&chain, &line);
+    res &= TestMulKronecker(chain, PolyClone(&line), expected, false);
+
+    PolyDestroy(&inner);
+    PolyDestroy(&inner_square);
+    PolyDestroy(&diff);
+    PolyDestroy(&sum);
+    PolyDestroy(&base);
+    PolyDestroy(&wide);
+    PolyDestroy(&line);
+    return res;
+}
+
+/* Sprawdza, czy mnożenie algorytmem Karatsuby, transformatą NTT
+ * i funkcją DenseMul daje ten sam wynik co mnożenie wprost. */
+static bool TestDense(size_t p_count, size_t q_count, uint64_t seed) {
+    uint64_t *p = calloc(p_count, sizeof(uint64_t));
+    uint64_t *q = calloc(q_count, sizeof(uint64_t));
+    size_t count = p_count + q_count - 1;
+    uint64_t *expected = calloc(count, sizeof(uint64_t));
+    uint64_t *res = calloc(count, sizeof(uint64_t));
+
+    // Dla ziarna 0 wszystkie współczynniki są największe możliwe.
+    uint64_t state = seed;
+    for (size_t i = 0; i < p_count + q_count; i++) {
+        state = state * 6364136223846793005u + 1442695040888963407u;
+        uint64_t value = seed == 0 ? UINT64_MAX : state;
+        if (i < p_count)
+            p[i] = value;
+        else
+            q[i - p_count] = value;
+    }
+
+    DenseMulSchoolbook(p_count, p, q_count, q, expected);
+    DenseMulKaratsuba(p_count, p, q_count, q, res);
+    bool ok = memcmp(res, expected, count * sizeof(uint64_t)) == 0;
+    DenseMulNtt(p_count, p, q_count, q, res);
+    ok &= memcmp(res, expected, count * sizeof(uint64_t)) == 0;
+    DenseMul(p_count, p, q_count, q, res);
+    ok &= memcmp(res, expected, count * sizeof(uint64_t)) == 0;
+
+    free(p);
+    free(q);
+    free(expected);
+    free(res);
+    return ok;
+}
+
+static bool SimpleDenseTest(void) {
+    bool res = true;
+    res &= TestDense(1, 1, 1);
+    res &= TestDense(5, 40, 2);
+    res &= TestDense(100, 100, 3);
+    res &= TestDense(1500, 37, 4);
+    res &= TestDense(33, 1025, 5);
+    res &= TestDense(2000, 2000, 6);
+    res &= TestDense(3000, 2500, 0);
+
+    // Gęsty iloczyn wielomianów dwóch zmiennych.
+    Poly one = C(1);
+    Poly inner = SeriesPoly(100, 1, &one, false);
+    Poly inner_square = SeriesPoly(100, 1, &one, true);
+    res &= TestMulKronecker(SeriesPoly(100, 1, &inner, false),
+                            SeriesPoly(100, 1, &inner, false),
+                            SeriesPoly(100, 1, &inner_square, true), true);
+    PolyDestroy(&inner);
+    PolyDestroy(&inner_square);
+
+    // Klucze iloczynu większe niż 2^63.
+    Poly level = SeriesPoly(4, 400000, &one, false);
+    Poly level_square = SeriesPoly(4, 400000, &one, true);
+    Poly top = SeriesPoly(4, 400000, &level, false);
+    Poly top_square = SeriesPoly(4, 400000, &level_square, true);
+    PolyDestroy(&level);
+    PolyDestroy(&level_square);
+    level = top;
+    level_square = SeriesPoly(4, 400000, &top_square, true);
+    PolyDestroy(&top_square);
+    top = SeriesPoly(4, 400000, &level, false);
+    res &= TestMulKronecker(PolyClone(&top), top, level_square, true);
+    PolyDestroy(&level);
+    return res;
+}
+
+/* Sprawdza działania modulo mod na liczbach pseudolosowych i brzegowych
+ * z wynikami dzielenia 128-bitowego. */
+static bool TestModRing(uint64_t mod) {
+    ModRing ring = NewModRing(mod);
+    bool ok = true;
+    uint64_t state = mod;
+    for (int i = 0; i < 10000; i++) {
+        state = state * 6364136223846793005u + 1442695040888963407u;
+        uint64_t a = i == 0 ? mod - 1 : state % mod;
+        uint64_t b = i == 0 ? mod - 1 : (state >> 17) % mod;
+        ok &= ModMul(&ring, a, b) == (uint64_t)
+                (((unsigned __int128) a * b) % mod);
+        ok &= ModAdd(&ring, a, b) == (a + b) % mod;
+        ok &= ModSub(&ring, a, b) == (a + mod - b) % mod;
+        uint64_t any = i == 0 ? UINT64_MAX : state;
+        ok &= ModReduce(&ring, any) == any % mod;
+    }
+    ok &= ModFromSigned(&ring, INT64_MIN)
+          == (mod - ((UINT64_C(1) << 63) % mod)) % mod;
+    ok &= ModFromSigned(&ring, -1) == mod - 1;
+    return ok;
+}
+
+/* Sprawdza, czy mnożenie wprost, transformata NTT i DenseMulMod liczą
+ * iloczyn modulo mod tak samo jak dzielenie 128-bitowe. */
+static bool TestDenseMod(size_t p_count, size_t q_count, uint64_t mod) {
+    ModRing ring = NewModRing(mod);
+    uint64_t *p = calloc(p_count, sizeof(uint64_t));
+    uint64_t *q = calloc(q_count, sizeof(uint64_t));
+    size_t count = p_count + q_count - 1;
+    uint64_t *expected = calloc(count, sizeof(uint64_t));
+    uint64_t *res = calloc(count, sizeof(uint64_t));
+
+    uint64_t state = mod;
+    for (size_t i = 0; i < p_count + q_count; i++) {
+        state = state * 6364136223846793005u + 1442695040888963407u;
+        if (i < p_count)
+            p[i] = (i & 1) ? mod - 1 : state % mod;
+        else
+            q[i - p_count] = (i & 1) ? mod - 1 : state % mod;
+    }
+    for (size_t i = 0; i < p_count; i++)
+        for (size_t j = 0; j < q_count; j++)
+            expected[i + j] = (uint64_t) ((expected[i + j]
+                    + (unsigned __int128) p[i] * q[j]) % mod);
+
+    DenseMulSchoolbookMod(p_count, p, q_count, q, &ring, res);
+    bool ok = memcmp(res, expected, count * sizeof(uint64_t)) == 0;
+    DenseMulNttMod(p_count, p, q_count, q, &ring, res);
+    ok &= memcmp(res, expected, count * sizeof(uint64_t)) == 0;
+    DenseMulMod(p_count, p, q_count, q, &ring, res);
+    ok &= memcmp(res, expected, count * sizeof(uint64_t)) == 0;
+
+    free(p);
+    free(q);
+    free(expected);
+    free(res);
+    return ok;
+}
+
+static bool SimpleModTest(void) {
+    bool res = true;
+    uint64_t mods[] = {2, 3, 7, 1000000007, (UINT64_C(1) << 61) - 1,
+                       (UINT64_C(1) << 62) - 57, (UINT64_C(1) << 62) - 1};
+    for (size_t i = 0; i < sizeof(mods) / sizeof(mods[0]); i++) {
+        res &= TestModRing(mods[i]);
+        res &= TestDenseMod(300, 200, mods[i]);
+    }
+    res &= TestDenseMod(1, 1, 5);
+
+    PolySetModulus(7);
+    res &= PolyGetModulus() == 7;
+    res &= PolyCoeffReduce(-1) == 6;
+    res &= PolyCoeffReduce(INT64_MIN) == 6;
+
+    // Współczynniki przystające do zera znikają.
+    Poly p = P(C(5), 0, C(3), 1);
+    Poly q = P(C(2), 0, C(4), 1);
+    Poly sum = PolyAdd(&p, &q);
+    res &= PolyIsCoeff(&sum) && PolyIsZero(&sum);
+    Poly neg = PolyNeg(&p);
+    res &= PolyIsEq(&neg, &q);
+
+    // (3x + 5)^2 = 2x^2 + 2x + 4 (mod 7)
+    Poly square = PolyMul(&p, &p);
+    Poly expected = P(C(4), 0, C(2), 1, C(2), 2);
+    res &= PolyIsEq(&square, &expected);
+    Poly at = PolyAt(&square, -1);
+    res &= PolyIsCoeff(&at) && at.coeff == 4;
+    Poly scaled = PolyMulByCoeff(&p, 7);
+    res &= PolyIsZero(&scaled);
+
+    // Sprowadzanie wielomianu liczonego modulo 2^64.
+    PolySetModulus(0);
+    Poly wide = P(P(C(-1), 1, C(14), 2), 0, C(8), 3);
+    PolySetModulus(7);
+    Poly reduced = PolyReduceCoeffs(&wide);
+    Poly wide_expected = P(P(C(6), 1), 0, C(1), 3);
+    res &= PolyIsEq(&reduced, &wide_expected);
+
+    // Iloczyn Kroneckera, także przez transformatę NTT.
+    PolySetModulus((INT64_C(1) << 61) - 1);
+    Poly big = C((INT64_C(1) << 61) - 2);
+    Poly one = C(1);
+    Poly series = SeriesPoly(3000, 1, &big, false);
+    Poly series_square = SeriesPoly(3000, 1, &one, true);
+    res &= TestMulKronecker(PolyClone(&series), series, series_square,
+                            true);
+    PolySetModulus(0);
+    res &= PolyGetModulus() == 0;
+
+    PolyDestroy(&p);
+    PolyDestroy(&q);
+    PolyDestroy(&sum);
+    PolyDestroy(&neg);
+    PolyDestroy(&square);
+    PolyDestroy(&expected);
+    PolyDestroy(&at);
+    PolyDestroy(&scaled);
+    PolyDestroy(&wide);
+    PolyDestroy(&reduced);
+    PolyDestroy(&wide_expected);
+    return res;
+}
+
+static bool SimpleExactTest(void) {
+    bool res = true;
+    PolySetExact(true);
+    res &= PolyGetExact() && PolyGetModulus() == 0;
+
+    /* Przepełnienie promuje współczynnik, a wynik mieszczący się w typie
+     * poly_coeff_t z powrotem go demotuje. */
+    Poly max = C(INT64_MAX);
+    Poly two = C(2);
+    Poly doubled = PolyMul(&max, &two);
+    res &= PolyIsCoeff(&doubled) && PolyIsBig(&doubled)
+           && !PolyIsZero(&doubled);
+    Poly sum = PolyAdd(&max, &max);
+    res &= PolyIsEq(&sum, &doubled);
+    Poly min_max = C(-INT64_MAX);
+    Poly back = PolyAdd(&doubled, &min_max);
+    res &= !PolyIsBig(&back) && back.coeff == INT64_MAX;
+    Poly zero = PolySub(&sum, &doubled);
+    res &= PolyIsZero(&zero);
+    Poly min = C(INT64_MIN);
+    Poly min_neg = PolyNeg(&min);
+    Poly min_back = PolyNeg(&min_neg);
+    res &= PolyIsBig(&min_neg) && PolyIsEq(&min_back, &min);
+
+    // Przypadki z OverflowTest liczone dokładnie.
+    Poly one = C(1);
+    Poly low = C(INT64_C(1) << 32);
+    Poly wide = PolyMul(&low, &low);
+    res &= PolyIsBig(&wide);
+    res &= TestMul(P(C(INT64_C(1) << 32), 1), C(INT64_C(1) << 32),
+                   P(PolyShare(&wide), 1));
+    res &= TestAt(P(C(1), 64), 2, PolyShare(&wide));
+    res &= TestAt(P(C(1), 0, C(1), 64), 2, PolyAdd(&wide, &one));
+    res &= TestAt(P(P(C(1), 1), 64), 2, P(PolyShare(&wide), 1));
+    Poly power = PolyMul(&wide, &wide);
+    res &= TestAt(P(C(1), 128), 2, PolyShare(&power));
+    res &= TestAt(P(C(-1), 128), -2, PolyNeg(&power));
+
+    // Iloczyn Kroneckera tylko wtedy, gdy współczynniki się mieszczą.
+    Poly large = C(INT64_C(1) << 40);
+    Poly large_square = PolyMul(&large, &large);
+    res &= TestMulKronecker(SeriesPoly(100, 1, &one, false),
+                            SeriesPoly(100, 1, &one, false),
+                            SeriesPoly(100, 1, &one, true), true);
+    res &= TestMulKronecker(SeriesPoly(100, 1, &large, false),
+                            SeriesPoly(100, 1, &large, false),
+                            SeriesPoly(100, 1, &large_square, true), false);
+
+    // Duże współczynniki nie trafiają do postaci zwartej.
+    Poly nested = P(P(PolyShare(&wide), 2), 1, C(3), 4);
+    res &= PolyHasBigCoeffs(&nested) && !PolyHasBigCoeffs(&large);
+
+    // Poza trybem dokładnym duże współczynniki są redukowane.
+    PolySetModulus(7);
+    res &= !PolyGetExact();
+    Poly mod_reduced = PolyReduceCoeffs(&nested);
+    Poly mod_expected = P(P(C(2), 2), 1, C(3), 4);
+    res &= PolyIsEq(&mod_reduced, &mod_expected);
+    PolySetModulus(0);
+    Poly wrap_reduced = PolyReduceCoeffs(&nested);
+    Poly wrap_expected = P(C(3), 4);
+    res &= PolyIsEq(&wrap_reduced, &wrap_expected);
+
+    PolyDestroy(&doubled);
+    PolyDestroy(&sum);
+    PolyDestroy(&back);
+    PolyDestroy(&zero);
+    PolyDestroy(&min_neg);
+    PolyDestroy(&min_back);
+    PolyDestroy(&wide);
+    PolyDestroy(&power);
+    PolyDestroy(&large_square);
+    PolyDestroy(&nested);
+    PolyDestroy(&mod_reduced);
+    PolyDestroy(&mod_expected);
+    PolyDestroy(&wrap_reduced);
+    PolyDestroy(&wrap_expected);
+    return res;
+}
+
+/* Sprawdza, czy PolyAtPoints, liczona w torach wektorów i bez nich,
+ * daje te same wartości co PolyAt w kolejnych punktach. */
+static bool TestAtPoints(Poly p, size_t count, uint64_t seed) {
+    poly_coeff_t *xs = calloc(count, sizeof(poly_coeff_t));
+    Poly *values = calloc(count, sizeof(Poly));
+    uint64_t state = seed;
+    for (size_t j = 0; j < count; j++) {
+        state = state * 6364136223846793005u + 1442695040888963407u;
+        // Co trzeci punkt jest mały, a pierwsze są brzegowe.
+        xs[j] = j % 3 == 0 ? (poly_coeff_t) (state >> 60) - 8
+                           : (poly_coeff_t) state;
+    }
+    if (count >= 3) {
+        xs[0] = 0;
+        xs[1] = -1;
+        xs[2] = INT64_MIN;
+    }
+
+    bool ok = true;
+    for (int simd = 0; simd <= 1; simd++) {
+        PointsSetSimd(simd);
+        PolyAtPoints(&p, count, xs, values);
+        for (size_t j = 0; j < count; j++) {
+            Poly expected = PolyAt(&p, xs[j]);
+            ok &= PolyIsEq(&values[j], &expected);
+            PolyDestroy(&expected);
+            PolyDestroy(&values[j]);
+        }
+    }
+    PointsSetSimd(true);
+
+    PolyDestroy(&p);
+    free(xs);
+    free(values);
+    return ok;
+}
+
+/* Tworzy wielomian jednej zmiennej o n jednomianach z pseudolosowymi
+ * współczynnikami, w którym wykładnik rośnie o 1, a co step-ty jednomian
+ * o większą liczbę. Gdy nested jest prawdą, co piąty współczynnik jest
+ * wielomianem. */
+static Poly PointsTestPoly(int n, int step, bool nested, uint64_t seed) {
+    PolyBuilder builder = NewPolyBuilder((size_t) n);
+    uint64_t state = seed;
+    poly_exp_t exp = 0;
+    for (int k = 0; k < n; k++) {
+        state = state * 6364136223846793005u + 1442695040888963407u;
+        Poly c = C(PolyCoeffReduce((poly_coeff_t) state));
+        if (nested && k % 5 == 0)
+            c = P(c, 1, C(PolyCoeffReduce(k + 1)), 3);
+        Mono m = MonoFromPoly(&c, exp);
+        PolyBuilderAdd(&builder, &m);
+        exp += k % step == 0 ? k + 2 : 1;
+    }
+    return PolyBuilderFinish(&builder);
+}
+
+static bool SimpleAtPointsTest(void) {
+    bool res = true;
+    res &= TestAtPoints(C(5), 10, 1);
+    res &= TestAtPoints(P(C(1), 0), 0, 1);
+    res &= TestAtPoints(P(C(3), 2), 1, 2);
+    res &= TestAtPoints(PointsTestPoly(200, 1000, false, 3), 37, 4);
+    res &= TestAtPoints(PointsTestPoly(200, 7, false, 5), 64, 6);
+    res &= TestAtPoints(PointsTestPoly(100, 3, true, 7), 21, 8);
+    res &= TestAtPoints(P(P(C(1), 1), 4), 19, 9);
+
+    uint64_t mods[] = {2, 1000000007, 1000000008, (UINT64_C(1) << 62) - 57};
+    for (size_t i = 0; i < sizeof(mods) / sizeof(mods[0]); i++) {
+        PolySetModulus((poly_coeff_t) mods[i]);
+        res &= TestAtPoints(PointsTestPoly(200, 7, false, 10 + i), 37, i);
+        res &= TestAtPoints(PointsTestPoly(100, 3, true, 20 + i), 21, i);
+    }
+    PolySetModulus(0);
+
+    PolySetExact(true);
+    res &= TestAtPoints(PointsTestPoly(50, 7, true, 30), 21, 31);
+    PolySetExact(false);
+    return res;
+}
+
+/* Sprawdza, czy PolyEval daje tę samą wartość co podstawianie kolejnych
+ * liczb funkcją PolyAt, a następnie zer pod pozostałe zmienne. */
+static bool TestEval(Poly p, size_t n, const poly_coeff_t values[]) {
+    Poly q = PolyClone(&p);
+    for (size_t i = 0; i < n || !PolyIsCoeff(&q); i++) {
+        Poly at = PolyAt(&q, i < n ? values[i] : 0);
+        PolyDestroy(&q);
+        q = at;
+    }
+    bool ok = PolyEval(&p, n, values) == q.coeff;
+    PolyDestroy(&p);
+    PolyDestroy(&q);
+    return ok;
+}
+
+static bool SimpleEvalTest(void) {
+    bool res = true;
+    poly_coeff_t values[300];
+    uint64_t state = 11;
+    for (size_t i = 0; i < 300; i++) {
+        state = state * 6364136223846793005u + 1442695040888963407u;
+        values[i] = i % 4 == 0 ? (poly_coeff_t) (state >> 61) - 2
+                               : (poly_coeff_t) state;
+    }
+
+    res &= TestEval(C(7), 0, values);
+    res &= TestEval(C(7), 3, values);
+    res &= TestEval(P(C(1), 0, C(2), 3), 0, values);
+    res &= TestEval(P(P(C(1), 0, C(2), 3), 0, C(5), 2), 1, values + 1);
+    res &= TestEval(PackedTestPoly(4), 3, values);
+    res &= TestEval(PackedTestPoly(4), 2, values + 5);
+    res &= TestEval(PointsTestPoly(100, 3, true, 7), 2, values);
+
+    // Podstawienie zera pod zmienną pomija jej jednomiany.
+    poly_coeff_t zeros[] = {0, 3, 0};
+    res &= TestEval(PackedTestPoly(3), 3, zeros);
+    res &= TestEval(P(C(1), 1, P(C(4), 0, C(1), 2), 5), 2, zeros);
+
+    // Wielomian o 300 poziomach przenosi ramki na stertę.
+    Poly deep = C(1);
+    for (int i = 0; i < 300; i++)
+        deep = P(C(i + 2), 0, deep, 1);
+    res &= TestEval(PolyClone(&deep), 300, values);
+    res &= TestEval(PolyClone(&deep), 100, values);
+
+    PolySetModulus(1000000007);
+    Poly reduced = PolyReduceCoeffs(&deep);
+    res &= TestEval(reduced, 300, values);
+    res &= TestEval(PolyReduceCoeffs(&deep), 0, values);
+    PolySetModulus(0);
+
+    // W trybie dokładnym wynik liczony jest modulo 2^64.
+    PolySetExact(true);
+    Poly big = C(INT64_C(1) << 62);
+    Poly huge = PolyMul(&big, &big);
+    Poly p = P(PolyClone(&huge), 0, C(3), 1);
+    poly_coeff_t two = 2;
+    res &= PolyEval(&p, 1, &two) == 6;
+    PolySetExact(false);
+
+    PolyDestroy(&deep);
+    PolyDestroy(&big);
+    PolyDestroy(&huge);
+    PolyDestroy(&p);
+    return res;
+}
+
+/* Sprawdza, czy program skompilowany z wielomianu daje w każdym
+ * z wyliczeń tę samą wartość co PolyEval. */
+static bool TestProgram(Poly p, size_t count, size_t n,
+                        const poly_coeff_t values[]) {
+    PolyProgram prog = ProgramCompile(&p);
+    poly_coeff_t res[32];
+    assert(count <= 32);
+    ProgramEval(&prog, count, n, values, res);
+
+    bool ok = true;
+    for (size_t j = 0; j < count; j++)
+        ok &= res[j] == PolyEval(&p, n, values + j * n);
+    ProgramDestroy(&prog);
+    PolyDestroy(&p);
+    return ok;
+}
+
+/* Zwraca liczbę instrukcji programu skompilowanego z wielomianu. */
+static size_t ProgramSize(Poly p) {
+    PolyProgram prog = ProgramCompile(&p);
+    size_t size = prog.size;
+    ProgramDestroy(&prog);
+    PolyDestroy(&p);
+    return size;
+}
+
+static bool SimpleProgramTest(void) {
+    bool res = true;
+    poly_coeff_t values[300];
+    uint64_t state = 13;
+    for (size_t i = 0; i < 300; i++) {
+        state = state * 6364136223846793005u + 1442695040888963407u;
+        values[i] = i % 5 == 0 ? (poly_coeff_t) (state >> 61) - 2
+                               : (poly_coeff_t) state;
+    }
+
+    res &= TestProgram(PolyZero(), 3, 0, values);
+    res &= TestProgram(C(7), 9, 2, values);
+    res &= TestProgram(P(C(1), 1), 5, 1, values);
+    res &= TestProgram(P(C(1), 0, C(2), 3), 11, 1, values);
+    res &= TestProgram(P(P(C(1), 0, C(2), 3), 0, C(5), 2), 17, 3, values);
+    res &= TestProgram(PackedTestPoly(4), 19, 4, values);
+    res &= TestProgram(PackedTestPoly(4), 8, 2, values);
+    res &= TestProgram(PointsTestPoly(100, 3, true, 7), 13, 2, values);
+    res &= TestProgram(P(C(3), 7, C(-1), 2147483647), 9, 1, values);
+
+    // Równe poddrzewa i te same potęgi liczone są raz.
+    res &= ProgramSize(P(C(1), 0, C(1), 6, C(1), 12)) == 5;
+    res &= ProgramSize(P(PackedTestPoly(3), 0, PackedTestPoly(3), 1))
+           == ProgramSize(PackedTestPoly(3)) + 1;
+
+    Poly deep = C(1);
+    for (int i = 0; i < 300; i++)
+        deep = P(C(i + 2), 0, deep, 1);
+    res &= TestProgram(PolyClone(&deep), 1, 300, values);
+
+    PolySetModulus(1000000007);
+    res &= TestProgram(PolyReduceCoeffs(&deep), 1, 300, values);
+    res &= TestProgram(PolyReduceCoeffs(&deep), 20, 15, values);
+    PolySetModulus(0);
+
+    PolyDestroy(&deep);
+    return res;
+}
+
+/* Sprawdza, czy probabilistyczne porównanie wielomianów daje ten sam
+ * wynik co PolyIsEq. */
+static bool TestEqRandom(Poly p, Poly q, unsigned error_bits) {
+    bool ok = PolyIsEqRandom(&p, &q, error_bits) == PolyIsEq(&p, &q);
+    PolyDestroy(&p);
+    PolyDestroy(&q);
+    return ok;
+}
+
+/* Tworzy wielomian o 300 poziomach i dużym stopniu. */
+static Poly DeepEqTestPoly(poly_coeff_t last) {
+    Poly deep = C(last);
+    for (int i = 0; i < 300; i++)
+        deep = P(C(i + 2), 0, deep, 2147483647 - i);
+    return deep;
+}
+
+static bool SimpleEqRandomTest(void) {
+    bool res = true;
+    PolyEqSeed(17);
+
+    res &= TestEqRandom(C(7), C(7), 64);
+    res &= TestEqRandom(C(7), C(8), 64);
+    res &= TestEqRandom(C(INT64_MIN), C(INT64_MAX), 64);
+    res &= TestEqRandom(PolyZero(), P(C(1), 1), 64);
+    res &= TestEqRandom(PackedTestPoly(4), PackedTestPoly(4), 1);
+    res &= TestEqRandom(PackedTestPoly(4), PackedTestPoly(4), 1024);
+    res &= TestEqRandom(PackedTestPoly(4), PackedTestPoly(3), 64);
+    res &= TestEqRandom(P(PackedTestPoly(3), 0, C(1), 5),
+                        P(PackedTestPoly(3), 0, C(2), 5), 64);
+    res &= TestEqRandom(DeepEqTestPoly(1), DeepEqTestPoly(1), 1024);
+    res &= TestEqRandom(DeepEqTestPoly(1), DeepEqTestPoly(-1), 1024);
+
+    // Równe wielomiany o współdzielonych i osobnych poddrzewach.
+    Poly part = PackedTestPoly(3);
+    res &= TestEqRandom(P(PolyShare(&part), 0, PolyShare(&part), 1),
+                        P(PolyClone(&part), 0, PolyClone(&part), 1), 64);
+    PolyDestroy(&part);
+
+    // Różnica współczynników podzielna przez wiele liczb pierwszych.
+    res &= TestEqRandom(P(C(1), 0, C(INT64_MAX), 1), P(C(1), 0, C(-1), 1),
+                        64);
+
+    PolySetModulus(1000000007);
+    Poly a = PackedTestPoly(5), b = PackedTestPoly(5);
+    res &= TestEqRandom(PolyReduceCoeffs(&a), PolyReduceCoeffs(&b), 64);
+    Poly one = C(1);
+    Poly c = PolyAdd(&a, &one);
+    res &= TestEqRandom(PolyReduceCoeffs(&a), PolyReduceCoeffs(&c), 64);
+    PolySetModulus(0);
+
+    PolySetExact(true);
+    Poly big = C(INT64_C(1) << 62);
+    Poly huge = PolyMul(&big, &big);
+    Poly huge_plus = PolyAdd(&huge, &one);
+    res &= TestEqRandom(P(PolyClone(&huge), 1), P(PolyClone(&huge), 1), 64);
+    res &= TestEqRandom(P(PolyClone(&huge), 1), P(PolyClone(&huge_plus), 1),
+                        64);
+
+    // Współczynniki o tysiącach bitów mogą mieć wiele dzielników pierwszych.
+    Poly giant = PolyClone(&big);
+    for (int i = 0; i < 40; i++) {
+        Poly tmp = PolyMul(&giant, &big);
+        PolyDestroy(&giant);
+        giant = tmp;
+    }
+    Poly giant_plus = PolyAdd(&giant, &one);
+    res &= TestEqRandom(P(PolyClone(&giant), 3), P(PolyClone(&giant), 3),
+                        1024);
+    res &= TestEqRandom(P(PolyClone(&giant), 3),
+                        P(PolyClone(&giant_plus), 3), 1024);
+    PolyDestroy(&giant);
+    PolyDestroy(&giant_plus);
+    PolySetExact(false);
+
+    PolyDestroy(&a);
+    PolyDestroy(&b);
+    PolyDestroy(&c);
+    PolyDestroy(&one);
+    PolyDestroy(&big);
+    PolyDestroy(&huge);
+    PolyDestroy(&huge_plus);
+    return res;
+}
+
+/**
+ * Sprawdza opis wielomianu zapamiętany przy jego tablicy jednomianów
+ * oraz zgodność skrótu z kopią wielomianu. Usuwa wielomian.
+ * @param[in] p : wielomian
+ * @param[in] deg : oczekiwany stopień
+ * @param[in] terms : oczekiwana liczba jednomianów
+ * @return Czy opis wielomianu jest poprawny?
+ */
+static bool TestMetadata(Poly p, poly_exp_t deg, size_t terms) {
+    Poly clone = PolyClone(&p);
+    bool res = PolyDeg(&p) == deg && PolyTerms(&p) == terms
+               && PolyHash(&p) == PolyHash(&clone);
+    PolyDestroy(&clone);
+    PolyDestroy(&p);
+    return res;
+}
+
+static bool SimpleMetadataTest(void) {
+    bool res = true;
+
+    res &= TestMetadata(PolyZero(), -1, 0);
+    res &= TestMetadata(C(5), 0, 1);
+    res &= TestMetadata(P(C(1), 2), 2, 1);
+    res &= TestMetadata(POLY_P, 4, 3);
+    res &= TestMetadata(P(P(C(1), 1, C(2), 7), 0, P(C(3), 2), 4), 7, 3);
+
+    // Wielomiany o tym samym kształcie i różnych współczynnikach.
+    Poly a = P(P(C(1), 1, C(2), 3), 2);
+    Poly b = P(P(C(1), 1, C(3), 3), 2);
+    res &= PolyHash(&a) != PolyHash(&b) && !PolyIsEq(&a, &b);
+    res &= PolyDegBy(&a, 1) == 3 && PolyDegBy(&a, 2) == 0
+           && PolyDegBy(&a, 100) == 0;
+
+    /* Mnożenie w miejscu nie zmienia kształtu tablicy, ale zmienia opis
+     * wielomianu. Współdzielona kopia zachowuje swój opis. */
+    Poly shared = PolyShare(&a);
+    PolyMulByCoeffInPlace(&a, 2);
+    Poly expected = P(P(C(2), 1, C(4), 3), 2);
+    res &= PolyHash(&a) == PolyHash(&expected) && PolyIsEq(&a, &expected);
+    res &= PolyHash(&a) != PolyHash(&shared) && !PolyIsEq(&a, &shared);
+    res &= PolyDeg(&a) == 5 && PolyTerms(&a) == 2;
+
+    // Liczba jednomianów rośnie wykładniczo przy współdzieleniu poddrzew.
+    Poly deep = C(1);
+    for (int i = 0; i < 80; i++) {
+        Poly next = P(PolyShare(&deep), 0, PolyShare(&deep), 1);
+        PolyDestroy(&deep);
+        deep = next;
+    }
+    res &= PolyTerms(&deep) == SIZE_MAX && PolyDeg(&deep) == 80;
+
+    // Stopnie bliskie i przekraczające zakres typu poly_exp_t.
+    res &= TestMetadata(P(P(C(1), POLY_EXP_MAX - 5), 5), POLY_EXP_MAX, 1);
+    res &= TestMetadata(P(P(C(1), 2000000000), 2000000000), POLY_EXP_MAX, 1);
+    res &= TestMetadata(P(C(1), 0, P(P(C(1), POLY_EXP_MAX), 1), POLY_EXP_MAX),
+                        POLY_EXP_MAX, 2);
+    Poly high = P(P(C(1), 2000000000), 2000000000);
+    Poly higher = P(P(C(2), 2000000000), 2000000000);
+    res &= !PolyIsEq(&high, &higher) && PolyDegBy(&high, 1) == 2000000000;
+    PolyDestroy(&high);
+    PolyDestroy(&higher);
+
+    PolyDestroy(&a);
+    PolyDestroy(&b);
+    PolyDestroy(&shared);
+    PolyDestroy(&expected);
+    PolyDestroy(&deep);
+    return res;
+}
+
+/* Czy element stosu o indeksie i jest zapisany w postaci zwartej? */
+static bool StackEntryIsCompact(PolyStack *stack, size_t i) {
+    return CompactIsCompact(&stack->data[i].compact);
+}
+
+static bool SimpleStackCompactTest(void) {
+    bool res = true;
+    PolyStack stack = NewPolyStack();
+    Poly big = PackedTestPoly(3);
+    PolyStackPush(&stack, PolyClone(&big));
+    PolyStackPush(&stack, PolyZero());
+    PolyStackPush(&stack, PolyZero());
+
+    // Wielomian tuż pod wierzchem stosu nie jest od razu przebudowywany.
+    res &= !StackEntryIsCompact(&stack, 0);
+    for (int i = 0; i < POLY_STACK_COMPACT_DELAY; i++) {
+        PolyStackPush(&stack, PolyZero());
+        Poly top = PolyStackPop(&stack);
+        PolyDestroy(&top);
+    }
+    res &= StackEntryIsCompact(&stack, 0);
+
+    for (int i = 0; i < 2; i++) {
+        Poly top = PolyStackPop(&stack);
+        PolyDestroy(&top);
+    }
+    res &= !StackEntryIsCompact(&stack, 0)
+           && PolyIsEq(PolyStackTop(stack), &big);
+
+    // Wielomian ze współdzielonym współczynnikiem nie jest przebudowywany.
+    Poly shared = P(PolyShare(&big), 0, PolyShare(&big), 1);
+    res &= PolyHasSharedArrays(&shared) && !PolyIsShared(&shared);
+    PolyStackPush(&stack, shared);
+    PolyStackPush(&stack, PolyZero());
+    PolyStackPush(&stack, PolyZero());
+    for (int i = 0; i < 2 * POLY_STACK_COMPACT_DELAY; i++) {
+        PolyStackPush(&stack, PolyZero());
+        Poly top = PolyStackPop(&stack);
+        PolyDestroy(&top);
+    }
+    res &= !StackEntryIsCompact(&stack, 1);
+
+    PolyStackDestroy(stack);
+    PolyDestroy(&big);
+    return res;
+}
+
+static bool SimpleParallelMulTest(void) {
+    bool res = true;
+    Mono *p_monos = calloc(100, sizeof(Mono));
+    Mono *q_monos = calloc(100, sizeof(Mono));
+    for (size_t i = 0; i < 100; i++) {
+        p_monos[i] = M(P(C(i + 1), 1, C(1), 2), i);
+        q_monos[i] = M(C(1L << 62), 2 * i);
+    }
+    Poly p = PolyOwnMonos(100, p_monos);
+    Poly q = PolyOwnMonos(100, q_monos);
+    Poly seq = PolyMul(&p, &q);
+    PolySetThreads(3);
+    res &= PolyGetThreads() == 3;
+    Poly par = PolyMul(&p, &q);
+    PolySetThreads(1);
+    res &= PolyGetThreads() == 1;
+    res &= PolyIsEq(&seq, &par);
+    PolyDestroy(&p);
+    PolyDestroy(&q);
+    PolyDestroy(&seq);
+    PolyDestroy(&par);
+    return res;
+}
+
+static bool SimpleParallelComposeTest(void) {
+    bool res = true;
+    Mono *monos = calloc(20, sizeof(Mono));
+    for (size_t i = 0; i < 20; i++)
+        monos[i] = M(P(C(i + 1), 0, C(1), i + 1), 3 * i);
+    Poly p = PolyOwnMonos(20, monos);
+    Poly q[2] = {P(C(1), 0, C(2), 1), P(P(C(1), 1), 0, C(-1), 2)};
+    Poly seq = PolyCompose(&p, 2, q);
+    PolySetThreads(3);
+    Poly par = PolyCompose(&p, 2, q);
+    PolySetThreads(1);
+    res &= PolyIsEq(&seq, &par);
+    PolyDestroy(&p);
+    PolyDestroy(&q[0]);
+    PolyDestroy(&q[1]);
+    PolyDestroy(&seq);
+    PolyDestroy(&par);
+    return res;
+}
+
 int main() {
     assert(SimpleAddTest());
     assert(SimpleAddMonosTest());
@@ -321,4 +1362,23 @@ int main() {
     assert(SimpleIsEqTest());
     assert(SimpleAtTest());
     assert(OverflowTest());
+    assert(SimpleShareTest());
+    assert(SimpleMulByCoeffTest());
+    assert(SimpleAddManyMonosTest());
+    assert(SimpleBuilderTest());
+    assert(SimpleAddToTest());
+    assert(SimpleExpsTest());
+    assert(SimpleCompactTest());
+    assert(SimpleKroneckerTest());
+    assert(SimpleDenseTest());
+    assert(SimpleModTest());
+    assert(SimpleExactTest());
+    assert(SimpleAtPointsTest());
+    assert(SimpleEvalTest());
+    assert(SimpleProgramTest());
+    assert(SimpleEqRandomTest());
+    assert(SimpleMetadataTest());
+    assert(SimpleStackCompactTest());
+    assert(SimpleParallelMulTest());
+    assert(SimpleParallelComposeTest());
 }
@@ -5,10 +5,69 @@
   @date 2021
 */
 
+#include <stdbool.h>
+#include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "safe_alloc.h"
 
+/** Rozmiar ziarna klas rozmiarów (w bajtach). */
+#define POOL_GRAIN 16
+
+/** Liczba małych klas rozmiarów - wielokrotności POOL_GRAIN bajtów
+ * do POOL_GRAIN * POOL_SMALL_CLASSES bajtów. */
+#define POOL_SMALL_CLASSES 32
+
+/** Liczba dużych klas rozmiarów - kolejnych potęg dwójki większych niż
+ * największa mała klasa. Bloki większe niż największa duża klasa
+ * (64 KiB) nie trafiają do puli. */
+#define POOL_LARGE_CLASSES 7
+
+/** Liczba wszystkich klas rozmiarów. */
+#define POOL_CLASSES (POOL_SMALL_CLASSES + POOL_LARGE_CLASSES)
+
+/** Maksymalna liczba wolnych bloków przechowywanych w jednej klasie. */
+#define POOL_CLASS_LIMIT 4096
+
+/** Maksymalna łączna wielkość wolnych bloków jednej dużej klasy
+ * (w bajtach). */
+#define POOL_LARGE_CLASS_BYTES (4 << 20)
+
+/** Rozmiar pierwszego fragmentu areny (w bajtach). */
+#define ARENA_FIRST_CHUNK 65536
+
+/** Wolny blok puli - pamięć bloku przechowuje wskaźnik na kolejny. */
+typedef struct FreeBlock {
+    struct FreeBlock *next; ///< następny wolny blok tej samej klasy
+} FreeBlock;
+
+/** Fragment pamięci areny, z którego wydzielane są kolejne bloki. */
+typedef struct ArenaChunk {
+    struct ArenaChunk *prev; ///< poprzednio zaalokowany fragment
+    char *begin; ///< początek obszaru przeznaczonego na bloki
+    char *end; ///< koniec obszaru przeznaczonego na bloki
+    char *next; ///< początek wolnej części obszaru
+} ArenaChunk;
+
+/** Pula bloków bieżącego wątku. */
+static _Thread_local struct {
+    FreeBlock *head[POOL_CLASSES]; ///< listy wolnych bloków klas rozmiarów
+    size_t length[POOL_CLASSES]; ///< długości list wolnych bloków
+} pool;
+
+/** Arena bieżącego wątku. */
+static _Thread_local struct {
+    bool open; ///< czy arena jest otwarta
+    ArenaChunk *last; ///< ostatnio zaalokowany fragment
+} arena;
+
+/** Liczniki alokatora bieżącego wątku. */
+static _Thread_local AllocStats stats;
+
+/** Tryb pracy alokatora. */
+static AllocMode alloc_mode = ALLOC_POOL;
+
 void *SafeRealloc(void *ptr, size_t size) {
     void *p;
     p = realloc(ptr, size);
@@ -23,4 +82,214 @@ void *SafeCalloc(size_t n, size_t size) {
     if (p == NULL)
         exit(1);
     return p;
-}
\ No newline at end of file
+}
+
+void SafeAllocSetMode(AllocMode mode) {
+    alloc_mode = mode;
+}
+
+/**
+ * Zwraca numer klasy rozmiarów, do której należy blok o rozmiarze @p size,
+ * lub POOL_CLASSES, gdy blok jest zbyt duży, by trafić do puli.
+ * @param[in] size : niezerowy rozmiar bloku (w bajtach)
+ * @return numer klasy rozmiarów
+ */
+static size_t SizeClass(size_t size) {
+    if (size <= POOL_GRAIN * POOL_SMALL_CLASSES)
+        return (size - 1) / POOL_GRAIN;
+
+    /* Duże klasy mają rozmiary 2 * POOL_GRAIN * POOL_SMALL_CLASSES,
+     * 4 * POOL_GRAIN * POOL_SMALL_CLASSES itd. */
+    size_t c = POOL_SMALL_CLASSES;
+    for (size_t limit = 2 * POOL_GRAIN * POOL_SMALL_CLASSES;
+         limit < size && c < POOL_CLASSES; limit *= 2)
+        c++;
+    return c;
+}
+
+/**
+ * Zwraca rozmiar bloków klasy rozmiarów.
+ * @param[in] c : numer klasy rozmiarów mniejszy niż POOL_CLASSES
+ * @return rozmiar bloków (w bajtach)
+ */
+static size_t ClassSize(size_t c) {
+    if (c < POOL_SMALL_CLASSES)
+        return (c + 1) * POOL_GRAIN;
+    return (size_t) POOL_GRAIN * POOL_SMALL_CLASSES
+           << (c - POOL_SMALL_CLASSES + 1);
+}
+
+/**
+ * Zwraca maksymalną liczbę wolnych bloków przechowywanych w klasie
+ * rozmiarów - duże klasy ograniczone są łączną wielkością bloków.
+ * @param[in] c : numer klasy rozmiarów mniejszy niż POOL_CLASSES
+ * @return maksymalna liczba wolnych bloków
+ */
+static size_t ClassLimit(size_t c) {
+    if (c < POOL_SMALL_CLASSES)
+        return POOL_CLASS_LIMIT;
+    return POOL_LARGE_CLASS_BYTES / ClassSize(c);
+}
+
+/**
+ * Alokuje pamięć przy użyciu funkcji malloc, a w przypadku niepowodzenia
+ * kończy działanie programu z kodem 1.
+ * @param[in] size : rozmiar bloku (w bajtach)
+ * @return wskaźnik na początek bloku
+ */
+static void *SystemAlloc(size_t size) {
+    void *p = malloc(size);
+    if (p == NULL)
+        exit(1);
+    stats.system_allocs++;
+    return p;
+}
+
+/**
+ * Sprawdza, czy blok został wydzielony z areny bieżącego wątku.
+ * @param[in] ptr : wskaźnik na blok
+ * @return Czy blok należy do areny?
+ */
+static bool ArenaOwns(const void *ptr) {
+    for (ArenaChunk *c = arena.last; c != NULL; c = c->prev)
+        if ((const char *) ptr >= c->begin && (const char *) ptr < c->end)
+            return true;
+    return false;
+}
+
+/**
+ * Wydziela z areny blok o rozmiarze @p size wyrównany do POOL_GRAIN bajtów.
+ * Gdy w ostatnim fragmencie brakuje miejsca, alokuje fragment dwukrotnie
+ * większy od poprzedniego (lub wystarczająco duży, by pomieścić blok).
+ * @param[in] size : rozmiar bloku (w bajtach)
+ * @return wskaźnik na początek bloku
+ */
+static void *ArenaAlloc(size_t size) {
+    size = (size + POOL_GRAIN - 1) / POOL_GRAIN * POOL_GRAIN;
+    ArenaChunk *c = arena.last;
+
+    if (c == NULL || (size_t) (c->end - c->next) < size) {
+        size_t capacity = c == NULL ? ARENA_FIRST_CHUNK
+                                    : 2 * (size_t) (c->end - c->begin);
+        if (capacity < size)
+            capacity = size;
+
+        size_t header = (sizeof(ArenaChunk) + POOL_GRAIN - 1)
+                        / POOL_GRAIN * POOL_GRAIN;
+        char *memory = SystemAlloc(header + capacity);
+        ArenaChunk *chunk = (ArenaChunk *) memory;
+        chunk->prev = c;
+        chunk->begin = memory + header;
+        chunk->end = chunk->begin + capacity;
+        chunk->next = chunk->begin;
+        arena.last = c = chunk;
+    }
+
+    void *p = c->next;
+    c->next += size;
+    stats.arena_allocs++;
+    return p;
+}
+
+void *SafeAlloc(size_t size) {
+    if (size == 0)
+        return NULL;
+    stats.allocs++;
+
+    if (arena.open)
+        return ArenaAlloc(size);
+
+    size_t c = SizeClass(size);
+    if (c == POOL_CLASSES)
+        return SystemAlloc(size);
+
+    if (alloc_mode == ALLOC_POOL && pool.head[c] != NULL) {
+        FreeBlock *block = pool.head[c];
+        pool.head[c] = block->next;
+        pool.length[c]--;
+        stats.pool_hits++;
+        return block;
+    }
+
+    /* Bloki z klas rozmiarów zawsze alokujemy z rozmiarem całej klasy,
+     * dzięki czemu po zmianie trybu można je umieścić w puli. */
+    return SystemAlloc(ClassSize(c));
+}
+
+void SafeFree(void *ptr, size_t size) {
+    if (ptr == NULL)
+        return;
+    stats.frees++;
+
+    if (arena.open && ArenaOwns(ptr))
+        return;
+
+    size_t c = SizeClass(size);
+    if (alloc_mode == ALLOC_POOL && c < POOL_CLASSES
+        && pool.length[c] < ClassLimit(c)) {
+        FreeBlock *block = ptr;
+        block->next = pool.head[c];
+        pool.head[c] = block;
+        pool.length[c]++;
+        return;
+    }
+
+    free(ptr);
+}
+
+void *SafeResize(void *ptr, size_t old_size, size_t new_size) {
+    if (ptr == NULL)
+        return SafeAlloc(new_size);
+    if (new_size == 0) {
+        SafeFree(ptr, old_size);
+        return NULL;
+    }
+
+    size_t old_class = SizeClass(old_size), new_class = SizeClass(new_size);
+
+    if (!arena.open) {
+        if (old_class == new_class && new_class < POOL_CLASSES)
+            return ptr;
+        if (old_class == POOL_CLASSES && new_class == POOL_CLASSES)
+            return SafeRealloc(ptr, new_size);
+    } else if (new_size <= old_size && ArenaOwns(ptr)) {
+        return ptr;
+    }
+
+    void *p = SafeAlloc(new_size);
+    memcpy(p, ptr, old_size < new_size ? old_size : new_size);
+    SafeFree(ptr, old_size);
+    return p;
+}
+
+void SafeArenaBegin(void) {
+    arena.open = true;
+}
+
+void SafeArenaEnd(void) {
+    while (arena.last != NULL) {
+        ArenaChunk *prev = arena.last->prev;
+        free(arena.last);
+        arena.last = prev;
+    }
+    arena.open = false;
+}
+
+void SafePoolTrim(void) {
+    for (size_t c = 0; c < POOL_CLASSES; c++) {
+        while (pool.head[c] != NULL) {
+            FreeBlock *next = pool.head[c]->next;
+            free(pool.head[c]);
+            pool.head[c] = next;
+        }
+        pool.length[c] = 0;
+    }
+}
+
+AllocStats SafeAllocGetStats(void) {
+    return stats;
+}
+
+void SafeAllocResetStats(void) {
+    stats = (AllocStats) {0};
+}
@@ -1,6 +1,13 @@
 /** @file
   Biblioteka służąca do bezpiecznego alokowania pamięci.
 
+  Oprócz funkcji opakowujących realloc i calloc biblioteka udostępnia
+  alokator bloków o znanym rozmiarze (SafeAlloc, SafeFree, SafeResize),
+  który w zależności od trybu korzysta bezpośrednio z malloc lub z puli
+  bloków podzielonych na klasy rozmiarów (osobnej dla każdego wątku).
+  Dodatkowo można otworzyć arenę - wtedy bloki są wydzielane z dużych
+  fragmentów pamięci, a zamknięcie areny zwalnia je wszystkie naraz.
+
   @author Szymon Łukasik <sl428760@mimuw.students.edu.pl>
   @date 2021
 */
@@ -10,6 +17,21 @@
 
 #include <stdlib.h>
 
+/** Enum określający tryb pracy alokatora bloków o znanym rozmiarze. */
+typedef enum AllocMode {
+    ALLOC_SYSTEM, ///< każdy blok alokowany i zwalniany przez malloc i free
+    ALLOC_POOL ///< bloki do 64 KiB są ponownie używane dzięki puli klas
+} AllocMode;
+
+/** Struktura przechowująca liczniki alokatora bieżącego wątku. */
+typedef struct AllocStats {
+    size_t allocs; ///< liczba żądań alokacji bloku
+    size_t frees; ///< liczba żądań zwolnienia bloku
+    size_t system_allocs; ///< liczba wywołań malloc wykonanych przez alokator
+    size_t pool_hits; ///< liczba bloków ponownie użytych z puli
+    size_t arena_allocs; ///< liczba bloków wydzielonych z areny
+} AllocStats;
+
 /**
  * Realokuje pamięć przy użyciu funkcji realloc,
  * a w przypadku niepowodzenia kończy działanie programu z kodem 1.
@@ -28,4 +50,70 @@ void *SafeRealloc(void *ptr, size_t size);
  */
 void *SafeCalloc(size_t n, size_t size);
 
-#endif // __SAFEALLOC_H__
\ No newline at end of file
+/**
+ * Ustawia tryb pracy alokatora. Bloki zaalokowane w jednym trybie
+ * można zwalniać w dowolnym innym.
+ * @param[in] mode : tryb pracy
+ */
+void SafeAllocSetMode(AllocMode mode);
+
+/**
+ * Alokuje niezainicjalizowany blok pamięci o rozmiarze @p size.
+ * Blok należy zwolnić funkcją SafeFree z tym samym rozmiarem.
+ * W przypadku niepowodzenia kończy działanie programu z kodem 1.
+ * @param[in] size : rozmiar bloku (w bajtach)
+ * @return wskaźnik na początek bloku lub NULL, gdy @p size jest równe zeru
+ */
+void *SafeAlloc(size_t size);
+
+/**
+ * Zwalnia blok zaalokowany funkcją SafeAlloc lub SafeResize.
+ * Bloki pochodzące z otwartej areny nie są zwalniane pojedynczo.
+ * @param[in] ptr : wskaźnik na blok (może być NULL)
+ * @param[in] size : rozmiar bloku podany przy jego alokacji (w bajtach)
+ */
+void SafeFree(void *ptr, size_t size);
+
+/**
+ * Zmienia rozmiar bloku zaalokowanego funkcją SafeAlloc, zachowując
+ * jego początkową zawartość. Jeśli nowy rozmiar mieści się w tej samej
+ * klasie rozmiarów, zwraca ten sam blok.
+ * @param[in] ptr : wskaźnik na blok
+ * @param[in] old_size : dotychczasowy rozmiar bloku (w bajtach)
+ * @param[in] new_size : nowy rozmiar bloku (w bajtach)
+ * @return wskaźnik na początek bloku o nowym rozmiarze
+ */
+void *SafeResize(void *ptr, size_t old_size, size_t new_size);
+
+/**
+ * Otwiera arenę w bieżącym wątku. Do jej zamknięcia wszystkie bloki
+ * alokowane funkcjami SafeAlloc i SafeResize są wydzielane z areny,
+ * a SafeFree na takich blokach nic nie robi. Areny nie są zagnieżdżane -
+ * otwarcie otwartej areny nic nie zmienia.
+ */
+void SafeArenaBegin(void);
+
+/**
+ * Zamyka arenę bieżącego wątku i zwalnia naraz wszystkie wydzielone
+ * z niej bloki. Żaden z tych bloków nie może być później używany.
+ */
+void SafeArenaEnd(void);
+
+/**
+ * Zwalnia pamięć bloków przechowywanych w puli bieżącego wątku.
+ * Powinna zostać wywołana przed zakończeniem wątku korzystającego z puli.
+ */
+void SafePoolTrim(void);
+
+/**
+ * Zwraca liczniki alokatora bieżącego wątku.
+ * @return liczniki alokatora
+ */
+AllocStats SafeAllocGetStats(void);
+
+/**
+ * Zeruje liczniki alokatora bieżącego wątku.
+ */
+void SafeAllocResetStats(void);
+
+#endif // __SAFEALLOC_H__
@@ -0,0 +1,227 @@
+/** @file
+  Implementacja biblioteki udostępniającej pulę wątków z podkradaniem zadań.
+
+  @author Szymon Łukasik <sl428760@mimuw.students.edu.pl>
+  @date 2021
+*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+
+#include "safe_alloc.h"
+#include "thread_pool.h"
+
+/**
+ * To jest struktura reprezentująca kolejkę zadań jednego wątku:
+ * przedział [head, tail) indeksów tablicy zadań bieżącego wywołania
+ * ThreadPoolRun. Właściciel pobiera zadania od końca, a pozostałe
+ * wątki podkradają je od początku.
+ */
+typedef struct TaskQueue {
+    pthread_mutex_t lock; ///< zamek chroniący kolejkę
+    size_t head; ///< indeks pierwszego zadania w kolejce
+    size_t tail; ///< indeks za ostatnim zadaniem w kolejce
+} TaskQueue;
+
+/** To jest struktura reprezentująca pulę wątków. */
+struct ThreadPool {
+    size_t size; ///< łączna liczba wątków wykonujących zadania
+    pthread_t *workers; ///< dodatkowe wątki puli
+    TaskQueue *queues; ///< kolejki zadań - kolejka 0 należy do wywołującego
+    const Task *tasks; ///< tablica zadań bieżącego wywołania ThreadPoolRun
+    atomic_size_t remaining; ///< liczba niewykonanych zadań
+    pthread_mutex_t lock; ///< zamek chroniący pola poniżej
+    pthread_cond_t work; ///< sygnalizuje nowe zadania lub zamknięcie puli
+    pthread_cond_t done; ///< sygnalizuje zakończenie pracy wątku lub zadań
+    size_t generation; ///< numer bieżącego wywołania ThreadPoolRun
+    size_t running; ///< liczba wątków przeglądających kolejki
+    bool shutdown; ///< czy pula jest zamykana
+};
+
+/** Argument funkcji wykonywanej przez dodatkowy wątek puli. */
+typedef struct WorkerArg {
+    ThreadPool *pool; ///< pula wątków
+    size_t id; ///< numer kolejki wątku
+} WorkerArg;
+
+/** Czy bieżący wątek wykonuje zadanie puli? */
+static _Thread_local bool in_task = false;
+
+bool ThreadPoolInTask(void) {
+    return in_task;
+}
+
+/**
+ * Pobiera zadanie z końca własnej kolejki wątku.
+ * @param[in, out] queue : kolejka wątku
+ * @param[out] idx : indeks pobranego zadania
+ * @return Czy udało się pobrać zadanie?
+ */
+static bool TaskQueuePopTail(TaskQueue *queue, size_t *idx) {
+    pthread_mutex_lock(&queue->lock);
+    bool found = queue->head < queue->tail;
+    if (found)
+        *idx = --queue->tail;
+    pthread_mutex_unlock(&queue->lock);
+    return found;
+}
+
+/**
+ * Podkrada zadanie z początku kolejki innego wątku.
+ * @param[in, out] queue : kolejka innego wątku
+ * @param[out] idx : indeks podkradzionego zadania
+ * @return Czy udało się podkraść zadanie?
+ */
+static bool TaskQueuePopHead(TaskQueue *queue, size_t *idx) {
+    pthread_mutex_lock(&queue->lock);
+    bool found = queue->head < queue->tail;
+    if (found)
+        *idx = queue->head++;
+    pthread_mutex_unlock(&queue->lock);
+    return found;
+}
+
+/**
+ * Wykonuje zadania z kolejki wątku @p id, a gdy ta się opróżni,
+ * podkrada zadania z kolejek pozostałych wątków, dopóki jakieś zostały.
+ * @param[in, out] pool : pula wątków
+ * @param[in] id : numer kolejki wątku
+ */
+static void ExecuteTasks(ThreadPool *pool, size_t id) {
+    size_t idx;
+
+    while (true) {
+        bool found = TaskQueuePopTail(&pool->queues[id], &idx);
+        for (size_t k = 1; !found && k < pool->size; k++)
+            found = TaskQueuePopHead(&pool->queues[(id + k) % pool->size],
+                                     &idx);
+        if (!found)
+            return;
+
+        pool->tasks[idx].run(pool->tasks[idx].arg);
+
+        if (atomic_fetch_sub(&pool->remaining, 1) == 1) {
+            pthread_mutex_lock(&pool->lock);
+            pthread_cond_broadcast(&pool->done);
+            pthread_mutex_unlock(&pool->lock);
+        }
+    }
+}
+
+/**
+ * Funkcja wykonywana przez dodatkowy wątek puli: czeka na kolejne
+ * wywołania ThreadPoolRun i bierze udział w wykonywaniu ich zadań.
+ * Przed zakończeniem zwalnia pulę bloków pamięci wątku.
+ * @param[in] data : wskaźnik na argument typu WorkerArg
+ * @return NULL
+ */
+static void *WorkerMain(void *data) {
+    WorkerArg arg = *(WorkerArg *) data;
+    ThreadPool *pool = arg.pool;
+    size_t seen = 0;
+    free(data);
+    in_task = true;
+
+    pthread_mutex_lock(&pool->lock);
+    while (true) {
+        while (!pool->shutdown && pool->generation == seen)
+            pthread_cond_wait(&pool->work, &pool->lock);
+        if (pool->shutdown)
+            break;
+
+        seen = pool->generation;
+        pool->running++;
+        pthread_mutex_unlock(&pool->lock);
+
+        ExecuteTasks(pool, arg.id);
+
+        pthread_mutex_lock(&pool->lock);
+        if (--pool->running == 0)
+            pthread_cond_broadcast(&pool->done);
+    }
+    pthread_mutex_unlock(&pool->lock);
+
+    SafePoolTrim();
+    return NULL;
+}
+
+ThreadPool *NewThreadPool(size_t threads) {
+    assert(threads > 0);
+    ThreadPool *pool = SafeCalloc(1, sizeof(ThreadPool));
+    pool->size = threads;
+    pool->queues = SafeCalloc(threads, sizeof(TaskQueue));
+    pool->workers = SafeCalloc(threads, sizeof(pthread_t));
+    atomic_init(&pool->remaining, 0);
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->work, NULL);
+    pthread_cond_init(&pool->done, NULL);
+
+    for (size_t i = 0; i < threads; i++)
+        pthread_mutex_init(&pool->queues[i].lock, NULL);
+
+    for (size_t i = 1; i < threads; i++) {
+        WorkerArg *arg = SafeCalloc(1, sizeof(WorkerArg));
+        *arg = (WorkerArg) {.pool = pool, .id = i};
+        if (pthread_create(&pool->workers[i], NULL, WorkerMain, arg) != 0)
+            exit(1);
+    }
+
+    return pool;
+}
+
+size_t ThreadPoolSize(const ThreadPool *pool) {
+    return pool->size;
+}
+
+void ThreadPoolRun(ThreadPool *pool, size_t count, const Task tasks[]) {
+    if (count == 0)
+        return;
+
+    pthread_mutex_lock(&pool->lock);
+    pool->tasks = tasks;
+    atomic_store(&pool->remaining, count);
+    for (size_t i = 0; i < pool->size; i++) {
+        TaskQueue *queue = &pool->queues[i];
+        pthread_mutex_lock(&queue->lock);
+        queue->head = i * count / pool->size;
+        queue->tail = (i + 1) * count / pool->size;
+        pthread_mutex_unlock(&queue->lock);
+    }
+    pool->generation++;
+    pthread_cond_broadcast(&pool->work);
+    pthread_mutex_unlock(&pool->lock);
+
+    in_task = true;
+    ExecuteTasks(pool, 0);
+    in_task = false;
+
+    /* Czekamy również na wątki, które wciąż przeglądają kolejki - dopiero
+     * wtedy tablica zadań przestaje być używana. */
+    pthread_mutex_lock(&pool->lock);
+    while (atomic_load(&pool->remaining) > 0 || pool->running > 0)
+        pthread_cond_wait(&pool->done, &pool->lock);
+    pthread_mutex_unlock(&pool->lock);
+}
+
+void ThreadPoolDestroy(ThreadPool *pool) {
+    pthread_mutex_lock(&pool->lock);
+    pool->shutdown = true;
+    pthread_cond_broadcast(&pool->work);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (size_t i = 1; i < pool->size; i++)
+        pthread_join(pool->workers[i], NULL);
+
+    for (size_t i = 0; i < pool->size; i++)
+        pthread_mutex_destroy(&pool->queues[i].lock);
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->work);
+    pthread_cond_destroy(&pool->done);
+    free(pool->queues);
+    free(pool->workers);
+    free(pool);
+}
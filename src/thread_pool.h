@@ -0,0 +1,69 @@
+/** @file
+  Biblioteka udostępniająca pulę wątków z podkradaniem zadań
+  (ang. work stealing).
+
+  @author Szymon Łukasik <sl428760@mimuw.students.edu.pl>
+  @date 2021
+*/
+
+#ifndef __THREAD_POOL_H__
+#define __THREAD_POOL_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * To jest struktura opisująca zadanie wykonywane przez pulę wątków:
+ * wywołanie funkcji @p run z argumentem @p arg.
+ */
+typedef struct Task {
+    void (*run)(void *arg); ///< Funkcja wykonująca zadanie
+    void *arg; ///< Argument funkcji
+} Task;
+
+/**
+ * To jest struktura reprezentująca pulę wątków. Każdy wątek ma własną
+ * kolejkę zadań - pobiera zadania z jej końca, a gdy jest pusta,
+ * podkrada je z początku kolejek pozostałych wątków.
+ */
+typedef struct ThreadPool ThreadPool;
+
+/**
+ * Tworzy pulę wątków. Wątek wywołujący ThreadPoolRun również wykonuje
+ * zadania, dlatego pula uruchamia @p threads - 1 dodatkowych wątków.
+ * @param[in] threads : łączna liczba wątków wykonujących zadania, dodatnia
+ * @return wskaźnik na pulę wątków
+ */
+ThreadPool *NewThreadPool(size_t threads);
+
+/**
+ * Zwraca łączną liczbę wątków wykonujących zadania puli.
+ * @param[in] pool : pula wątków
+ * @return liczba wątków
+ */
+size_t ThreadPoolSize(const ThreadPool *pool);
+
+/**
+ * Wykonuje zadania z tablicy @p tasks i czeka na zakończenie wszystkich.
+ * Zadania są początkowo rozdzielane między kolejki wątków w spójnych
+ * blokach. Nie można wywoływać tej funkcji jednocześnie z wielu wątków
+ * ani z wnętrza zadania.
+ * @param[in, out] pool : pula wątków
+ * @param[in] count : liczba zadań
+ * @param[in] tasks : tablica zadań
+ */
+void ThreadPoolRun(ThreadPool *pool, size_t count, const Task tasks[]);
+
+/**
+ * Sprawdza, czy bieżący wątek wykonuje właśnie zadanie puli wątków.
+ * @return Czy bieżący wątek wykonuje zadanie?
+ */
+bool ThreadPoolInTask(void);
+
+/**
+ * Kończy działanie wątków puli i zwalnia zajmowaną przez nią pamięć.
+ * @param[in] pool : pula wątków
+ */
+void ThreadPoolDestroy(ThreadPool *pool);
+
+#endif // __THREAD_POOL_H__